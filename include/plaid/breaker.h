@@ -0,0 +1,97 @@
+#ifndef PLAID_BREAKER_H_
+#define PLAID_BREAKER_H_
+
+#include "plaid/plaid.pb.h"
+#include "plaid/status.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace plaid {
+
+struct CircuitBreakerOptions {
+  // Institution failures in a row (INSTITUTION_ERROR responses, or calls
+  // that time out once sent) that open an institution's breaker.
+  int failure_threshold = 5;
+  // How long a breaker stays open before one probe call is let through.
+  // Every failed probe doubles it, up to max_open_time.
+  std::chrono::milliseconds open_time = std::chrono::seconds(30);
+  std::chrono::milliseconds max_open_time = std::chrono::minutes(10);
+  // Prime opens the breaker of an institution whose Item logins fail at the
+  // institution more often than this.
+  double error_threshold = 0.5;
+  // Access tokens whose institution is remembered at once. Past this, some
+  // are forgotten; a forgotten token's calls skip the breaker until a
+  // response carrying its Item is seen again.
+  size_t max_tokens = 1 << 16;
+};
+
+enum class BreakerState { kClosed, kOpen, kHalfOpen };
+
+// Circuit breakers per institution, shared by every call a Client makes for
+// an access token. Which institution a token belongs to is learned from the
+// Item in the responses that carry one (GetItem, GetAccounts, GetAuth, ...)
+// or from Learn. Once an institution's breaker opens, its calls fail at once
+// with an Unavailable status instead of tying up a connection until they
+// time out; after open_time a single probe goes through, and its outcome
+// closes the breaker or keeps it open for longer. Institutions that are
+// working aren't affected.
+//
+// Lookups are sharded by key, and a closed breaker is checked without
+// locking.
+class InstitutionBreakers {
+public:
+  class Breaker;
+
+  InstitutionBreakers();
+  ~InstitutionBreakers();
+
+  InstitutionBreakers(const InstitutionBreakers &) = delete;
+  InstitutionBreakers &operator=(const InstitutionBreakers &) = delete;
+
+  void SetOptions(const CircuitBreakerOptions &options);
+  CircuitBreakerOptions Options() const;
+
+  // Records that access_token's Item is at institution_id.
+  void Learn(const std::string &access_token,
+             const std::string &institution_id);
+  // Opens the institution's breaker if its status (as returned with
+  // include_optional_metadata / include_status) says Item logins are
+  // failing at the institution, and closes one it opened earlier once they
+  // aren't.
+  void Prime(const Institution &institution);
+  BreakerState State(const std::string &institution_id) const;
+
+  // Used by the client around each call for an access token: For finds the
+  // token's breaker (null if its institution isn't known yet), Admit says
+  // whether the call may go ahead (setting probe if it is the half-open
+  // probe), and Record reports how it went.
+  std::shared_ptr<Breaker> For(const std::string &access_token) const;
+  Status Admit(Breaker &breaker, bool &probe) const;
+  void Record(Breaker &breaker, const Status &status, bool probe) const;
+
+private:
+  static const int kShards = 16;
+
+  struct Shard {
+    mutable std::mutex mu;
+    std::unordered_map<std::string, std::shared_ptr<Breaker>> map;
+  };
+
+  static Shard &ShardFor(Shard *shards, const std::string &key);
+  std::shared_ptr<Breaker> Get(const std::string &institution_id);
+
+  mutable std::mutex options_mu_;
+  CircuitBreakerOptions options_;
+  // By access token, and by institution id.
+  mutable Shard tokens_[kShards];
+  mutable Shard institutions_[kShards];
+};
+
+} // namespace plaid
+
+#endif // PLAID_BREAKER_H_
\ No newline at end of file
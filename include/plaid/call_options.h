@@ -0,0 +1,101 @@
+#ifndef PLAID_CALL_OPTIONS_H_
+#define PLAID_CALL_OPTIONS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace plaid {
+
+// Cancels every call it is passed to. Copies share state, so one token can
+// be handed to a whole batch and cancelled from any thread. In-flight
+// transfers are aborted (and their connections released) right away, and
+// their callers see a Cancelled status.
+class CancellationToken {
+public:
+  CancellationToken();
+  ~CancellationToken() = default;
+
+  // A token that can never be cancelled; this is what calls get by default.
+  static CancellationToken None();
+
+  void Cancel();
+  bool IsCancelled() const;
+
+  // Runs fn on the cancelling thread when Cancel is called, or immediately
+  // if the token is already cancelled. Returns an id for Unsubscribe.
+  uint64_t Subscribe(std::function<void()> fn) const;
+  void Unsubscribe(uint64_t id) const;
+
+private:
+  struct State {
+    std::atomic<bool> cancelled;
+    std::mutex mu;
+    uint64_t next_id = 1;
+    std::vector<std::pair<uint64_t, std::function<void()>>> listeners;
+  };
+
+  explicit CancellationToken(std::shared_ptr<State> state);
+
+  std::shared_ptr<State> state_;
+};
+
+// Opt-in hedging for reads that are safe to repeat (the endpoints marked
+// idempotent in endpoints.h); other endpoints ignore it. Once a call has
+// been outstanding for longer than the given percentile of that endpoint's
+// recent latencies, a duplicate is sent, the first response wins and the
+// other transfer is cancelled.
+struct HedgingOptions {
+  bool enabled = false;
+  double percentile = 0.95;
+  // Hedges are paid for out of a client-wide budget that each eligible call
+  // tops up by this fraction, so hedging adds at most this share of extra
+  // requests on top of the calls that asked for it.
+  double max_extra_load = 0.05;
+};
+
+// How a call waits for a connection slot when the client is at its
+// concurrency limit (see concurrency.h). Waiting calls are served in
+// proportion to their class's weight: interactive calls (a user waiting on
+// the answer) go to the front, batch work (backfills, polling) fills the
+// capacity that is left, and neither starves the other.
+enum class Priority { kInteractive, kNormal, kBatch };
+
+// Per-call knobs accepted by every endpoint. The defaults bound how long a
+// stuck connection can hold a call, but set no overall deadline.
+struct CallOptions {
+  using Clock = std::chrono::steady_clock;
+
+  // The whole call, queueing included, must finish by this time.
+  Clock::time_point deadline = Clock::time_point::max();
+  std::chrono::milliseconds connect_timeout = std::chrono::seconds(10);
+  // A transfer slower than low_speed_limit bytes per second for
+  // low_speed_time is treated as hung and aborted.
+  long low_speed_limit = 1;
+  std::chrono::seconds low_speed_time = std::chrono::seconds(30);
+  CancellationToken cancel = CancellationToken::None();
+  HedgingOptions hedging;
+  Priority priority = Priority::kNormal;
+  // Within a priority class, waiting calls are shared out evenly between
+  // tenants, so one tenant's (or Item's) backlog doesn't hold up the rest.
+  // Calls without a tenant are grouped by their access token.
+  std::string tenant;
+
+  CallOptions &WithDeadline(Clock::time_point at);
+  CallOptions &WithTimeout(std::chrono::milliseconds timeout);
+  CallOptions &WithCancellation(const CancellationToken &token);
+  CallOptions &WithHedging(double percentile = 0.95,
+                           double max_extra_load = 0.05);
+  CallOptions &WithPriority(Priority p);
+  CallOptions &WithTenant(const std::string &name);
+};
+
+} // namespace plaid
+
+#endif // PLAID_CALL_OPTIONS_H_
\ No newline at end of file
@@ -1,15 +1,39 @@
 #ifndef PLAID_CLIENT_H_
 #define PLAID_CLIENT_H_
 
+#include "plaid/breaker.h"
+#include "plaid/call_options.h"
+#include "plaid/concurrency.h"
+#include "plaid/coro.h"
+#include "plaid/endpoints.h"
+#include "plaid/hedging.h"
+#include "plaid/item_errors.h"
+#include "plaid/metrics.h"
+#include "plaid/paging.h"
 #include "plaid/plaid.pb.h"
 #include "plaid/status.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace plaid {
 
+class EventLoop;
+class Request;
+class Response;
+class ThreadPool;
+class Transport;
+
+// Receives the result of an asynchronous call. Completed requests report back
+// on the client's worker pool; arguments that fail validation are reported
+// inline, before the call returns.
+template <typename T> using Callback = std::function<void(StatusWrapped<T>)>;
+
 enum class Enviroment { Sandbox, Development, Production };
 
 struct Credentials {
@@ -23,156 +47,1195 @@ struct Credentials {
   ~Credentials() = default;
 };
 
+// Which reads OnboardItem issues once the public token is exchanged.
+struct OnboardItemOptions {
+  bool auth = true;
+  bool identity = true;
+  bool balances = false;
+};
+
+// Everything OnboardItem fetched for a newly linked Item. The call as a whole
+// fails only if the exchange does; each read then succeeds or fails on its
+// own, so a failed read never loses the new access token. Reads that weren't
+// requested are left empty with an OK status.
+struct OnboardItemResult {
+  ExchangePublicTokenResponse exchange;
+  GetAccountsResponse accounts;
+  GetAuthResponse auth;
+  GetIdentityResponse identity;
+  GetBalancesResponse balances;
+  Status accounts_status = Status::OK();
+  Status auth_status = Status::OK();
+  Status identity_status = Status::OK();
+  Status balances_status = Status::OK();
+};
+
+// A Client is safe to share between any number of threads, and is meant to
+// be: concurrent calls share one event loop, one worker pool and one set of
+// connections (which several Clients can share in turn; see Transport).
+// Credentials are fixed at creation, and the remaining shared state
+// (submission queues, counters) is lock-free or sharded, so calls don't
+// serialize on a client-wide mutex.
 class Client {
 public:
   static std::unique_ptr<Client> Create(const Credentials &creds);
-  ~Client() = default;
+  // A client that sends its calls over transport, alongside the other
+  // clients using it.
+  static std::unique_ptr<Client>
+  Create(const Credentials &creds, std::shared_ptr<Transport> transport);
+  // Cancels the calls still in flight and returns once their callbacks have
+  // run.
+  ~Client();
+
+  // Requests are multiplexed on a single I/O thread, and responses are parsed
+  // on a work-stealing pool sized to the machine. Blocking calls wait on that
+  // machinery too, so many threads calling in at once don't oversubscribe the
+  // cores. Batch jobs can submit their own CPU-bound work to the same pool.
+  ThreadPool &Pool();
+  std::shared_ptr<Transport> GetTransport() const;
+  ClientMetrics Metrics() const;
+  // How the readers that page through an endpoint (GetAllTransactions,
+  // InstitutionCatalog, PaymentStream, ...) size their pages when the caller
+  // leaves the count unset, learned from this client's own calls.
+  PageSizer &PageSizerFor(EndpointId endpoint);
+  // The circuit breakers that fail calls for an access token fast while its
+  // institution is down; see breaker.h.
+  InstitutionBreakers &Breakers();
+  // Errors that left an Item unusable (ITEM_LOGIN_REQUIRED, revoked access,
+  // ...), which later data calls for its access token return without being
+  // sent; see item_errors.h. Clear a token once its Item has been repaired.
+  ItemErrorCache &ItemErrors();
+  // How many requests this client keeps in flight, adapted to the latency
+  // and rate limiting it sees; calls beyond the limit wait their turn. See
+  // concurrency.h.
+  ConcurrencyLimit &Concurrency();
 
   // Accounts
   StatusWrapped<GetBalancesResponse>
   GetBalancesWithOptions(const std::string &access_token,
-                         const GetBalancesOptions &options);
+                         const GetBalancesOptions &options,
+                         const CallOptions &call = CallOptions());
+  void GetBalancesWithOptionsAsync(const std::string &access_token,
+                                   const GetBalancesOptions &options,
+                                   Callback<GetBalancesResponse> cb,
+                                   const CallOptions &call = CallOptions());
   StatusWrapped<GetBalancesResponse>
-  GetBalances(const std::string &access_token);
+  GetBalances(const std::string &access_token,
+              const CallOptions &call = CallOptions());
+  void GetBalancesAsync(const std::string &access_token,
+                        Callback<GetBalancesResponse> cb,
+                        const CallOptions &call = CallOptions());
   StatusWrapped<GetAccountsResponse>
   GetAccountsWithOptions(const std::string &access_token,
-                         const GetAccountsOptions &options);
+                         const GetAccountsOptions &options,
+                         const CallOptions &call = CallOptions());
+  void GetAccountsWithOptionsAsync(const std::string &access_token,
+                                   const GetAccountsOptions &options,
+                                   Callback<GetAccountsResponse> cb,
+                                   const CallOptions &call = CallOptions());
   StatusWrapped<GetAccountsResponse>
-  GetAccounts(const std::string &access_token);
+  GetAccounts(const std::string &access_token,
+              const CallOptions &call = CallOptions());
+  void GetAccountsAsync(const std::string &access_token,
+                        Callback<GetAccountsResponse> cb,
+                        const CallOptions &call = CallOptions());
 
   // Assets
   StatusWrapped<GetAssetReportResponse>
-  GetAssetReport(const std::string &asset_report_token);
+  GetAssetReport(const std::string &asset_report_token,
+                 const CallOptions &call = CallOptions());
+  void GetAssetReportAsync(const std::string &asset_report_token,
+                           Callback<GetAssetReportResponse> cb,
+                           const CallOptions &call = CallOptions());
   StatusWrapped<CreateAuditCopyTokenResponse>
   CreateAuditCopy(const std::string &asset_report_token,
-                  const std::string &auditor_id);
+                  const std::string &auditor_id,
+                  const CallOptions &call = CallOptions());
+  void CreateAuditCopyAsync(const std::string &asset_report_token,
+                            const std::string &auditor_id,
+                            Callback<CreateAuditCopyTokenResponse> cb,
+                            const CallOptions &call = CallOptions());
   StatusWrapped<RemoveAssetReportResponse>
-  RemoveAssetReport(const std::string &asset_report_token);
+  RemoveAssetReport(const std::string &asset_report_token,
+                    const CallOptions &call = CallOptions());
+  void RemoveAssetReportAsync(const std::string &asset_report_token,
+                              Callback<RemoveAssetReportResponse> cb,
+                              const CallOptions &call = CallOptions());
 
   // Authentication
   StatusWrapped<GetAuthResponse>
   GetAuthWithOptions(const std::string &access_token,
-                     const GetAuthOptions &options);
-  StatusWrapped<GetAuthResponse> GetAuth(const std::string &access_token);
+                     const GetAuthOptions &options,
+                     const CallOptions &call = CallOptions());
+  void GetAuthWithOptionsAsync(const std::string &access_token,
+                               const GetAuthOptions &options,
+                               Callback<GetAuthResponse> cb,
+                               const CallOptions &call = CallOptions());
+  StatusWrapped<GetAuthResponse>
+  GetAuth(const std::string &access_token,
+          const CallOptions &call = CallOptions());
+  void GetAuthAsync(const std::string &access_token,
+                    Callback<GetAuthResponse> cb,
+                    const CallOptions &call = CallOptions());
 
   // Categories
-  StatusWrapped<GetCategoriesResponse> GetCategories();
+  StatusWrapped<GetCategoriesResponse>
+  GetCategories(const CallOptions &call = CallOptions());
+  void GetCategoriesAsync(Callback<GetCategoriesResponse> cb,
+                          const CallOptions &call = CallOptions());
 
   // Holdings
   StatusWrapped<GetHoldingsResponse>
   GetHoldingsWithOptions(const std::string &access_token,
-                         const GetHoldingsOptions &options);
+                         const GetHoldingsOptions &options,
+                         const CallOptions &call = CallOptions());
+  void GetHoldingsWithOptionsAsync(const std::string &access_token,
+                                   const GetHoldingsOptions &options,
+                                   Callback<GetHoldingsResponse> cb,
+                                   const CallOptions &call = CallOptions());
   StatusWrapped<GetHoldingsResponse>
-  GetHoldings(const std::string &access_token);
+  GetHoldings(const std::string &access_token,
+              const CallOptions &call = CallOptions());
+  void GetHoldingsAsync(const std::string &access_token,
+                        Callback<GetHoldingsResponse> cb,
+                        const CallOptions &call = CallOptions());
 
   // Identity
   StatusWrapped<GetIdentityResponse>
-  GetIdentity(const std::string &access_token);
+  GetIdentity(const std::string &access_token,
+              const CallOptions &call = CallOptions());
+  void GetIdentityAsync(const std::string &access_token,
+                        Callback<GetIdentityResponse> cb,
+                        const CallOptions &call = CallOptions());
 
   // Income
-  StatusWrapped<GetIncomeResponse> GetIncome(const std::string &access_token);
+  StatusWrapped<GetIncomeResponse>
+  GetIncome(const std::string &access_token,
+            const CallOptions &call = CallOptions());
+  void GetIncomeAsync(const std::string &access_token,
+                      Callback<GetIncomeResponse> cb,
+                      const CallOptions &call = CallOptions());
 
   // Institutions
   StatusWrapped<GetInstitutionByIDResponse>
   GetInstitutionByIDWithOptions(const std::string &id,
-                                const GetInstitutionByIDOptions &options);
+                                const GetInstitutionByIDOptions &options,
+                                const CallOptions &call = CallOptions());
+  void GetInstitutionByIDWithOptionsAsync(
+      const std::string &id, const GetInstitutionByIDOptions &options,
+      Callback<GetInstitutionByIDResponse> cb,
+      const CallOptions &call = CallOptions());
   StatusWrapped<GetInstitutionByIDResponse>
-  GetInstitutionByID(const std::string &id);
+  GetInstitutionByID(const std::string &id,
+                     const CallOptions &call = CallOptions());
+  void GetInstitutionByIDAsync(const std::string &id,
+                               Callback<GetInstitutionByIDResponse> cb,
+                               const CallOptions &call = CallOptions());
   StatusWrapped<GetInstitutionsResponse>
   GetInstitutionsWithOptions(int count, int offset,
-                             const GetInstitutionsOptions &options);
-  StatusWrapped<GetInstitutionsResponse> GetInstitutions(int count, int offset);
+                             const GetInstitutionsOptions &options,
+                             const CallOptions &call = CallOptions());
+  void GetInstitutionsWithOptionsAsync(int count, int offset,
+                                       const GetInstitutionsOptions &options,
+                                       Callback<GetInstitutionsResponse> cb,
+                                       const CallOptions &call = CallOptions());
+  StatusWrapped<GetInstitutionsResponse>
+  GetInstitutions(int count, int offset,
+                  const CallOptions &call = CallOptions());
+  void GetInstitutionsAsync(int count, int offset,
+                            Callback<GetInstitutionsResponse> cb,
+                            const CallOptions &call = CallOptions());
   StatusWrapped<SearchInstitutionsResponse>
   SearchInstitutionsWithOptions(const std::string &query,
                                 const std::vector<std::string> &products,
-                                const SearchInstitutionsOptions &options);
+                                const SearchInstitutionsOptions &options,
+                                const CallOptions &call = CallOptions());
+  void SearchInstitutionsWithOptionsAsync(
+      const std::string &query, const std::vector<std::string> &products,
+      const SearchInstitutionsOptions &options,
+      Callback<SearchInstitutionsResponse> cb,
+      const CallOptions &call = CallOptions());
   StatusWrapped<SearchInstitutionsResponse>
   SearchInstitutions(const std::string &query,
-                     const std::vector<std::string> &products);
+                     const std::vector<std::string> &products,
+                     const CallOptions &call = CallOptions());
+  void SearchInstitutionsAsync(const std::string &query,
+                               const std::vector<std::string> &products,
+                               Callback<SearchInstitutionsResponse> cb,
+                               const CallOptions &call = CallOptions());
 
   // Investment Transactions
   StatusWrapped<GetInvestmentTransactionsResponse>
   GetInvestmentTransactionsWithOptions(
       const std::string &access_token,
-      const GetInvestmentTransactionsOptions &options);
+      const GetInvestmentTransactionsOptions &options,
+      const CallOptions &call = CallOptions());
+  void GetInvestmentTransactionsWithOptionsAsync(
+      const std::string &access_token,
+      const GetInvestmentTransactionsOptions &options,
+      Callback<GetInvestmentTransactionsResponse> cb,
+      const CallOptions &call = CallOptions());
   StatusWrapped<GetInvestmentTransactionsResponse>
-  GetInvestmentTransactions(const std::string &access_token);
+  GetInvestmentTransactions(const std::string &access_token,
+                            const CallOptions &call = CallOptions());
+  void GetInvestmentTransactionsAsync(
+      const std::string &access_token,
+      Callback<GetInvestmentTransactionsResponse> cb,
+      const CallOptions &call = CallOptions());
+  // Fetches every page from options.offset on, with options.count as the
+  // page size (or one picked by PageSizerFor if unset): the first page
+  // reports the total and the rest are requested concurrently. Every page
+  // repeats the securities its transactions hold, so the merged response
+  // lists each security_id once.
+  StatusWrapped<GetInvestmentTransactionsResponse>
+  GetAllInvestmentTransactions(const std::string &access_token,
+                               const GetInvestmentTransactionsOptions &options,
+                               const CallOptions &call = CallOptions());
+  void GetAllInvestmentTransactionsAsync(
+      const std::string &access_token,
+      const GetInvestmentTransactionsOptions &options,
+      Callback<GetInvestmentTransactionsResponse> cb,
+      const CallOptions &call = CallOptions());
 
   // Items
-  StatusWrapped<GetItemResponse> GetItem(const std::string &access_token);
-  StatusWrapped<RemoveItemResponse> RemoveItem(const std::string &access_token);
+  StatusWrapped<GetItemResponse>
+  GetItem(const std::string &access_token,
+          const CallOptions &call = CallOptions());
+  void GetItemAsync(const std::string &access_token,
+                    Callback<GetItemResponse> cb,
+                    const CallOptions &call = CallOptions());
+  StatusWrapped<RemoveItemResponse>
+  RemoveItem(const std::string &access_token,
+             const CallOptions &call = CallOptions());
+  void RemoveItemAsync(const std::string &access_token,
+                       Callback<RemoveItemResponse> cb,
+                       const CallOptions &call = CallOptions());
   StatusWrapped<UpdateItemWebhookResponse>
-  UpdateItemWebhook(const std::string &access_token,
-                    const std::string &webhook);
+  UpdateItemWebhook(const std::string &access_token, const std::string &webhook,
+                    const CallOptions &call = CallOptions());
+  void UpdateItemWebhookAsync(const std::string &access_token,
+                              const std::string &webhook,
+                              Callback<UpdateItemWebhookResponse> cb,
+                              const CallOptions &call = CallOptions());
   StatusWrapped<InvalidateAccessTokenResponse>
-  InvalidateAccessToken(const std::string &access_token);
+  InvalidateAccessToken(const std::string &access_token,
+                        const CallOptions &call = CallOptions());
+  void InvalidateAccessTokenAsync(const std::string &access_token,
+                                  Callback<InvalidateAccessTokenResponse> cb,
+                                  const CallOptions &call = CallOptions());
   StatusWrapped<UpdateAccessTokenVersionResponse>
-  UpdateAccessTokenVersion(const std::string &access_token);
+  UpdateAccessTokenVersion(const std::string &access_token,
+                           const CallOptions &call = CallOptions());
+  void UpdateAccessTokenVersionAsync(
+      const std::string &access_token,
+      Callback<UpdateAccessTokenVersionResponse> cb,
+      const CallOptions &call = CallOptions());
   StatusWrapped<CreatePublicTokenResponse>
-  CreatePublicToken(const std::string &access_token);
+  CreatePublicToken(const std::string &access_token,
+                    const CallOptions &call = CallOptions());
+  void CreatePublicTokenAsync(const std::string &access_token,
+                              Callback<CreatePublicTokenResponse> cb,
+                              const CallOptions &call = CallOptions());
   StatusWrapped<ExchangePublicTokenResponse>
-  ExchangePublicToken(const std::string &public_token);
+  ExchangePublicToken(const std::string &public_token,
+                      const CallOptions &call = CallOptions());
+  void ExchangePublicTokenAsync(const std::string &public_token,
+                                Callback<ExchangePublicTokenResponse> cb,
+                                const CallOptions &call = CallOptions());
 
   // Liabilities
   StatusWrapped<GetLiabilitiesResponse>
   GetLiabilitiesWithOptions(const std::string &access_token,
-                            const GetLiabilitiesOptions &options);
+                            const GetLiabilitiesOptions &options,
+                            const CallOptions &call = CallOptions());
+  void GetLiabilitiesWithOptionsAsync(const std::string &access_token,
+                                      const GetLiabilitiesOptions &options,
+                                      Callback<GetLiabilitiesResponse> cb,
+                                      const CallOptions &call = CallOptions());
   StatusWrapped<GetLiabilitiesResponse>
-  GetLiabilities(const std::string &access_token);
+  GetLiabilities(const std::string &access_token,
+                 const CallOptions &call = CallOptions());
+  void GetLiabilitiesAsync(const std::string &access_token,
+                           Callback<GetLiabilitiesResponse> cb,
+                           const CallOptions &call = CallOptions());
 
   // Payments
   StatusWrapped<CreatePaymentRecipientResponse>
   CreatePaymentRecipient(const std::string &name, const std::string &iban,
-                         const PaymentRecipientAddress &address);
+                         const PaymentRecipientAddress &address,
+                         const CallOptions &call = CallOptions());
+  void CreatePaymentRecipientAsync(const std::string &name,
+                                   const std::string &iban,
+                                   const PaymentRecipientAddress &address,
+                                   Callback<CreatePaymentRecipientResponse> cb,
+                                   const CallOptions &call = CallOptions());
   StatusWrapped<GetPaymentRecipientResponse>
-  GetPaymentRecipient(const std::string &recipient_id);
-  StatusWrapped<ListPaymentRecipientsResponse> ListPaymentRecipients();
+  GetPaymentRecipient(const std::string &recipient_id,
+                      const CallOptions &call = CallOptions());
+  void GetPaymentRecipientAsync(const std::string &recipient_id,
+                                Callback<GetPaymentRecipientResponse> cb,
+                                const CallOptions &call = CallOptions());
+  StatusWrapped<ListPaymentRecipientsResponse>
+  ListPaymentRecipients(const CallOptions &call = CallOptions());
+  void ListPaymentRecipientsAsync(Callback<ListPaymentRecipientsResponse> cb,
+                                  const CallOptions &call = CallOptions());
   StatusWrapped<CreatePaymentResponse>
   CreatePayment(const std::string &recipient_id, const std::string &reference,
-                const PaymentAmount &amount);
+                const PaymentAmount &amount,
+                const CallOptions &call = CallOptions());
+  void CreatePaymentAsync(const std::string &recipient_id,
+                          const std::string &reference,
+                          const PaymentAmount &amount,
+                          Callback<CreatePaymentResponse> cb,
+                          const CallOptions &call = CallOptions());
   StatusWrapped<CreatePaymentTokenResponse>
-  CreatePaymentToken(const std::string &payment_id);
-  StatusWrapped<GetPaymentResponse> GetPayment(const std::string &payment_id);
+  CreatePaymentToken(const std::string &payment_id,
+                     const CallOptions &call = CallOptions());
+  void CreatePaymentTokenAsync(const std::string &payment_id,
+                               Callback<CreatePaymentTokenResponse> cb,
+                               const CallOptions &call = CallOptions());
+  StatusWrapped<GetPaymentResponse>
+  GetPayment(const std::string &payment_id,
+             const CallOptions &call = CallOptions());
+  void GetPaymentAsync(const std::string &payment_id,
+                       Callback<GetPaymentResponse> cb,
+                       const CallOptions &call = CallOptions());
   StatusWrapped<ListPaymentsResponse>
-  ListPayments(const ListPaymentsOptions &options);
+  ListPayments(const ListPaymentsOptions &options,
+               const CallOptions &call = CallOptions());
+  void ListPaymentsAsync(const ListPaymentsOptions &options,
+                         Callback<ListPaymentsResponse> cb,
+                         const CallOptions &call = CallOptions());
 
   // Processors
   StatusWrapped<CreateProcessorTokenResponse>
   CreateApexToken(const std::string &access_token,
-                  const std::string &account_id);
+                  const std::string &account_id,
+                  const CallOptions &call = CallOptions());
+  void CreateApexTokenAsync(const std::string &access_token,
+                            const std::string &account_id,
+                            Callback<CreateProcessorTokenResponse> cb,
+                            const CallOptions &call = CallOptions());
   StatusWrapped<CreateProcessorTokenResponse>
   CreateDwollaToken(const std::string &access_token,
-                    const std::string &account_id);
+                    const std::string &account_id,
+                    const CallOptions &call = CallOptions());
+  void CreateDwollaTokenAsync(const std::string &access_token,
+                              const std::string &account_id,
+                              Callback<CreateProcessorTokenResponse> cb,
+                              const CallOptions &call = CallOptions());
   StatusWrapped<CreateProcessorTokenResponse>
   CreateOcrolusToken(const std::string &access_token,
-                     const std::string &account_id);
+                     const std::string &account_id,
+                     const CallOptions &call = CallOptions());
+  void CreateOcrolusTokenAsync(const std::string &access_token,
+                               const std::string &account_id,
+                               Callback<CreateProcessorTokenResponse> cb,
+                               const CallOptions &call = CallOptions());
   StatusWrapped<CreateStripeTokenResponse>
   CreateStripeToken(const std::string &access_token,
-                    const std::string &account_id);
+                    const std::string &account_id,
+                    const CallOptions &call = CallOptions());
+  void CreateStripeTokenAsync(const std::string &access_token,
+                              const std::string &account_id,
+                              Callback<CreateStripeTokenResponse> cb,
+                              const CallOptions &call = CallOptions());
 
   // Sandbox
   StatusWrapped<CreateSandboxPublicTokenResponse>
   CreateSandboxPublicToken(const std::string &institution_id,
-                           const std::vector<std::string> &initial_products);
+                           const std::vector<std::string> &initial_products,
+                           const CallOptions &call = CallOptions());
+  void CreateSandboxPublicTokenAsync(
+      const std::string &institution_id,
+      const std::vector<std::string> &initial_products,
+      Callback<CreateSandboxPublicTokenResponse> cb,
+      const CallOptions &call = CallOptions());
   StatusWrapped<ResetSandboxItemResponse>
-  ResetSandboxItem(const std::string &access_token);
+  ResetSandboxItem(const std::string &access_token,
+                   const CallOptions &call = CallOptions());
+  void ResetSandboxItemAsync(const std::string &access_token,
+                             Callback<ResetSandboxItemResponse> cb,
+                             const CallOptions &call = CallOptions());
 
   // Transactions
   StatusWrapped<GetTransactionsResponse>
   GetTransactionsWithOptions(const std::string &access_token,
-                             const GetTransactionsOptions &options);
+                             const GetTransactionsOptions &options,
+                             const CallOptions &call = CallOptions());
+  void GetTransactionsWithOptionsAsync(const std::string &access_token,
+                                       const GetTransactionsOptions &options,
+                                       Callback<GetTransactionsResponse> cb,
+                                       const CallOptions &call = CallOptions());
   StatusWrapped<GetTransactionsResponse>
   GetTransactions(const std::string &access_token,
-                  const std::string &start_date, const std::string &end_date);
+                  const std::string &start_date, const std::string &end_date,
+                  const CallOptions &call = CallOptions());
+  void GetTransactionsAsync(const std::string &access_token,
+                            const std::string &start_date,
+                            const std::string &end_date,
+                            Callback<GetTransactionsResponse> cb,
+                            const CallOptions &call = CallOptions());
+  // Fetches every transaction between options.start_date and end_date, with
+  // options.count as the page size (or one picked by PageSizerFor if unset;
+  // offset is ignored). After
+  // a first page gives the total and the newest transactions, the rest of
+  // the range is split into date windows expected to hold about a page
+  // each, which are read concurrently (and paged through should one hold
+  // more), then merged newest first with each transaction_id listed once.
+  StatusWrapped<GetTransactionsResponse>
+  GetAllTransactions(const std::string &access_token,
+                     const GetTransactionsOptions &options,
+                     const CallOptions &call = CallOptions());
+  void GetAllTransactionsAsync(const std::string &access_token,
+                               const GetTransactionsOptions &options,
+                               Callback<GetTransactionsResponse> cb,
+                               const CallOptions &call = CallOptions());
+
+  // Webhooks
+  // Fetches the public key Plaid signed webhooks with, by the key id in the
+  // Plaid-Verification header. See WebhookVerifier, which caches these.
+  StatusWrapped<GetWebhookVerificationKeyResponse>
+  GetWebhookVerificationKey(const std::string &key_id,
+                            const CallOptions &call = CallOptions());
+  void GetWebhookVerificationKeyAsync(
+      const std::string &key_id, Callback<GetWebhookVerificationKeyResponse> cb,
+      const CallOptions &call = CallOptions());
+
+  // Onboarding
+  // Exchanges a public token, then fetches accounts (and auth, identity and
+  // balances, per options) for the new Item concurrently, so linking an Item
+  // costs about two round trips instead of one per call.
+  StatusWrapped<OnboardItemResult>
+  OnboardItem(const std::string &public_token,
+              const OnboardItemOptions &options = OnboardItemOptions(),
+              const CallOptions &call = CallOptions());
+  void OnboardItemAsync(const std::string &public_token,
+                        const OnboardItemOptions &options,
+                        Callback<OnboardItemResult> cb,
+                        const CallOptions &call = CallOptions());
+
+#ifdef PLAID_HAS_COROUTINES
+  // Awaitable versions of every endpoint, for C++20 coroutines:
+  //   auto accounts = co_await client->GetAccountsCo(access_token);
+  // Arguments are copied, so temporaries are safe to pass.
+  Awaitable<GetBalancesResponse>
+  GetBalancesWithOptionsCo(const std::string &access_token,
+                           const GetBalancesOptions &options,
+                           const CallOptions &call = CallOptions());
+  Awaitable<GetBalancesResponse>
+  GetBalancesCo(const std::string &access_token,
+                const CallOptions &call = CallOptions());
+  Awaitable<GetAccountsResponse>
+  GetAccountsWithOptionsCo(const std::string &access_token,
+                           const GetAccountsOptions &options,
+                           const CallOptions &call = CallOptions());
+  Awaitable<GetAccountsResponse>
+  GetAccountsCo(const std::string &access_token,
+                const CallOptions &call = CallOptions());
+  Awaitable<GetAssetReportResponse>
+  GetAssetReportCo(const std::string &asset_report_token,
+                   const CallOptions &call = CallOptions());
+  Awaitable<CreateAuditCopyTokenResponse>
+  CreateAuditCopyCo(const std::string &asset_report_token,
+                    const std::string &auditor_id,
+                    const CallOptions &call = CallOptions());
+  Awaitable<RemoveAssetReportResponse>
+  RemoveAssetReportCo(const std::string &asset_report_token,
+                      const CallOptions &call = CallOptions());
+  Awaitable<GetAuthResponse>
+  GetAuthWithOptionsCo(const std::string &access_token,
+                       const GetAuthOptions &options,
+                       const CallOptions &call = CallOptions());
+  Awaitable<GetAuthResponse> GetAuthCo(const std::string &access_token,
+                                       const CallOptions &call = CallOptions());
+  Awaitable<GetCategoriesResponse>
+  GetCategoriesCo(const CallOptions &call = CallOptions());
+  Awaitable<GetHoldingsResponse>
+  GetHoldingsWithOptionsCo(const std::string &access_token,
+                           const GetHoldingsOptions &options,
+                           const CallOptions &call = CallOptions());
+  Awaitable<GetHoldingsResponse>
+  GetHoldingsCo(const std::string &access_token,
+                const CallOptions &call = CallOptions());
+  Awaitable<GetIdentityResponse>
+  GetIdentityCo(const std::string &access_token,
+                const CallOptions &call = CallOptions());
+  Awaitable<GetIncomeResponse>
+  GetIncomeCo(const std::string &access_token,
+              const CallOptions &call = CallOptions());
+  Awaitable<GetInstitutionByIDResponse>
+  GetInstitutionByIDWithOptionsCo(const std::string &id,
+                                  const GetInstitutionByIDOptions &options,
+                                  const CallOptions &call = CallOptions());
+  Awaitable<GetInstitutionByIDResponse>
+  GetInstitutionByIDCo(const std::string &id,
+                       const CallOptions &call = CallOptions());
+  Awaitable<GetInstitutionsResponse>
+  GetInstitutionsWithOptionsCo(int count, int offset,
+                               const GetInstitutionsOptions &options,
+                               const CallOptions &call = CallOptions());
+  Awaitable<GetInstitutionsResponse>
+  GetInstitutionsCo(int count, int offset,
+                    const CallOptions &call = CallOptions());
+  Awaitable<SearchInstitutionsResponse>
+  SearchInstitutionsWithOptionsCo(const std::string &query,
+                                  const std::vector<std::string> &products,
+                                  const SearchInstitutionsOptions &options,
+                                  const CallOptions &call = CallOptions());
+  Awaitable<SearchInstitutionsResponse>
+  SearchInstitutionsCo(const std::string &query,
+                       const std::vector<std::string> &products,
+                       const CallOptions &call = CallOptions());
+  Awaitable<GetInvestmentTransactionsResponse>
+  GetInvestmentTransactionsWithOptionsCo(
+      const std::string &access_token,
+      const GetInvestmentTransactionsOptions &options,
+      const CallOptions &call = CallOptions());
+  Awaitable<GetInvestmentTransactionsResponse>
+  GetInvestmentTransactionsCo(const std::string &access_token,
+                              const CallOptions &call = CallOptions());
+  Awaitable<GetInvestmentTransactionsResponse> GetAllInvestmentTransactionsCo(
+      const std::string &access_token,
+      const GetInvestmentTransactionsOptions &options,
+      const CallOptions &call = CallOptions());
+  Awaitable<GetItemResponse> GetItemCo(const std::string &access_token,
+                                       const CallOptions &call = CallOptions());
+  Awaitable<RemoveItemResponse>
+  RemoveItemCo(const std::string &access_token,
+               const CallOptions &call = CallOptions());
+  Awaitable<UpdateItemWebhookResponse>
+  UpdateItemWebhookCo(const std::string &access_token,
+                      const std::string &webhook,
+                      const CallOptions &call = CallOptions());
+  Awaitable<InvalidateAccessTokenResponse>
+  InvalidateAccessTokenCo(const std::string &access_token,
+                          const CallOptions &call = CallOptions());
+  Awaitable<UpdateAccessTokenVersionResponse>
+  UpdateAccessTokenVersionCo(const std::string &access_token,
+                             const CallOptions &call = CallOptions());
+  Awaitable<CreatePublicTokenResponse>
+  CreatePublicTokenCo(const std::string &access_token,
+                      const CallOptions &call = CallOptions());
+  Awaitable<ExchangePublicTokenResponse>
+  ExchangePublicTokenCo(const std::string &public_token,
+                        const CallOptions &call = CallOptions());
+  Awaitable<GetLiabilitiesResponse>
+  GetLiabilitiesWithOptionsCo(const std::string &access_token,
+                              const GetLiabilitiesOptions &options,
+                              const CallOptions &call = CallOptions());
+  Awaitable<GetLiabilitiesResponse>
+  GetLiabilitiesCo(const std::string &access_token,
+                   const CallOptions &call = CallOptions());
+  Awaitable<CreatePaymentRecipientResponse>
+  CreatePaymentRecipientCo(const std::string &name, const std::string &iban,
+                           const PaymentRecipientAddress &address,
+                           const CallOptions &call = CallOptions());
+  Awaitable<GetPaymentRecipientResponse>
+  GetPaymentRecipientCo(const std::string &recipient_id,
+                        const CallOptions &call = CallOptions());
+  Awaitable<ListPaymentRecipientsResponse>
+  ListPaymentRecipientsCo(const CallOptions &call = CallOptions());
+  Awaitable<CreatePaymentResponse>
+  CreatePaymentCo(const std::string &recipient_id, const std::string &reference,
+                  const PaymentAmount &amount,
+                  const CallOptions &call = CallOptions());
+  Awaitable<CreatePaymentTokenResponse>
+  CreatePaymentTokenCo(const std::string &payment_id,
+                       const CallOptions &call = CallOptions());
+  Awaitable<GetPaymentResponse>
+  GetPaymentCo(const std::string &payment_id,
+               const CallOptions &call = CallOptions());
+  Awaitable<ListPaymentsResponse>
+  ListPaymentsCo(const ListPaymentsOptions &options,
+                 const CallOptions &call = CallOptions());
+  Awaitable<CreateProcessorTokenResponse>
+  CreateApexTokenCo(const std::string &access_token,
+                    const std::string &account_id,
+                    const CallOptions &call = CallOptions());
+  Awaitable<CreateProcessorTokenResponse>
+  CreateDwollaTokenCo(const std::string &access_token,
+                      const std::string &account_id,
+                      const CallOptions &call = CallOptions());
+  Awaitable<CreateProcessorTokenResponse>
+  CreateOcrolusTokenCo(const std::string &access_token,
+                       const std::string &account_id,
+                       const CallOptions &call = CallOptions());
+  Awaitable<CreateStripeTokenResponse>
+  CreateStripeTokenCo(const std::string &access_token,
+                      const std::string &account_id,
+                      const CallOptions &call = CallOptions());
+  Awaitable<CreateSandboxPublicTokenResponse>
+  CreateSandboxPublicTokenCo(const std::string &institution_id,
+                             const std::vector<std::string> &initial_products,
+                             const CallOptions &call = CallOptions());
+  Awaitable<ResetSandboxItemResponse>
+  ResetSandboxItemCo(const std::string &access_token,
+                     const CallOptions &call = CallOptions());
+  Awaitable<GetTransactionsResponse>
+  GetTransactionsWithOptionsCo(const std::string &access_token,
+                               const GetTransactionsOptions &options,
+                               const CallOptions &call = CallOptions());
+  Awaitable<GetTransactionsResponse>
+  GetTransactionsCo(const std::string &access_token,
+                    const std::string &start_date, const std::string &end_date,
+                    const CallOptions &call = CallOptions());
+  Awaitable<GetTransactionsResponse>
+  GetAllTransactionsCo(const std::string &access_token,
+                       const GetTransactionsOptions &options,
+                       const CallOptions &call = CallOptions());
+  Awaitable<GetWebhookVerificationKeyResponse>
+  GetWebhookVerificationKeyCo(const std::string &key_id,
+                              const CallOptions &call = CallOptions());
+  Awaitable<OnboardItemResult>
+  OnboardItemCo(const std::string &public_token,
+                const OnboardItemOptions &options = OnboardItemOptions(),
+                const CallOptions &call = CallOptions());
+#endif
 
 private:
-  Client(const Credentials &creds);
+  Client(const Credentials &creds, std::shared_ptr<Transport> transport);
 
   std::string AppendUrl(const std::string &extra) const;
+  template <class E>
+  void CreateProcessorTokenAsync(const std::string &access_token,
+                                 const std::string &account_id,
+                                 Callback<CreateProcessorTokenResponse> cb,
+                                 const CallOptions &call);
+
+  struct HedgeRace;
+  // Carries a finished transfer over to the worker pool, decodes it there
+  // and hands the result to Done.
+  template <class T, class Done> struct Decoder;
+
+  // Authenticates and sends a request for the endpoint described by E (see
+  // endpoints.h); every endpoint method ends up here.
+  template <class E>
+  void Call(typename E::RequestType &body,
+            Callback<typename E::ResponseType> cb, const CallOptions &call);
+  // Reads that are safe to repeat pass their endpoint's latency histogram,
+  // which times them and makes them eligible for hedging. done is any
+  // callable taking a StatusWrapped<T>, moved along to the transfer rather
+  // than wrapped again.
+  template <class T, class Done>
+  void Dispatch(const char *path, const google::protobuf::Message &body,
+                const std::string *prefix, Done done, const CallOptions &call,
+                LatencyHistogram *latency);
+  // Turns a finished transfer into the call's result, counting errors.
+  template <class T> StatusWrapped<T> Decode(StatusWrapped<Response> &resp);
+  // Count the transfers whose callbacks still use the client.
+  void Hold();
+  void Release();
+  const std::string *CredentialPrefix(Auth auth) const;
+  std::unique_ptr<Request> Build(const char *path,
+                                 const google::protobuf::Message &body,
+                                 const std::string *prefix) const;
+  template <class Done>
+  void Send(const char *path, const google::protobuf::Message &body,
+            const std::string *prefix, const CallOptions &call,
+            LatencyHistogram *latency, Done done);
+  void Settle(const std::shared_ptr<HedgeRace> &race,
+              StatusWrapped<Response> resp, bool hedge);
+  template <class T>
+  StatusWrapped<T> Await(std::function<void(Callback<T>)> start);
 
-  Credentials creds_;
+  const Credentials creds_;
+  // The credentials' JSON, rendered once; see Request::SetBody.
+  std::string secret_prefix_;
+  std::string public_key_prefix_;
+  Counter requests_;
+  Counter request_errors_;
+  Counter parse_errors_;
+  Counter bytes_received_;
+  Counter bytes_saved_;
+  Counter hedged_requests_;
+  Counter hedge_wins_;
+  Counter breaker_rejections_;
+  Counter item_error_skips_;
+  HedgeBudget hedge_budget_;
+  LatencyHistogram latencies_[kEndpointCount];
+  PageSizer page_sizers_[kEndpointCount];
+  InstitutionBreakers breakers_;
+  ItemErrorCache item_errors_;
+  std::shared_ptr<Transport> transport_;
+  ThreadPool *pool_;
+  EventLoop *loop_;
+  // Calls sent and not yet reported back, which the destructor waits for.
+  std::atomic<size_t> outstanding_;
+  std::mutex outstanding_mu_;
+  std::condition_variable outstanding_cv_;
 };
 
+#ifdef PLAID_HAS_COROUTINES
+
+inline Awaitable<GetBalancesResponse>
+Client::GetBalancesWithOptionsCo(const std::string &access_token,
+                                 const GetBalancesOptions &options,
+                                 const CallOptions &call) {
+  return Awaitable<GetBalancesResponse>(
+      [=, this](Callback<GetBalancesResponse> cb) {
+        GetBalancesWithOptionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetBalancesResponse>
+Client::GetBalancesCo(const std::string &access_token,
+                      const CallOptions &call) {
+  return Awaitable<GetBalancesResponse>(
+      [=, this](Callback<GetBalancesResponse> cb) {
+        GetBalancesAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetAccountsResponse>
+Client::GetAccountsWithOptionsCo(const std::string &access_token,
+                                 const GetAccountsOptions &options,
+                                 const CallOptions &call) {
+  return Awaitable<GetAccountsResponse>(
+      [=, this](Callback<GetAccountsResponse> cb) {
+        GetAccountsWithOptionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetAccountsResponse>
+Client::GetAccountsCo(const std::string &access_token,
+                      const CallOptions &call) {
+  return Awaitable<GetAccountsResponse>(
+      [=, this](Callback<GetAccountsResponse> cb) {
+        GetAccountsAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetAssetReportResponse>
+Client::GetAssetReportCo(const std::string &asset_report_token,
+                         const CallOptions &call) {
+  return Awaitable<GetAssetReportResponse>(
+      [=, this](Callback<GetAssetReportResponse> cb) {
+        GetAssetReportAsync(asset_report_token, cb, call);
+      });
+}
+
+inline Awaitable<CreateAuditCopyTokenResponse>
+Client::CreateAuditCopyCo(const std::string &asset_report_token,
+                          const std::string &auditor_id,
+                          const CallOptions &call) {
+  return Awaitable<CreateAuditCopyTokenResponse>(
+      [=, this](Callback<CreateAuditCopyTokenResponse> cb) {
+        CreateAuditCopyAsync(asset_report_token, auditor_id, cb, call);
+      });
+}
+
+inline Awaitable<RemoveAssetReportResponse>
+Client::RemoveAssetReportCo(const std::string &asset_report_token,
+                            const CallOptions &call) {
+  return Awaitable<RemoveAssetReportResponse>(
+      [=, this](Callback<RemoveAssetReportResponse> cb) {
+        RemoveAssetReportAsync(asset_report_token, cb, call);
+      });
+}
+
+inline Awaitable<GetAuthResponse>
+Client::GetAuthWithOptionsCo(const std::string &access_token,
+                             const GetAuthOptions &options,
+                             const CallOptions &call) {
+  return Awaitable<GetAuthResponse>([=, this](Callback<GetAuthResponse> cb) {
+    GetAuthWithOptionsAsync(access_token, options, cb, call);
+  });
+}
+
+inline Awaitable<GetAuthResponse>
+Client::GetAuthCo(const std::string &access_token, const CallOptions &call) {
+  return Awaitable<GetAuthResponse>([=, this](Callback<GetAuthResponse> cb) {
+    GetAuthAsync(access_token, cb, call);
+  });
+}
+
+inline Awaitable<GetCategoriesResponse>
+Client::GetCategoriesCo(const CallOptions &call) {
+  return Awaitable<GetCategoriesResponse>(
+      [=, this](Callback<GetCategoriesResponse> cb) {
+        GetCategoriesAsync(cb, call);
+      });
+}
+
+inline Awaitable<GetHoldingsResponse>
+Client::GetHoldingsWithOptionsCo(const std::string &access_token,
+                                 const GetHoldingsOptions &options,
+                                 const CallOptions &call) {
+  return Awaitable<GetHoldingsResponse>(
+      [=, this](Callback<GetHoldingsResponse> cb) {
+        GetHoldingsWithOptionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetHoldingsResponse>
+Client::GetHoldingsCo(const std::string &access_token,
+                      const CallOptions &call) {
+  return Awaitable<GetHoldingsResponse>(
+      [=, this](Callback<GetHoldingsResponse> cb) {
+        GetHoldingsAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetIdentityResponse>
+Client::GetIdentityCo(const std::string &access_token,
+                      const CallOptions &call) {
+  return Awaitable<GetIdentityResponse>(
+      [=, this](Callback<GetIdentityResponse> cb) {
+        GetIdentityAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetIncomeResponse>
+Client::GetIncomeCo(const std::string &access_token, const CallOptions &call) {
+  return Awaitable<GetIncomeResponse>(
+      [=, this](Callback<GetIncomeResponse> cb) {
+        GetIncomeAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetInstitutionByIDResponse>
+Client::GetInstitutionByIDWithOptionsCo(
+    const std::string &id, const GetInstitutionByIDOptions &options,
+    const CallOptions &call) {
+  return Awaitable<GetInstitutionByIDResponse>(
+      [=, this](Callback<GetInstitutionByIDResponse> cb) {
+        GetInstitutionByIDWithOptionsAsync(id, options, cb, call);
+      });
+}
+
+inline Awaitable<GetInstitutionByIDResponse>
+Client::GetInstitutionByIDCo(const std::string &id, const CallOptions &call) {
+  return Awaitable<GetInstitutionByIDResponse>(
+      [=, this](Callback<GetInstitutionByIDResponse> cb) {
+        GetInstitutionByIDAsync(id, cb, call);
+      });
+}
+
+inline Awaitable<GetInstitutionsResponse>
+Client::GetInstitutionsWithOptionsCo(int count, int offset,
+                                     const GetInstitutionsOptions &options,
+                                     const CallOptions &call) {
+  return Awaitable<GetInstitutionsResponse>(
+      [=, this](Callback<GetInstitutionsResponse> cb) {
+        GetInstitutionsWithOptionsAsync(count, offset, options, cb, call);
+      });
+}
+
+inline Awaitable<GetInstitutionsResponse>
+Client::GetInstitutionsCo(int count, int offset, const CallOptions &call) {
+  return Awaitable<GetInstitutionsResponse>(
+      [=, this](Callback<GetInstitutionsResponse> cb) {
+        GetInstitutionsAsync(count, offset, cb, call);
+      });
+}
+
+inline Awaitable<SearchInstitutionsResponse>
+Client::SearchInstitutionsWithOptionsCo(
+    const std::string &query, const std::vector<std::string> &products,
+    const SearchInstitutionsOptions &options, const CallOptions &call) {
+  return Awaitable<SearchInstitutionsResponse>(
+      [=, this](Callback<SearchInstitutionsResponse> cb) {
+        SearchInstitutionsWithOptionsAsync(query, products, options, cb, call);
+      });
+}
+
+inline Awaitable<SearchInstitutionsResponse>
+Client::SearchInstitutionsCo(const std::string &query,
+                             const std::vector<std::string> &products,
+                             const CallOptions &call) {
+  return Awaitable<SearchInstitutionsResponse>(
+      [=, this](Callback<SearchInstitutionsResponse> cb) {
+        SearchInstitutionsAsync(query, products, cb, call);
+      });
+}
+
+inline Awaitable<GetInvestmentTransactionsResponse>
+Client::GetInvestmentTransactionsWithOptionsCo(
+    const std::string &access_token,
+    const GetInvestmentTransactionsOptions &options, const CallOptions &call) {
+  return Awaitable<GetInvestmentTransactionsResponse>(
+      [=, this](Callback<GetInvestmentTransactionsResponse> cb) {
+        GetInvestmentTransactionsWithOptionsAsync(access_token, options, cb,
+                                                  call);
+      });
+}
+
+inline Awaitable<GetInvestmentTransactionsResponse>
+Client::GetInvestmentTransactionsCo(const std::string &access_token,
+                                    const CallOptions &call) {
+  return Awaitable<GetInvestmentTransactionsResponse>(
+      [=, this](Callback<GetInvestmentTransactionsResponse> cb) {
+        GetInvestmentTransactionsAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetInvestmentTransactionsResponse>
+Client::GetAllInvestmentTransactionsCo(
+    const std::string &access_token,
+    const GetInvestmentTransactionsOptions &options, const CallOptions &call) {
+  return Awaitable<GetInvestmentTransactionsResponse>(
+      [=, this](Callback<GetInvestmentTransactionsResponse> cb) {
+        GetAllInvestmentTransactionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetItemResponse>
+Client::GetItemCo(const std::string &access_token, const CallOptions &call) {
+  return Awaitable<GetItemResponse>([=, this](Callback<GetItemResponse> cb) {
+    GetItemAsync(access_token, cb, call);
+  });
+}
+
+inline Awaitable<RemoveItemResponse>
+Client::RemoveItemCo(const std::string &access_token, const CallOptions &call) {
+  return Awaitable<RemoveItemResponse>(
+      [=, this](Callback<RemoveItemResponse> cb) {
+        RemoveItemAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<UpdateItemWebhookResponse>
+Client::UpdateItemWebhookCo(const std::string &access_token,
+                            const std::string &webhook,
+                            const CallOptions &call) {
+  return Awaitable<UpdateItemWebhookResponse>(
+      [=, this](Callback<UpdateItemWebhookResponse> cb) {
+        UpdateItemWebhookAsync(access_token, webhook, cb, call);
+      });
+}
+
+inline Awaitable<InvalidateAccessTokenResponse>
+Client::InvalidateAccessTokenCo(const std::string &access_token,
+                                const CallOptions &call) {
+  return Awaitable<InvalidateAccessTokenResponse>(
+      [=, this](Callback<InvalidateAccessTokenResponse> cb) {
+        InvalidateAccessTokenAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<UpdateAccessTokenVersionResponse>
+Client::UpdateAccessTokenVersionCo(const std::string &access_token,
+                                   const CallOptions &call) {
+  return Awaitable<UpdateAccessTokenVersionResponse>(
+      [=, this](Callback<UpdateAccessTokenVersionResponse> cb) {
+        UpdateAccessTokenVersionAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<CreatePublicTokenResponse>
+Client::CreatePublicTokenCo(const std::string &access_token,
+                            const CallOptions &call) {
+  return Awaitable<CreatePublicTokenResponse>(
+      [=, this](Callback<CreatePublicTokenResponse> cb) {
+        CreatePublicTokenAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<ExchangePublicTokenResponse>
+Client::ExchangePublicTokenCo(const std::string &public_token,
+                              const CallOptions &call) {
+  return Awaitable<ExchangePublicTokenResponse>(
+      [=, this](Callback<ExchangePublicTokenResponse> cb) {
+        ExchangePublicTokenAsync(public_token, cb, call);
+      });
+}
+
+inline Awaitable<GetLiabilitiesResponse>
+Client::GetLiabilitiesWithOptionsCo(const std::string &access_token,
+                                    const GetLiabilitiesOptions &options,
+                                    const CallOptions &call) {
+  return Awaitable<GetLiabilitiesResponse>(
+      [=, this](Callback<GetLiabilitiesResponse> cb) {
+        GetLiabilitiesWithOptionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetLiabilitiesResponse>
+Client::GetLiabilitiesCo(const std::string &access_token,
+                         const CallOptions &call) {
+  return Awaitable<GetLiabilitiesResponse>(
+      [=, this](Callback<GetLiabilitiesResponse> cb) {
+        GetLiabilitiesAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<CreatePaymentRecipientResponse>
+Client::CreatePaymentRecipientCo(const std::string &name,
+                                 const std::string &iban,
+                                 const PaymentRecipientAddress &address,
+                                 const CallOptions &call) {
+  return Awaitable<CreatePaymentRecipientResponse>(
+      [=, this](Callback<CreatePaymentRecipientResponse> cb) {
+        CreatePaymentRecipientAsync(name, iban, address, cb, call);
+      });
+}
+
+inline Awaitable<GetPaymentRecipientResponse>
+Client::GetPaymentRecipientCo(const std::string &recipient_id,
+                              const CallOptions &call) {
+  return Awaitable<GetPaymentRecipientResponse>(
+      [=, this](Callback<GetPaymentRecipientResponse> cb) {
+        GetPaymentRecipientAsync(recipient_id, cb, call);
+      });
+}
+
+inline Awaitable<ListPaymentRecipientsResponse>
+Client::ListPaymentRecipientsCo(const CallOptions &call) {
+  return Awaitable<ListPaymentRecipientsResponse>(
+      [=, this](Callback<ListPaymentRecipientsResponse> cb) {
+        ListPaymentRecipientsAsync(cb, call);
+      });
+}
+
+inline Awaitable<CreatePaymentResponse>
+Client::CreatePaymentCo(const std::string &recipient_id,
+                        const std::string &reference,
+                        const PaymentAmount &amount, const CallOptions &call) {
+  return Awaitable<CreatePaymentResponse>(
+      [=, this](Callback<CreatePaymentResponse> cb) {
+        CreatePaymentAsync(recipient_id, reference, amount, cb, call);
+      });
+}
+
+inline Awaitable<CreatePaymentTokenResponse>
+Client::CreatePaymentTokenCo(const std::string &payment_id,
+                             const CallOptions &call) {
+  return Awaitable<CreatePaymentTokenResponse>(
+      [=, this](Callback<CreatePaymentTokenResponse> cb) {
+        CreatePaymentTokenAsync(payment_id, cb, call);
+      });
+}
+
+inline Awaitable<GetPaymentResponse>
+Client::GetPaymentCo(const std::string &payment_id, const CallOptions &call) {
+  return Awaitable<GetPaymentResponse>(
+      [=, this](Callback<GetPaymentResponse> cb) {
+        GetPaymentAsync(payment_id, cb, call);
+      });
+}
+
+inline Awaitable<ListPaymentsResponse>
+Client::ListPaymentsCo(const ListPaymentsOptions &options,
+                       const CallOptions &call) {
+  return Awaitable<ListPaymentsResponse>(
+      [=, this](Callback<ListPaymentsResponse> cb) {
+        ListPaymentsAsync(options, cb, call);
+      });
+}
+
+inline Awaitable<CreateProcessorTokenResponse>
+Client::CreateApexTokenCo(const std::string &access_token,
+                          const std::string &account_id,
+                          const CallOptions &call) {
+  return Awaitable<CreateProcessorTokenResponse>(
+      [=, this](Callback<CreateProcessorTokenResponse> cb) {
+        CreateApexTokenAsync(access_token, account_id, cb, call);
+      });
+}
+
+inline Awaitable<CreateProcessorTokenResponse>
+Client::CreateDwollaTokenCo(const std::string &access_token,
+                            const std::string &account_id,
+                            const CallOptions &call) {
+  return Awaitable<CreateProcessorTokenResponse>(
+      [=, this](Callback<CreateProcessorTokenResponse> cb) {
+        CreateDwollaTokenAsync(access_token, account_id, cb, call);
+      });
+}
+
+inline Awaitable<CreateProcessorTokenResponse>
+Client::CreateOcrolusTokenCo(const std::string &access_token,
+                             const std::string &account_id,
+                             const CallOptions &call) {
+  return Awaitable<CreateProcessorTokenResponse>(
+      [=, this](Callback<CreateProcessorTokenResponse> cb) {
+        CreateOcrolusTokenAsync(access_token, account_id, cb, call);
+      });
+}
+
+inline Awaitable<CreateStripeTokenResponse>
+Client::CreateStripeTokenCo(const std::string &access_token,
+                            const std::string &account_id,
+                            const CallOptions &call) {
+  return Awaitable<CreateStripeTokenResponse>(
+      [=, this](Callback<CreateStripeTokenResponse> cb) {
+        CreateStripeTokenAsync(access_token, account_id, cb, call);
+      });
+}
+
+inline Awaitable<CreateSandboxPublicTokenResponse>
+Client::CreateSandboxPublicTokenCo(
+    const std::string &institution_id,
+    const std::vector<std::string> &initial_products, const CallOptions &call) {
+  return Awaitable<CreateSandboxPublicTokenResponse>(
+      [=, this](Callback<CreateSandboxPublicTokenResponse> cb) {
+        CreateSandboxPublicTokenAsync(institution_id, initial_products, cb,
+                                      call);
+      });
+}
+
+inline Awaitable<ResetSandboxItemResponse>
+Client::ResetSandboxItemCo(const std::string &access_token,
+                           const CallOptions &call) {
+  return Awaitable<ResetSandboxItemResponse>(
+      [=, this](Callback<ResetSandboxItemResponse> cb) {
+        ResetSandboxItemAsync(access_token, cb, call);
+      });
+}
+
+inline Awaitable<GetTransactionsResponse>
+Client::GetTransactionsWithOptionsCo(const std::string &access_token,
+                                     const GetTransactionsOptions &options,
+                                     const CallOptions &call) {
+  return Awaitable<GetTransactionsResponse>(
+      [=, this](Callback<GetTransactionsResponse> cb) {
+        GetTransactionsWithOptionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetTransactionsResponse>
+Client::GetTransactionsCo(const std::string &access_token,
+                          const std::string &start_date,
+                          const std::string &end_date,
+                          const CallOptions &call) {
+  return Awaitable<GetTransactionsResponse>(
+      [=, this](Callback<GetTransactionsResponse> cb) {
+        GetTransactionsAsync(access_token, start_date, end_date, cb, call);
+      });
+}
+
+inline Awaitable<GetTransactionsResponse>
+Client::GetAllTransactionsCo(const std::string &access_token,
+                             const GetTransactionsOptions &options,
+                             const CallOptions &call) {
+  return Awaitable<GetTransactionsResponse>(
+      [=, this](Callback<GetTransactionsResponse> cb) {
+        GetAllTransactionsAsync(access_token, options, cb, call);
+      });
+}
+
+inline Awaitable<GetWebhookVerificationKeyResponse>
+Client::GetWebhookVerificationKeyCo(const std::string &key_id,
+                                    const CallOptions &call) {
+  return Awaitable<GetWebhookVerificationKeyResponse>(
+      [=, this](Callback<GetWebhookVerificationKeyResponse> cb) {
+        GetWebhookVerificationKeyAsync(key_id, cb, call);
+      });
+}
+
+inline Awaitable<OnboardItemResult>
+Client::OnboardItemCo(const std::string &public_token,
+                      const OnboardItemOptions &options,
+                      const CallOptions &call) {
+  return Awaitable<OnboardItemResult>(
+      [=, this](Callback<OnboardItemResult> cb) {
+        OnboardItemAsync(public_token, options, cb, call);
+      });
+}
+
+#endif
+
 } // namespace plaid
 
 #endif // PLAID_CLIENT_H_
\ No newline at end of file
@@ -0,0 +1,129 @@
+#ifndef PLAID_CONCURRENCY_H_
+#define PLAID_CONCURRENCY_H_
+
+#include "plaid/metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace plaid {
+
+struct ConcurrencyLimitOptions {
+  // Requests in flight at first, and the bounds the limit moves between.
+  size_t initial_limit = 16;
+  size_t min_limit = 1;
+  size_t max_limit = 1024;
+  // How far recent latency may rise above its usual level, as a ratio,
+  // before the limit is cut.
+  double tolerance = 1.5;
+  // What the limit is multiplied by on a 429, a 503 or a timeout, and on
+  // rising latency. A request cut short by its caller's own deadline only
+  // counts as a timeout if it had run past tolerance times its endpoint's
+  // usual latency.
+  double overload_backoff = 0.5;
+  double latency_backoff = 0.9;
+};
+
+// Decides how many requests an EventLoop keeps in flight, from how the
+// requests it already sent fared: additive increase, multiplicative
+// decrease, with rising latency read as a sign of congestion the way TCP
+// Vegas does.
+//
+// Each endpoint (URL) keeps a latency baseline that moves over tens of
+// seconds, so a slow endpoint doesn't look congested next to a fast one; the
+// ratio of each completion's latency to its endpoint's baseline feeds a
+// short-term average. While that stays within tolerance and the limit is
+// actually in use, the limit grows: by one per completion until the first
+// cut (slow start), then by about one per limit's worth of completions. A
+// 429, 503 or timeout (connecting or mid-response, or the caller's deadline
+// passing on a request that was overdue anyway) cuts it by
+// overload_backoff, and the short-term ratio rising past tolerance by
+// latency_backoff. Only requests started after a cut can cause another, so
+// one burst of slow responses counts once.
+//
+// Record and Observe are called from the event loop's thread; Limit and
+// Metrics from anywhere.
+class ConcurrencyLimit {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  enum class Outcome {
+    // The request was answered; its latency counts.
+    kAnswered,
+    // Rate limited, unavailable, or timed out connecting or mid-response: a
+    // cut.
+    kOverloaded,
+    // Stopped by the caller's deadline. A tight deadline says nothing about
+    // load, so this is a cut only if the request was overdue anyway.
+    kDeadline,
+    // Cancelled or failed to connect; says nothing about load.
+    kIgnored
+  };
+
+  ConcurrencyLimit();
+  ~ConcurrencyLimit() = default;
+
+  ConcurrencyLimit(const ConcurrencyLimit &) = delete;
+  ConcurrencyLimit &operator=(const ConcurrencyLimit &) = delete;
+
+  // Takes effect from the next completion; the limit is clamped to the new
+  // bounds.
+  void SetOptions(const ConcurrencyLimitOptions &options);
+  ConcurrencyLimitOptions Options() const;
+
+  size_t Limit() const;
+  ConcurrencyMetrics Metrics() const;
+
+  // A request to route, started at started, has finished with outcome while
+  // in_flight requests (itself included) were outstanding.
+  void Record(const std::string &route, Clock::time_point started,
+              Outcome outcome, size_t in_flight);
+  // The event loop's queue after each turn, for Metrics.
+  void Observe(size_t in_flight, size_t waiting);
+
+private:
+  // Weight of the newest sample in the short-term latency ratio.
+  static constexpr double kShortWeight = 0.1;
+  // Time constant of each endpoint's baseline. It is set in time rather than
+  // samples so that a busy client's baseline doesn't follow latency up
+  // within a second and hide the congestion it is meant to reveal.
+  static constexpr double kBaselineSeconds = 30;
+
+  // Samples a baseline averages evenly before it switches to decaying over
+  // time, so that it doesn't start from one unusually fast (or slow) reply.
+  static const int kBaselineWarmup = 32;
+
+  struct Baseline {
+    double latency = 0;
+    int samples = 0;
+    Clock::time_point updated;
+  };
+
+  void Cut(double factor, Clock::time_point now);
+  void Publish();
+
+  mutable std::mutex options_mu_;
+  ConcurrencyLimitOptions options_;
+  bool options_changed_ = true;
+
+  // Owned by the event loop's thread.
+  ConcurrencyLimitOptions current_;
+  double limit_;
+  bool slow_start_ = true;
+  double ratio_ = 1;
+  Clock::time_point last_cut_;
+  std::unordered_map<std::string, Baseline> baselines_;
+
+  std::atomic<size_t> published_;
+  std::atomic<size_t> in_flight_;
+  std::atomic<size_t> waiting_;
+  Counter cuts_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_CONCURRENCY_H_
\ No newline at end of file
@@ -0,0 +1,176 @@
+#ifndef PLAID_CORO_H_
+#define PLAID_CORO_H_
+
+// C++20 coroutine support. Everything here compiles away on older standards,
+// so the rest of the library stays usable from C++11.
+#if defined(__cpp_impl_coroutine)
+#define PLAID_HAS_COROUTINES 1
+
+#include "plaid/status.h"
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace plaid {
+
+// Adapts one asynchronous call to co_await. The call is started when the
+// coroutine suspends, and the coroutine resumes on whichever thread delivers
+// the result (for Client calls, the worker pool).
+template <typename T> class Awaitable {
+public:
+  using Start = std::function<void(std::function<void(StatusWrapped<T>)>)>;
+
+  explicit Awaitable(Start start) : start_(std::move(start)) {}
+
+  bool await_ready() const noexcept { return false; }
+
+  bool await_suspend(std::coroutine_handle<> handle) {
+    handle_ = handle;
+    // The result may arrive before this returns (or even inline, when the
+    // arguments fail validation). Whichever side gets here second is the one
+    // that continues the coroutine.
+    auto start = std::move(start_);
+    start([this](StatusWrapped<T> res) {
+      result_.emplace(std::move(res));
+      if (arrived_.exchange(true))
+        handle_.resume();
+    });
+    return !arrived_.exchange(true);
+  }
+
+  StatusWrapped<T> await_resume() { return std::move(*result_); }
+
+private:
+  Start start_;
+  std::coroutine_handle<> handle_;
+  std::optional<StatusWrapped<T>> result_;
+  std::atomic<bool> arrived_{false};
+};
+
+template <typename T = void> class Task;
+
+namespace internal {
+
+struct TaskPromiseBase {
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+    template <typename P>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<P> handle) noexcept {
+      auto next = handle.promise().continuation;
+      return next ? next : std::noop_coroutine();
+    }
+    void await_resume() const noexcept {}
+  };
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+  void unhandled_exception() { exception = std::current_exception(); }
+
+  std::coroutine_handle<> continuation;
+  std::exception_ptr exception;
+};
+
+template <typename T> struct TaskPromise : TaskPromiseBase {
+  Task<T> get_return_object();
+  void return_value(T v) { value.emplace(std::move(v)); }
+  T Take() {
+    if (exception)
+      std::rethrow_exception(exception);
+    return std::move(*value);
+  }
+
+  std::optional<T> value;
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object();
+  void return_void() {}
+  void Take() {
+    if (exception)
+      std::rethrow_exception(exception);
+  }
+};
+
+// Fire-and-forget frame used by Task::Detach to drive a task to completion.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    std::suspend_never final_suspend() const noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+} // namespace internal
+
+// A lazily started coroutine. Tasks can be awaited from other tasks, which
+// is how multi-step flows (exchange a token, then fetch accounts, ...) are
+// written; Detach starts a top-level task from ordinary code.
+template <typename T> class Task {
+public:
+  using promise_type = internal::TaskPromise<T>;
+
+  explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+  Task(Task &&rhs) noexcept : handle_(std::exchange(rhs.handle_, nullptr)) {}
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+  ~Task() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<>
+  await_suspend(std::coroutine_handle<> continuation) noexcept {
+    handle_.promise().continuation = continuation;
+    return handle_;
+  }
+  T await_resume() { return handle_.promise().Take(); }
+
+  // Runs the task to completion without an awaiting coroutine. The optional
+  // callback receives the result on whichever thread finishes the task.
+  template <typename F> static internal::Detached Run(Task task, F done) {
+    if constexpr (std::is_void<T>::value) {
+      co_await task;
+      done();
+    } else {
+      done(co_await task);
+    }
+  }
+  void Detach() {
+    if constexpr (std::is_void<T>::value)
+      Run(std::move(*this), []() {});
+    else
+      Run(std::move(*this), [](T) {});
+  }
+  template <typename F> void Detach(F done) { Run(std::move(*this), done); }
+
+private:
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace internal {
+
+template <typename T> Task<T> TaskPromise<T>::get_return_object() {
+  return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() {
+  return Task<void>(
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+} // namespace internal
+
+} // namespace plaid
+
+#endif // defined(__cpp_impl_coroutine)
+
+#endif // PLAID_CORO_H_
\ No newline at end of file
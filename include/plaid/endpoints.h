@@ -0,0 +1,130 @@
+#ifndef PLAID_ENDPOINTS_H_
+#define PLAID_ENDPOINTS_H_
+
+#include "plaid/plaid.pb.h"
+
+#include <google/protobuf/empty.pb.h>
+
+namespace plaid {
+
+// The credentials an endpoint expects in its request body. Most take the
+// client id and secret, a few public ones take the public key, and
+// categories takes none.
+enum class Auth { None, Secret, PublicKey };
+
+// Every endpoint, described once: name, path under the environment's base
+// URL, request and response messages, credentials, and whether it is a read
+// that is safe to send more than once (which makes it eligible for hedging).
+// Client methods validate their arguments and fill in the request message;
+// everything else (credentials, dispatch, timing, parsing) is driven from
+// this table.
+#define PLAID_ENDPOINTS(X)                                                     \
+  X(GetBalances, "accounts/balance/get", GetBalancesRequest,                   \
+    GetBalancesResponse, Secret, true)                                         \
+  X(GetAccounts, "accounts/get", GetAccountsRequest, GetAccountsResponse,      \
+    Secret, true)                                                              \
+  X(GetAssetReport, "asset_report/get", GetAssetReportRequest,                 \
+    GetAssetReportResponse, Secret, true)                                      \
+  X(CreateAuditCopy, "asset_report/audit_copy/create",                         \
+    CreateAuditCopyRequest, CreateAuditCopyTokenResponse, Secret, false)       \
+  X(RemoveAssetReport, "asset_report/remove", RemoveAssetReportRequest,        \
+    RemoveAssetReportResponse, Secret, false)                                  \
+  X(GetAuth, "auth/get", GetAuthRequest, GetAuthResponse, Secret, true)        \
+  X(GetCategories, "categories/get", google::protobuf::Empty,                  \
+    GetCategoriesResponse, None, true)                                         \
+  X(GetHoldings, "investments/holdings/get", GetHoldingsRequest,               \
+    GetHoldingsResponse, Secret, true)                                         \
+  X(GetIdentity, "identity/get", GetIdentityRequest, GetIdentityResponse,      \
+    Secret, true)                                                              \
+  X(GetIncome, "income/get", GetIncomeRequest, GetIncomeResponse, Secret,      \
+    true)                                                                      \
+  X(GetInstitutionByID, "institutions/get_by_id", GetInstitutionByIDRequest,   \
+    GetInstitutionByIDResponse, PublicKey, true)                               \
+  X(GetInstitutions, "institutions/get", GetInstitutionsRequest,               \
+    GetInstitutionsResponse, Secret, true)                                     \
+  X(SearchInstitutions, "institutions/search", SearchInstitutionsRequest,      \
+    SearchInstitutionsResponse, PublicKey, true)                               \
+  X(GetInvestmentTransactions, "investments/transactions/get",                 \
+    GetInvestmentTransactionsRequest, GetInvestmentTransactionsResponse,       \
+    Secret, true)                                                              \
+  X(GetItem, "item/get", GetItemRequest, GetItemResponse, Secret, true)        \
+  X(RemoveItem, "item/remove", RemoveItemRequest, RemoveItemResponse,          \
+    Secret, false)                                                             \
+  X(UpdateItemWebhook, "item/webhook/update", UpdateItemWebhookRequest,        \
+    UpdateItemWebhookResponse, Secret, false)                                  \
+  X(InvalidateAccessToken, "item/access_token/invalidate",                     \
+    InvalidateAccessTokenRequest, InvalidateAccessTokenResponse, Secret,       \
+    false)                                                                     \
+  X(UpdateAccessTokenVersion, "item/access_token/update_version",              \
+    UpdateAccessTokenVersionRequest, UpdateAccessTokenVersionResponse,         \
+    Secret, false)                                                             \
+  X(CreatePublicToken, "item/public_token/create", CreatePublicTokenRequest,   \
+    CreatePublicTokenResponse, Secret, false)                                  \
+  X(ExchangePublicToken, "item/public_token/exchange",                         \
+    ExchangePublicTokenRequest, ExchangePublicTokenResponse, Secret, false)    \
+  X(GetLiabilities, "liabilities/get", GetLiabilitiesRequest,                  \
+    GetLiabilitiesResponse, Secret, true)                                      \
+  X(CreatePaymentRecipient, "payment_initiation/recipient/create",             \
+    CreatePaymentRecipientRequest, CreatePaymentRecipientResponse, Secret,     \
+    false)                                                                     \
+  X(GetPaymentRecipient, "payment_initiation/recipient/get",                   \
+    GetPaymentRecipientRequest, GetPaymentRecipientResponse, Secret, true)     \
+  X(ListPaymentRecipients, "payment_initiation/recipient/list",                \
+    ListPaymentRecipientsRequest, ListPaymentRecipientsResponse, Secret,       \
+    true)                                                                      \
+  X(CreatePayment, "payment_initiation/payment/create",                        \
+    CreatePaymentRequest, CreatePaymentResponse, Secret, false)                \
+  X(CreatePaymentToken, "payment_initiation/payment/token/create",             \
+    CreatePaymentTokenRequest, CreatePaymentTokenResponse, Secret, false)      \
+  X(GetPayment, "payment_initiation/payment/get", GetPaymentRequest,           \
+    GetPaymentResponse, Secret, true)                                          \
+  X(ListPayments, "payment_initiation/payment/list", ListPaymentsRequest,      \
+    ListPaymentsResponse, Secret, true)                                        \
+  X(CreateApexToken, "processor/apex/processor_token/create",                  \
+    CreateProcessorTokenRequest, CreateProcessorTokenResponse, Secret,         \
+    false)                                                                     \
+  X(CreateDwollaToken, "processor/dwolla/processor_token/create",              \
+    CreateProcessorTokenRequest, CreateProcessorTokenResponse, Secret,         \
+    false)                                                                     \
+  X(CreateOcrolusToken, "processor/ocrolus/processor_token/create",            \
+    CreateProcessorTokenRequest, CreateProcessorTokenResponse, Secret,         \
+    false)                                                                     \
+  X(CreateStripeToken, "processor/stripe/bank_account_token/create",           \
+    CreateStripeTokenRequest, CreateStripeTokenResponse, Secret, false)        \
+  X(CreateSandboxPublicToken, "sandbox/public_token/create",                   \
+    CreateSandboxPublicTokenRequest, CreateSandboxPublicTokenResponse,         \
+    PublicKey, false)                                                          \
+  X(ResetSandboxItem, "sandbox/item/reset_login", ResetSandboxItemRequest,     \
+    ResetSandboxItemResponse, Secret, false)                                   \
+  X(GetTransactions, "transactions/get", GetTransactionsRequest,               \
+    GetTransactionsResponse, Secret, true)                                     \
+  X(GetWebhookVerificationKey, "webhook_verification_key/get",                 \
+    GetWebhookVerificationKeyRequest, GetWebhookVerificationKeyResponse,       \
+    Secret, true)
+
+enum class EndpointId {
+#define PLAID_ENDPOINT_ID(name, path, req, resp, auth, idempotent) name,
+  PLAID_ENDPOINTS(PLAID_ENDPOINT_ID)
+#undef PLAID_ENDPOINT_ID
+};
+
+#define PLAID_ENDPOINT_COUNT(name, path, req, resp, auth, idempotent) +1
+static const int kEndpointCount = 0 PLAID_ENDPOINTS(PLAID_ENDPOINT_COUNT);
+#undef PLAID_ENDPOINT_COUNT
+
+// A compile-time descriptor per endpoint, e.g. GetBalancesEndpoint.
+#define PLAID_ENDPOINT_DESCRIPTOR(name, path, req, resp, auth, idempotent)     \
+  struct name##Endpoint {                                                      \
+    using RequestType = req;                                                   \
+    using ResponseType = resp;                                                 \
+    static const EndpointId kId = EndpointId::name;                            \
+    static const Auth kAuth = Auth::auth;                                      \
+    static const bool kIdempotent = idempotent;                                \
+    static const char *Path() { return path; }                                 \
+  };
+PLAID_ENDPOINTS(PLAID_ENDPOINT_DESCRIPTOR)
+#undef PLAID_ENDPOINT_DESCRIPTOR
+
+} // namespace plaid
+
+#endif // PLAID_ENDPOINTS_H_
\ No newline at end of file
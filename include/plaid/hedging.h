@@ -0,0 +1,65 @@
+#ifndef PLAID_HEDGING_H_
+#define PLAID_HEDGING_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace plaid {
+
+// A recent-latency distribution that any number of threads can record into
+// without locking. Samples land in log-spaced buckets (four per power of
+// two, so estimates are within about 20%), and all counts are halved every
+// kWindow samples so that old traffic fades out of the estimate.
+class LatencyHistogram {
+public:
+  LatencyHistogram();
+  ~LatencyHistogram() = default;
+
+  LatencyHistogram(const LatencyHistogram &) = delete;
+  LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+  void Record(std::chrono::microseconds latency);
+
+  // The upper bound of the bucket holding the p-th percentile (0 < p < 1),
+  // or zero while there are too few samples to say.
+  std::chrono::microseconds Percentile(double p) const;
+
+private:
+  static const int kBuckets = 128;
+  static const uint64_t kWindow = 1024;
+  static const uint64_t kMinSamples = 32;
+
+  static int BucketFor(uint64_t us);
+  static uint64_t UpperBound(int bucket);
+
+  std::atomic<uint64_t> buckets_[kBuckets];
+  std::atomic<uint64_t> samples_;
+};
+
+// Caps the extra load that hedging adds. Every eligible call deposits a
+// fraction of a hedge and every hedge withdraws a whole one, so over time
+// hedges stay below that fraction of calls; the balance is capped to keep a
+// long quiet stretch from funding a burst.
+class HedgeBudget {
+public:
+  HedgeBudget();
+  ~HedgeBudget() = default;
+
+  HedgeBudget(const HedgeBudget &) = delete;
+  HedgeBudget &operator=(const HedgeBudget &) = delete;
+
+  void Deposit(double fraction);
+  bool CanWithdraw() const;
+  bool TryWithdraw();
+
+private:
+  static const int64_t kUnit = 1000000;
+  static const int64_t kMaxBalance = 10 * kUnit;
+
+  std::atomic<int64_t> balance_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_HEDGING_H_
\ No newline at end of file
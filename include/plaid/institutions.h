@@ -0,0 +1,164 @@
+#ifndef PLAID_INSTITUTIONS_H_
+#define PLAID_INSTITUTIONS_H_
+
+#include "plaid/call_options.h"
+#include "plaid/client.h"
+#include "plaid/plaid.pb.h"
+#include "plaid/status.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace plaid {
+
+// An immutable snapshot of the institutions catalog, indexed for lookups by
+// id, product and country code. Each institution appears once, in the order
+// the API listed it; the pointers handed out stay valid for the life of the
+// index. Names and URLs are also indexed for typeahead search.
+class InstitutionIndex {
+public:
+  InstitutionIndex(GetInstitutionsResponse institutions,
+                   std::chrono::system_clock::time_point fetched_at);
+  ~InstitutionIndex() = default;
+
+  InstitutionIndex(const InstitutionIndex &) = delete;
+  InstitutionIndex &operator=(const InstitutionIndex &) = delete;
+
+  // Null if there is no institution with that id.
+  const Institution *Find(const std::string &institution_id) const;
+  const std::vector<const Institution *> &
+  WithProduct(const std::string &product) const;
+  const std::vector<const Institution *> &
+  InCountry(const std::string &country_code) const;
+  const std::vector<const Institution *> &All() const;
+
+  // Ranks institutions against a typeahead query: the whole name first, then
+  // names whose words start with each query word, then URLs, and finally
+  // names sharing most of the query's trigrams, which tolerates typos. Only
+  // institutions offering all the products, and at least one of the country
+  // codes when any are given, are returned.
+  std::vector<const Institution *>
+  Search(const std::string &query, const std::vector<std::string> &products,
+         const std::vector<std::string> &country_codes, size_t limit) const;
+
+  size_t Size() const;
+  std::chrono::system_clock::time_point FetchedAt() const;
+  const GetInstitutionsResponse &Data() const;
+
+private:
+  struct Word {
+    std::string text;
+    uint32_t position;
+    bool in_url;
+  };
+
+  GetInstitutionsResponse data_;
+  std::chrono::system_clock::time_point fetched_at_;
+  std::vector<const Institution *> all_;
+  std::unordered_map<std::string, const Institution *> by_id_;
+  std::unordered_map<std::string, std::vector<const Institution *>>
+      by_product_;
+  std::unordered_map<std::string, std::vector<const Institution *>>
+      by_country_;
+  // Search tables, by position in all_: normalized names, every name and URL
+  // word sorted for prefix lookups, and each name trigram's postings.
+  std::vector<std::string> names_;
+  std::vector<Word> words_;
+  std::unordered_map<std::string, std::vector<uint32_t>> trigrams_;
+};
+
+struct InstitutionCatalogOptions {
+  // Institutions per GetInstitutions call; the API allows at most 500. Zero
+  // leaves it to the client's PageSizer for the endpoint.
+  int page_size = 0;
+  // Pages requested at once once the first page has reported the total.
+  int max_in_flight = 8;
+  // Narrows the catalog, as for GetInstitutionsWithOptions.
+  GetInstitutionsOptions filter;
+  // Search answers from the local catalog while it is younger than this.
+  std::chrono::seconds max_search_age = std::chrono::hours(24);
+  // Results returned by a local search.
+  size_t search_limit = 10;
+};
+
+// Keeps a local copy of the institutions catalog. Load fetches the first page
+// to learn the total and then the remaining pages concurrently; a snapshot
+// file lets a process start from the last catalog it saw instead of waiting
+// on the network. Readers take the current index and keep using it even
+// while a newer one replaces it.
+class InstitutionCatalog {
+public:
+  explicit InstitutionCatalog(
+      Client &client,
+      const InstitutionCatalogOptions &options = InstitutionCatalogOptions());
+  ~InstitutionCatalog();
+
+  InstitutionCatalog(const InstitutionCatalog &) = delete;
+  InstitutionCatalog &operator=(const InstitutionCatalog &) = delete;
+
+  // Fetches the whole catalog and swaps it in. On failure the current index
+  // is kept. Blocks until every page is in, so don't call it from inside a
+  // client callback.
+  Status Load(const CallOptions &call = CallOptions());
+
+  // Snapshots hold the fetch time and the catalog as a serialized
+  // GetInstitutionsResponse. Saving writes a temporary file and renames it
+  // over the target, so a crash never leaves a torn snapshot behind.
+  Status SaveSnapshot(const std::string &path) const;
+  Status LoadSnapshot(const std::string &path);
+
+  // Answers a query like Client::SearchInstitutionsWithOptions, from the
+  // local index when it can. Falls back to the API when no catalog is loaded
+  // or it is older than max_search_age, and for options the catalog can't
+  // answer (routing numbers, or metadata it wasn't loaded with).
+  StatusWrapped<SearchInstitutionsResponse>
+  Search(const std::string &query, const std::vector<std::string> &products,
+         const SearchInstitutionsOptions &options = SearchInstitutionsOptions(),
+         const CallOptions &call = CallOptions()) const;
+  void SearchAsync(const std::string &query,
+                   const std::vector<std::string> &products,
+                   const SearchInstitutionsOptions &options,
+                   Callback<SearchInstitutionsResponse> cb,
+                   const CallOptions &call = CallOptions()) const;
+
+  // Null until a catalog has been loaded.
+  std::shared_ptr<const InstitutionIndex> Current() const;
+
+  // Reloads the catalog every interval on a background thread. Failed
+  // reloads leave the current index in place until the next attempt; a
+  // reload still running when StopRefresh is called is cancelled.
+  void StartRefresh(std::chrono::seconds interval);
+  void StopRefresh();
+
+private:
+  bool SearchLocally(const std::string &query,
+                     const std::vector<std::string> &products,
+                     const SearchInstitutionsOptions &options,
+                     SearchInstitutionsResponse &out) const;
+  void Swap(std::shared_ptr<const InstitutionIndex> index);
+  void RefreshLoop(std::chrono::seconds interval);
+
+  Client &client_;
+  InstitutionCatalogOptions options_;
+
+  mutable std::mutex index_mu_;
+  std::shared_ptr<const InstitutionIndex> index_;
+
+  std::mutex refresh_mu_;
+  std::condition_variable refresh_cv_;
+  bool refresh_stopping_ = false;
+  // Passed to the reloads, and cancelled by StopRefresh.
+  CancellationToken refresh_cancel_ = CancellationToken::None();
+  std::thread refresh_thread_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_INSTITUTIONS_H_
\ No newline at end of file
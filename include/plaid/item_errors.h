@@ -0,0 +1,87 @@
+#ifndef PLAID_ITEM_ERRORS_H_
+#define PLAID_ITEM_ERRORS_H_
+
+#include "plaid/status.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace plaid {
+
+struct ItemErrorCacheOptions {
+  // How long a cached error keeps short-circuiting calls for its access
+  // token. Zero turns the cache off.
+  std::chrono::milliseconds ttl = std::chrono::hours(1);
+  // The error codes that say an Item won't work again until its user does
+  // something (goes through Link update mode, say) or it is removed.
+  // Transient errors (rate limits, institution outages, PRODUCT_NOT_READY)
+  // aren't cached.
+  std::unordered_set<std::string> codes = {
+      "ITEM_LOGIN_REQUIRED",     "ITEM_LOCKED",
+      "ITEM_NOT_FOUND",          "ITEM_NOT_SUPPORTED",
+      "INVALID_ACCESS_TOKEN",    "INVALID_CREDENTIALS",
+      "INVALID_MFA",             "INVALID_UPDATED_USERNAME",
+      "ACCESS_NOT_GRANTED",      "USER_PERMISSION_REVOKED",
+      "NO_ACCOUNTS"};
+};
+
+// Remembers, per access token, the last error that left the Item unusable,
+// so that data calls for it (balances, transactions, ...) fail at once with
+// that same error instead of spending a round trip to be told again. Calls
+// that inspect or repair an Item (GetItem, RemoveItem, CreatePublicToken,
+// ...) are still sent. An Item returned without an error (by GetItem, say)
+// clears its token's entry, as does Clear once the Item has been fixed.
+//
+// Entries are sharded by token, and checking a token costs one atomic load
+// while the cache is empty.
+class ItemErrorCache {
+public:
+  ItemErrorCache();
+  ~ItemErrorCache();
+
+  ItemErrorCache(const ItemErrorCache &) = delete;
+  ItemErrorCache &operator=(const ItemErrorCache &) = delete;
+
+  void SetOptions(const ItemErrorCacheOptions &options);
+  ItemErrorCacheOptions Options() const;
+
+  // The cached error for access_token, or OK if there is none (or it has
+  // expired).
+  Status Check(const std::string &access_token) const;
+  // Caches status if it is one of the terminal Item errors.
+  void Record(const std::string &access_token, const Status &status);
+  void Clear(const std::string &access_token);
+  // Tokens with a cached error, counting expired entries that haven't been
+  // looked up since.
+  size_t Size() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Entry {
+    Status error;
+    Clock::time_point expires;
+  };
+
+  static const int kShards = 16;
+
+  struct Shard {
+    mutable std::mutex mu;
+    std::unordered_map<std::string, Entry> map;
+  };
+
+  Shard &ShardFor(const std::string &access_token) const;
+
+  mutable std::mutex options_mu_;
+  ItemErrorCacheOptions options_;
+  mutable Shard shards_[kShards];
+  mutable std::atomic<size_t> size_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_ITEM_ERRORS_H_
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef PLAID_METRICS_H_
+#define PLAID_METRICS_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace plaid {
+
+// A monotonically increasing counter that many threads can bump at once. The
+// count is spread over padded shards (one per thread, modulo the shard count)
+// so concurrent writers don't bounce a single cache line between cores;
+// reads sum the shards and are only as consistent as a snapshot needs to be.
+class Counter {
+public:
+  Counter();
+  ~Counter() = default;
+
+  Counter(const Counter &) = delete;
+  Counter &operator=(const Counter &) = delete;
+
+  void Add(uint64_t n = 1);
+  uint64_t Value() const;
+
+private:
+  static const int kShards = 16;
+  static const int kCacheLine = 64;
+
+  struct Shard {
+    std::atomic<uint64_t> value;
+    char pad[kCacheLine - sizeof(std::atomic<uint64_t>)];
+  };
+
+  Shard shards_[kShards];
+};
+
+// A point-in-time view of a Client's counters.
+struct ClientMetrics {
+  uint64_t requests = 0;
+  uint64_t request_errors = 0;
+  uint64_t parse_errors = 0;
+  // Response body bytes as transferred, and how many more they decoded to
+  // thanks to content encoding.
+  uint64_t bytes_received = 0;
+  uint64_t bytes_saved = 0;
+  // Duplicate requests sent by hedging, and how many of them beat the
+  // original.
+  uint64_t hedged_requests = 0;
+  uint64_t hedge_wins = 0;
+  // Calls failed without being sent because their institution's circuit
+  // breaker was open.
+  uint64_t breaker_rejections = 0;
+  // Data calls answered from the Item error cache without being sent.
+  uint64_t item_error_skips = 0;
+  // The adaptive limit on requests in flight; see Client::Concurrency.
+  uint64_t concurrency_limit = 0;
+};
+
+// A point-in-time view of an EventLoop's adaptive concurrency limit.
+struct ConcurrencyMetrics {
+  // Requests allowed in flight at once, as currently learned.
+  uint64_t limit = 0;
+  // Requests in flight, and waiting for a slot, as of the loop's last turn.
+  uint64_t in_flight = 0;
+  uint64_t waiting = 0;
+  // Times the limit was cut for overload or rising latency.
+  uint64_t cuts = 0;
+};
+
+// A point-in-time view of a WebhookServer's counters.
+struct WebhookMetrics {
+  // Webhooks accepted and queued for the handlers.
+  uint64_t received = 0;
+  // Requests answered with a 4xx: malformed, oversized, or not a webhook.
+  uint64_t rejected = 0;
+  // Webhooks turned away with 503 because the queue was full.
+  uint64_t overloaded = 0;
+};
+
+// A point-in-time view of a SyncScheduler's counters.
+struct SyncMetrics {
+  // Item syncs finished, and how many of them a webhook asked for.
+  uint64_t syncs = 0;
+  uint64_t webhook_syncs = 0;
+  // Syncs that found nothing new since the Item's previous one.
+  uint64_t unchanged = 0;
+  // Syncs where a read failed.
+  uint64_t failed = 0;
+};
+
+// A point-in-time view of a BalancePoller's counters.
+struct BalancePollMetrics {
+  uint64_t polls = 0;
+  // Polls whose balances differed from the previous poll's.
+  uint64_t changes = 0;
+  uint64_t failed = 0;
+};
+
+} // namespace plaid
+
+#endif // PLAID_METRICS_H_
\ No newline at end of file
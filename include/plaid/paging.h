@@ -0,0 +1,185 @@
+#ifndef PLAID_PAGING_H_
+#define PLAID_PAGING_H_
+
+#include "plaid/status.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace plaid {
+
+// Picks page sizes for an endpoint that is read page by page. A page's
+// latency is modelled as a fixed cost per request plus a cost per element,
+// fitted by least squares over the pages read so far (recent ones weighing
+// more); until there is enough spread in page sizes to tell the two apart,
+// a conservative prior fills in.
+//
+// Given that, a read of R remaining elements with P pages in flight takes
+// about (a + b n) for its first page and R / (n P) rounds in all, and
+// n = sqrt(R a / (P b)) balances the two: large pages where requests are
+// expensive, smaller ones where each element is. Reads that fit in one page
+// are done in one request.
+class PageSizer {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  PageSizer();
+  ~PageSizer() = default;
+
+  PageSizer(const PageSizer &) = delete;
+  PageSizer &operator=(const PageSizer &) = delete;
+
+  // A page of this many elements came back after latency.
+  void Record(int64_t elements, Clock::duration latency);
+
+  // The page size to ask for, between min_count and max_count. remaining is
+  // how many elements are left to read, or negative if that isn't known
+  // yet; parallel is how many pages will be in flight at once.
+  int64_t Next(int64_t remaining, int parallel, int64_t min_count,
+               int64_t max_count) const;
+
+private:
+  // Fits latency = fixed + per_element * elements, in microseconds.
+  void Fit(double &fixed, double &per_element) const;
+
+  mutable std::mutex mu_;
+  // Exponentially decayed sums over the samples.
+  double weight_ = 0;
+  double sum_n_ = 0;
+  double sum_t_ = 0;
+  double sum_nn_ = 0;
+  double sum_nt_ = 0;
+};
+
+// Most pages of an offset-paged read are requested at once, bounded so that
+// a long history doesn't flood the connection pool.
+const size_t kPagesInFlight = 8;
+
+// The largest page the offset-paged endpoints (transactions, investment
+// transactions, institutions) allow, and the smallest page worth a request.
+const int64_t kMaxPageSize = 500;
+const int64_t kMinPageSize = 50;
+
+// Collects pages 1..N-1 of an offset-paged read, given page 0, and hands
+// them all over in order once they are in, or the first failure once the
+// outstanding pages have settled. Whichever completion frees a slot issues
+// the next page.
+template <typename T> struct PagedRead {
+  // Same as Client's Callback<T>.
+  using PageCallback = std::function<void(StatusWrapped<T>)>;
+  using Fetch =
+      std::function<void(int64_t offset, int64_t count, PageCallback cb)>;
+  using Done = std::function<void(StatusWrapped<std::vector<T>>)>;
+
+  std::mutex mu;
+  std::vector<T> pages;
+  size_t next = 1;
+  size_t in_flight = 0;
+  size_t max_in_flight;
+  bool delivered = false;
+  Status status = Status::OK();
+  // Where page 1 starts; page i follows at (i - 1) * page_size.
+  int64_t offset;
+  int64_t page_size;
+  Fetch fetch;
+  Done done;
+
+  static void Start(T first, int64_t offset, int64_t page_size, size_t count,
+                    Fetch fetch, Done done,
+                    size_t max_in_flight = kPagesInFlight) {
+    auto self = std::make_shared<PagedRead>();
+    self->pages.resize(count == 0 ? 1 : count);
+    self->pages[0] = std::move(first);
+    self->max_in_flight = max_in_flight;
+    self->offset = offset;
+    self->page_size = page_size;
+    self->fetch = std::move(fetch);
+    self->done = std::move(done);
+    Pump(self);
+  }
+
+  static void Pump(const std::shared_ptr<PagedRead> &self) {
+    std::vector<size_t> issue;
+    bool finished = false;
+    {
+      std::lock_guard<std::mutex> lock(self->mu);
+      while (self->status.IsOk() && self->next < self->pages.size() &&
+             self->in_flight < self->max_in_flight) {
+        issue.push_back(self->next++);
+        ++self->in_flight;
+      }
+      if (self->in_flight == 0 && !self->delivered &&
+          (!self->status.IsOk() || self->next == self->pages.size())) {
+        self->delivered = true;
+        finished = true;
+      }
+    }
+    for (size_t page : issue) {
+      self->fetch(self->offset + (page - 1) * self->page_size,
+                  self->page_size, [self, page](StatusWrapped<T> res) {
+                    {
+                      std::lock_guard<std::mutex> lock(self->mu);
+                      if (res.IsOk())
+                        self->pages[page] = res.Take();
+                      else if (self->status.IsOk())
+                        self->status = res.GetStatus();
+                      --self->in_flight;
+                    }
+                    Pump(self);
+                  });
+    }
+    if (!finished)
+      return;
+    if (!self->status.IsOk())
+      return self->done(
+          StatusWrapped<std::vector<T>>::FromStatus(self->status));
+    self->done(StatusWrapped<std::vector<T>>(std::move(self->pages)));
+  }
+
+  // Reads first_size elements at offset to learn the total, then the rest
+  // as above, in pages of whatever size picks for what remains.
+  static void Read(int64_t offset, int64_t first_size, Fetch fetch,
+                   std::function<int64_t(const T &)> total,
+                   std::function<int64_t(int64_t remaining)> size, Done done,
+                   size_t max_in_flight = kPagesInFlight) {
+    auto first = [offset, first_size, fetch, total, size, done,
+                  max_in_flight](StatusWrapped<T> res) {
+      if (!res.IsOk())
+        return done(StatusWrapped<std::vector<T>>::FromStatus(
+            res.GetStatus()));
+      T page = res.Take();
+      const int64_t remaining = total(page) - offset - first_size;
+      if (remaining <= 0)
+        return Start(std::move(page), 0, 0, 1, fetch, done);
+      const int64_t page_size = size(remaining);
+      const size_t pages = 1 + (remaining - 1) / page_size + 1;
+      Start(std::move(page), offset + first_size, page_size, pages, fetch,
+            done, max_in_flight);
+    };
+    fetch(offset, first_size, first);
+  }
+};
+
+// Times a page for the endpoint's PageSizer on its way to cb.
+template <typename T>
+std::function<void(StatusWrapped<T>)>
+TimedPage(PageSizer &sizer, int (T::*elements)() const,
+          std::function<void(StatusWrapped<T>)> cb) {
+  const auto start = PageSizer::Clock::now();
+  return [&sizer, elements, start, cb](StatusWrapped<T> res) {
+    if (!res.IsOk())
+      return cb(std::move(res));
+    T page = res.Take();
+    sizer.Record((page.*elements)(), PageSizer::Clock::now() - start);
+    cb(StatusWrapped<T>(std::move(page)));
+  };
+}
+
+} // namespace plaid
+
+#endif // PLAID_PAGING_H_
\ No newline at end of file
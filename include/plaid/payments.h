@@ -0,0 +1,129 @@
+#ifndef PLAID_PAYMENTS_H_
+#define PLAID_PAYMENTS_H_
+
+#include "plaid/call_options.h"
+#include "plaid/client.h"
+#include "plaid/paging.h"
+#include "plaid/plaid.pb.h"
+#include "plaid/status.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace plaid {
+
+// Walks ListPayments page by page, following next_cursor. While the caller
+// works through one page the next is already being fetched, so a loop over
+// the stream rarely waits on the network. At most two pages are held ahead
+// of the caller: the rest of the one being read, and the next. Unless
+// options.count is set, each page is sized by the client's PageSizer for
+// ListPayments.
+//
+//   PaymentStream payments(*client);
+//   for (const Payment &payment : payments)
+//     ...;
+//   if (!payments.GetStatus().IsOk())
+//     ...;
+//
+// The stream blocks while waiting for a page. Don't read it from inside a
+// client callback.
+class PaymentStream {
+public:
+  // Ends the stream at the first payment it returns true for, without
+  // yielding that payment or fetching any page after it. Reconciliation jobs
+  // use it to stop once they reach payments they have already seen.
+  using StopPredicate = std::function<bool(const Payment &)>;
+
+  class Iterator {
+  public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Payment;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Payment *;
+    using reference = const Payment &;
+
+    Iterator() : stream_(nullptr) {}
+    explicit Iterator(PaymentStream *stream);
+
+    const Payment &operator*() const { return current_; }
+    const Payment *operator->() const { return &current_; }
+    Iterator &operator++();
+    bool operator==(const Iterator &rhs) const {
+      return stream_ == rhs.stream_;
+    }
+    bool operator!=(const Iterator &rhs) const { return !(*this == rhs); }
+
+  private:
+    PaymentStream *stream_;
+    Payment current_;
+  };
+
+  // Starts fetching the first page (from options.cursor, if set) right away.
+  explicit PaymentStream(Client &client,
+                         const ListPaymentsOptions &options =
+                             ListPaymentsOptions(),
+                         StopPredicate stop = nullptr,
+                         const CallOptions &call = CallOptions());
+  // Cancels a page still in flight and waits for it to settle.
+  ~PaymentStream();
+
+  PaymentStream(const PaymentStream &) = delete;
+  PaymentStream &operator=(const PaymentStream &) = delete;
+
+  // Moves the next payment into out. False once the payments run out, the
+  // stop predicate fires, or a page fails to load (see GetStatus).
+  bool Next(Payment &out);
+  // Why the stream ended early, or OK.
+  Status GetStatus() const;
+
+  // Single-pass: every iterator draws from the same stream.
+  Iterator begin() { return Iterator(this); }
+  Iterator end() { return Iterator(); }
+
+private:
+  // Shared with the callbacks of pages in flight.
+  struct State {
+    Client *client;
+    ListPaymentsOptions options;
+    StopPredicate stop;
+    // The caller's options, but with cancel, which the caller's token
+    // cancels in turn, so the destructor can drop a page in flight.
+    CallOptions call;
+    CancellationToken cancel;
+    CancellationToken caller;
+    uint64_t caller_listener = 0;
+    // Set when the caller left the page size to the client's PageSizer.
+    PageSizer *sizer;
+    PageSizer::Clock::time_point fetch_start;
+    // Fetch another page once no more than this many payments are buffered.
+    size_t low_water;
+
+    std::mutex mu;
+    std::condition_variable cv;
+    std::deque<Payment> ready;
+    bool fetching = false;
+    bool exhausted = false;
+    Status status = Status::OK();
+  };
+
+  // Waits under lock until done() holds. On a pool worker it runs other
+  // pool tasks meanwhile, since the page it waits for is parsed there.
+  void Wait(std::unique_lock<std::mutex> &lock,
+            const std::function<bool()> &done);
+  static void MaybeFetch(const std::shared_ptr<State> &state,
+                         std::unique_lock<std::mutex> &lock);
+  static void OnPage(const std::shared_ptr<State> &state,
+                     StatusWrapped<ListPaymentsResponse> res);
+
+  std::shared_ptr<State> state_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_PAYMENTS_H_
\ No newline at end of file
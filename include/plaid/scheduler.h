@@ -0,0 +1,291 @@
+#ifndef PLAID_SCHEDULER_H_
+#define PLAID_SCHEDULER_H_
+
+#include "plaid/call_options.h"
+#include "plaid/client.h"
+#include "plaid/metrics.h"
+#include "plaid/plaid.pb.h"
+#include "plaid/status.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace plaid {
+
+struct SyncSchedulerOptions {
+  // Each sync reads this many days of transactions, ending today, and up to
+  // count of them (the API's page size, at most 500).
+  int days = 30;
+  int count = 500;
+  // Whether each sync also reads balances.
+  bool balances = true;
+  // An Item that just changed is synced again after min_interval. Every sync
+  // that finds nothing new multiplies the interval by backoff, up to
+  // max_interval, so quiet Items cost fewer and fewer calls.
+  std::chrono::seconds min_interval = std::chrono::minutes(15);
+  std::chrono::seconds max_interval = std::chrono::hours(24);
+  double backoff = 2;
+  // Items synced at once.
+  size_t max_in_flight = 8;
+  // Syncs are background work, so they wait behind other calls when the
+  // client is at its concurrency limit.
+  CallOptions call = CallOptions().WithPriority(Priority::kBatch);
+};
+
+// What one sync of an Item read.
+struct SyncResult {
+  std::string item_id;
+  std::string access_token;
+  GetTransactionsResponse transactions;
+  // Empty unless SyncSchedulerOptions::balances is set.
+  GetBalancesResponse balances;
+  // The first read that failed, or OK.
+  Status status = Status::OK();
+  // Whether the transactions or balances differ from the Item's previous
+  // sync. The first sync of an Item always counts as a change.
+  bool changed = false;
+  // Whether a webhook asked for this sync.
+  bool from_webhook = false;
+};
+
+// Keeps a set of Items fresh without polling each on a fixed clock. Items
+// wait in a queue ordered by when they are next due; transaction webhooks
+// (DEFAULT_UPDATE, HISTORICAL_UPDATE, TRANSACTIONS_REMOVED, ...) move their
+// Item to the front, and Items whose syncs keep coming back unchanged back
+// off towards max_interval. Calls thus follow what actually changes.
+//
+//   SyncScheduler scheduler(*client, [](const SyncResult &result) { ... });
+//   scheduler.Add(item_id, access_token);
+//   scheduler.Start();
+//   server.On("TRANSACTIONS", [&](const WebhookEvent &event) {
+//     scheduler.OnWebhook(event.webhook);
+//   });
+//
+// The handler runs on the client's worker pool, one call per sync; it
+// should not block for long.
+class SyncScheduler {
+public:
+  using Handler = std::function<void(const SyncResult &)>;
+
+  SyncScheduler(Client &client, Handler handler,
+                const SyncSchedulerOptions &options = SyncSchedulerOptions());
+  // Stops the scheduler if it is running.
+  ~SyncScheduler();
+
+  SyncScheduler(const SyncScheduler &) = delete;
+  SyncScheduler &operator=(const SyncScheduler &) = delete;
+
+  // Adds an Item, due for its first sync right away. Adding an Item again
+  // replaces its access token.
+  void Add(const std::string &item_id, const std::string &access_token);
+  // Drops an Item. A sync already in flight still reports to the handler.
+  void Remove(const std::string &item_id);
+  // Moves the webhook's Item to the front of the queue if the webhook says
+  // its transactions changed; returns whether it did. A webhook for an Item
+  // being synced right now gets it synced again once that sync is done.
+  bool OnWebhook(const Webhook &webhook);
+
+  void Start();
+  // Waits for the syncs in flight; the handler isn't called after Stop
+  // returns.
+  void Stop();
+
+  // The current time between syncs of an Item; zero if unknown.
+  std::chrono::seconds Interval(const std::string &item_id) const;
+  size_t Size() const;
+  SyncMetrics Metrics() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Item {
+    std::string access_token;
+    std::chrono::seconds interval;
+    // Set by Add, so a sync that started before the Item was removed and
+    // added again can tell that the Item is no longer the one it synced.
+    uint64_t generation = 0;
+    // Bumped whenever the Item is queued, so that older queue entries for it
+    // can be told apart and skipped.
+    uint64_t version = 0;
+    // A hash of the last sync's transactions and balances.
+    size_t fingerprint = 0;
+    bool synced = false;
+    bool in_flight = false;
+    // A webhook arrived while the Item was in flight.
+    bool webhook_pending = false;
+  };
+
+  struct Scheduled {
+    Clock::time_point due;
+    // Breaks ties in arrival order, which keeps webhooks first come, first
+    // served.
+    uint64_t seq;
+    uint64_t version;
+    bool from_webhook;
+    std::string item_id;
+
+    bool operator>(const Scheduled &rhs) const {
+      return due != rhs.due ? due > rhs.due : seq > rhs.seq;
+    }
+  };
+
+  struct Sync;
+
+  // Queues the Item; requires mu_.
+  void Schedule(const std::string &item_id, Item &item, Clock::time_point due,
+                bool from_webhook);
+  void Run();
+  void StartSync(const std::string &item_id, const std::string &access_token,
+                 uint64_t generation, bool from_webhook);
+  void Finish(Sync &sync);
+
+  Client &client_;
+  Handler handler_;
+  SyncSchedulerOptions options_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, Item> items_;
+  std::priority_queue<Scheduled, std::vector<Scheduled>,
+                      std::greater<Scheduled>>
+      queue_;
+  uint64_t seq_ = 0;
+  uint64_t generations_ = 0;
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+  std::thread thread_;
+
+  Counter syncs_;
+  Counter webhook_syncs_;
+  Counter unchanged_;
+  Counter failed_;
+};
+
+struct BalancePollerOptions {
+  // Bounds on the time between polls of one access token.
+  std::chrono::seconds min_interval = std::chrono::minutes(5);
+  std::chrono::seconds max_interval = std::chrono::hours(24);
+  // The time between changes assumed for an access token until one has been
+  // observed.
+  std::chrono::seconds initial_interval = std::chrono::hours(1);
+  // Weight of the latest gap between changes in the running average.
+  double alpha = 0.3;
+  // Polls happen this fraction of the expected time between changes apart,
+  // so a change is usually seen well before the next one.
+  double fraction = 0.5;
+  // Access tokens polled at once.
+  size_t max_in_flight = 8;
+  // Polls are background work, as for SyncSchedulerOptions.
+  CallOptions call = CallOptions().WithPriority(Priority::kBatch);
+};
+
+// What one poll of an access token read.
+struct BalanceUpdate {
+  std::string access_token;
+  GetBalancesResponse balances;
+  Status status = Status::OK();
+  // Whether any account's current or available balance differs from the
+  // previous poll. The first poll of an access token never counts.
+  bool changed = false;
+};
+
+// Polls GetBalances for Items that send no webhooks, as often as each one's
+// balances actually change. Every access token keeps an exponentially
+// weighted average of the time between observed changes, and is polled a
+// fraction of that apart, within min_interval and max_interval. An account
+// that has been quiet for longer than its average is treated as changing at
+// least that rarely, so dormant accounts drift towards max_interval while
+// busy ones stay near min_interval.
+//
+// The handler runs on the client's worker pool, once per poll.
+class BalancePoller {
+public:
+  using Handler = std::function<void(const BalanceUpdate &)>;
+
+  BalancePoller(Client &client, Handler handler,
+                const BalancePollerOptions &options = BalancePollerOptions());
+  // Stops the poller if it is running.
+  ~BalancePoller();
+
+  BalancePoller(const BalancePoller &) = delete;
+  BalancePoller &operator=(const BalancePoller &) = delete;
+
+  // Adds an access token, due for its first poll right away.
+  void Add(const std::string &access_token);
+  void Remove(const std::string &access_token);
+
+  void Start();
+  // Waits for the polls in flight; the handler isn't called after Stop
+  // returns.
+  void Stop();
+
+  // The current time between polls of an access token; zero if unknown.
+  std::chrono::seconds Interval(const std::string &access_token) const;
+  size_t Size() const;
+  BalancePollMetrics Metrics() const;
+
+private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Token {
+    // The average time between changes, in seconds; zero until a change has
+    // been seen.
+    double mean_gap = 0;
+    // When the balances were last seen to change, or were first read.
+    Clock::time_point last_change;
+    std::chrono::seconds interval;
+    // Set by Add, as for SyncScheduler's Items.
+    uint64_t generation = 0;
+    uint64_t version = 0;
+    size_t fingerprint = 0;
+    bool polled = false;
+    bool in_flight = false;
+  };
+
+  struct Scheduled {
+    Clock::time_point due;
+    uint64_t version;
+    std::string access_token;
+
+    bool operator>(const Scheduled &rhs) const { return due > rhs.due; }
+  };
+
+  // Queues the access token; requires mu_.
+  void Schedule(const std::string &access_token, Token &token,
+                Clock::time_point due);
+  void Run();
+  void Finish(const std::string &access_token, uint64_t generation,
+              StatusWrapped<GetBalancesResponse> res);
+
+  Client &client_;
+  Handler handler_;
+  BalancePollerOptions options_;
+
+  mutable std::mutex mu_;
+  std::condition_variable cv_;
+  std::unordered_map<std::string, Token> tokens_;
+  std::priority_queue<Scheduled, std::vector<Scheduled>,
+                      std::greater<Scheduled>>
+      queue_;
+  uint64_t generations_ = 0;
+  size_t in_flight_ = 0;
+  bool stopping_ = false;
+  std::thread thread_;
+
+  Counter polls_;
+  Counter changes_;
+  Counter failed_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_SCHEDULER_H_
\ No newline at end of file
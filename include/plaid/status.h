@@ -13,19 +13,58 @@ public:
   static Status ParseError(const std::string &description);
   static Status RequestError(const std::string &description);
   static Status MissingInfo(const std::string &description);
+  static Status Cancelled(const std::string &description);
+  static Status Timeout(const std::string &description);
+  // A Timeout for a call whose deadline passed before it was sent, which
+  // says nothing about the server.
+  static Status LocalTimeout(const std::string &description);
+  static Status IOError(const std::string &description);
+  static Status VerificationError(const std::string &description);
+  // An error response from the API, with its error_type and error_code
+  // (INSTITUTION_ERROR / INSTITUTION_DOWN, ITEM_ERROR / ITEM_LOGIN_REQUIRED,
+  // ...).
+  static Status ApiError(const std::string &error_type,
+                         const std::string &error_code,
+                         const std::string &description);
+  // The call wasn't sent because its institution is known to be failing.
+  static Status Unavailable(const std::string &description);
 
   bool IsOk() const;
   bool IsParseError() const;
   bool IsRequestError() const;
   bool IsMissingInfo() const;
+  bool IsCancelled() const;
+  bool IsTimeout() const;
+  bool IsLocalTimeout() const;
+  bool IsIOError() const;
+  bool IsVerificationError() const;
+  bool IsApiError() const;
+  bool IsUnavailable() const;
 
   std::string CodeDesc() const;
   std::string Description() const;
+  // Set for API errors only.
+  const std::string &ErrorType() const;
+  const std::string &ErrorCode() const;
 
 private:
-  enum class Code { kOk, kParseError, kRequestError, kMissingInfo };
+  enum class Code {
+    kOk,
+    kParseError,
+    kRequestError,
+    kMissingInfo,
+    kCancelled,
+    kTimeout,
+    kIOError,
+    kVerificationError,
+    kApiError,
+    kUnavailable
+  };
   Code code_;
   std::string description_;
+  std::string error_type_;
+  std::string error_code_;
+  bool local_ = false;
 
   Status() noexcept;
   Status(Code code, const std::string &description);
@@ -51,6 +90,10 @@ public:
   bool IsOk() const { return status_.IsOk(); }
   Status GetStatus() const { return status_; }
   T Unwrap() const { return value_; }
+  // Looks at the value in place, without copying it.
+  const T &Get() const { return value_; }
+  // Moves the value out rather than copying it, leaving this one empty.
+  T Take() { return std::move(value_); }
 
   std::string DescribeStatus() const {
     return status_.CodeDesc() + " (" + status_.Description() + ")";
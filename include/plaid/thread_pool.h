@@ -0,0 +1,60 @@
+#ifndef PLAID_THREAD_POOL_H_
+#define PLAID_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace plaid {
+
+// A work-stealing pool for CPU-bound work (response parsing, conversions).
+// Each worker owns a deque: it pushes and pops its own work from the back,
+// and idle workers steal from the front of their siblings' deques, which
+// keeps uneven batches balanced without a single shared queue. Submitting
+// from many threads at once only contends on the per-worker deques, and the
+// idle lock is taken only when a worker is actually asleep.
+class ThreadPool {
+public:
+  // A size of zero sizes the pool to the number of hardware threads.
+  explicit ThreadPool(size_t threads = 0);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  void Submit(std::function<void()> task);
+
+  // Runs a single queued task on the calling thread, if the caller is one of
+  // this pool's workers and there is work available. Lets a worker that is
+  // blocked on a result help drain the pool instead of deadlocking it.
+  bool RunPendingTask();
+  bool InWorkerThread() const;
+  size_t Size() const;
+
+private:
+  struct Queue {
+    std::mutex mu;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool PopTask(size_t self, std::function<void()> &task);
+  void WorkerLoop(size_t index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::atomic<size_t> next_queue_;
+  std::atomic<size_t> pending_;
+  std::atomic<size_t> sleeping_;
+  std::mutex idle_mu_;
+  std::condition_variable idle_cv_;
+  bool stopping_ = false;
+};
+
+} // namespace plaid
+
+#endif // PLAID_THREAD_POOL_H_
\ No newline at end of file
@@ -1,26 +1,52 @@
 #ifndef PLAID_TRANSPORT_H_
 #define PLAID_TRANSPORT_H_
 
+#include "plaid/call_options.h"
+#include "plaid/concurrency.h"
 #include "plaid/status.h"
 
+#include <atomic>
 #include <curl/curl.h>
+#include <deque>
+#include <functional>
 #include <google/protobuf/util/json_util.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
+#include <unordered_map>
+#include <vector>
 
 namespace plaid {
 
+class EventLoop;
 class Request;
+class ThreadPool;
 
 class Response {
   friend class Request;
 
 public:
   Response() = default;
-  ~Response() = default;
+  Response(const Response &rhs) = default;
+  Response(Response &&rhs) = default;
+  Response &operator=(const Response &rhs) = default;
+  Response &operator=(Response &&rhs) = default;
+  // Hands the body's buffer back for reuse by a later request.
+  ~Response();
 
   long StatusCode() const;
   std::string Body() const;
+  size_t BodySize() const;
+  // Size of the body as it came over the wire, before content decoding.
+  size_t WireSize() const;
+  // For an error response (HTTP 400 and up), the API error it carries; OK
+  // otherwise.
+  Status ErrorStatus() const;
 
   template <class T> StatusWrapped<T> Parse() const {
     static_assert(
@@ -31,32 +57,273 @@ public:
     google::protobuf::util::Status s = JsonStringToMessage(body_, &msg);
     if (!s.ok())
       return StatusWrapped<T>::FromStatus(
-          Status::ParseError(s.error_message()));
+          Status::ParseError(std::string(s.message())));
     return msg;
   }
 
 private:
-  Response(long status_code, const std::string &body);
+  Response(long status_code, std::string body, size_t wire_size);
 
-  long status_code_;
+  long status_code_ = 0;
   std::string body_;
+  size_t wire_size_ = 0;
 };
 
 class Request {
+  friend class EventLoop;
+
 public:
   explicit Request(const std::string &url);
   ~Request();
 
+  // The easy handle points back at the Request (see Prepare), so it stays
+  // put; requests are handed around by unique_ptr instead.
+  Request(const Request &) = delete;
+  Request &operator=(const Request &) = delete;
+
   void AddHeader(const std::string &key, const std::string &value);
   void SetBody(const google::protobuf::Message &msg);
+  // Like SetBody, but the body starts with prefix: an already rendered "{"
+  // plus fields (the client's credentials, say) that msg leaves unset. The
+  // two parts are streamed to curl back to back rather than concatenated,
+  // so prefix must outlive the request.
+  void SetBody(const google::protobuf::Message &msg, const std::string *prefix);
+  void SetCallOptions(const CallOptions &call);
   StatusWrapped<Response> Execute();
 
 private:
+  static size_t WriteCallback(char *data, size_t len, size_t nmemb,
+                              void *userp);
+  static size_t ReadCallback(char *data, size_t len, size_t nmemb,
+                             void *userp);
+  static int SeekCallback(void *userp, curl_off_t offset, int origin);
+
+  // Points the easy handle at this object's buffers and sets the time left
+  // before the deadline, so this runs right before the transfer starts.
+  CURL *Prepare();
+  StatusWrapped<Response> Finish(CURLcode res);
+
   CURL *curl_ = nullptr;
   curl_slist *headers_ = nullptr;
   Status status_;
+  const std::string *prefix_ = nullptr;
   std::string request_buf_;
+  size_t read_pos_ = 0;
   std::string response_buf_;
+  CallOptions::Clock::time_point deadline_ =
+      CallOptions::Clock::time_point::max();
+  CancellationToken cancel_ = CancellationToken::None();
+  Priority priority_ = Priority::kNormal;
+  std::string tenant_;
+};
+
+// Drives many Requests concurrently on a single curl_multi handle, from one
+// dedicated I/O thread. Completions are invoked on that thread, so they
+// should hand any real work off elsewhere (see ThreadPool).
+//
+// Submit may be called from any number of threads at once: new transfers are
+// pushed onto a lock-free stack that the I/O thread takes over wholesale on
+// each turn of the loop. Cancelling a request's token wakes the loop, which
+// drops the transfer immediately rather than waiting for curl to notice.
+// Timers are handed over the same way and run between turns.
+//
+// All transfers share the loop's connections, DNS cache and TLS sessions, so
+// every client on the loop reuses the same warm connections.
+//
+// How many transfers run at once is set by an adaptive ConcurrencyLimit;
+// the rest wait their turn by priority and tenant (see Priority), and still
+// fail promptly if they are cancelled or their deadline passes while
+// waiting.
+class EventLoop {
+public:
+  using Completion = std::function<void(StatusWrapped<Response>)>;
+
+  EventLoop();
+  ~EventLoop();
+
+  EventLoop(const EventLoop &) = delete;
+  EventLoop &operator=(const EventLoop &) = delete;
+
+  // owner, if given, lets CancelOwned fail the transfer later.
+  void Submit(std::unique_ptr<Request> req, Completion done,
+              const void *owner = nullptr);
+  // Fails every transfer submitted so far on owner's behalf with a
+  // Cancelled status, as if each had been cancelled.
+  void CancelOwned(const void *owner);
+
+  // Runs fn on the I/O thread once the given time has passed. Like
+  // completions, it should be quick. Timers still pending at shutdown are
+  // dropped without running.
+  void Schedule(CallOptions::Clock::time_point at, std::function<void()> fn);
+
+  ConcurrencyLimit &Limit();
+
+private:
+  struct Transfer {
+    std::unique_ptr<Request> req;
+    Completion done;
+    uint64_t cancel_listener = 0;
+    const void *owner = nullptr;
+    ConcurrencyLimit::Clock::time_point started;
+    Transfer *next = nullptr;
+  };
+
+  // Transfers waiting for a slot, served by start-time fair queuing. Each
+  // (priority, tenant) pair is a flow whose transfers are tagged, in virtual
+  // time, one share of its class's weight apart, starting no earlier than
+  // the tag last served; the smallest tag goes next, and between equal tags
+  // the higher priority. A busy flow's tags run ahead of the others', so a
+  // flow that was idle gets its next transfer in at once, ahead of lower
+  // classes, and an interactive flow, whose shares are smallest, stays
+  // ahead of nearly everything.
+  //
+  // Deadlines are indexed separately, so expiring transfers doesn't mean
+  // scanning the queue: an expired transfer is taken out where it stands,
+  // leaving an empty slot behind for its flow to skip.
+  class WaitQueue {
+  public:
+    void Push(std::unique_ptr<Transfer> transfer);
+    std::unique_ptr<Transfer> Pop();
+    bool Empty() const { return size_ == 0; }
+    size_t Size() const { return size_; }
+    // The earliest deadline of any waiting transfer, or max() if none has
+    // one.
+    CallOptions::Clock::time_point NextDeadline() const;
+    // Removes and returns the transfers whose deadline is at or before now.
+    std::vector<std::unique_ptr<Transfer>>
+    Expire(CallOptions::Clock::time_point now);
+    // Removes and returns the transfers that match, looking at every one.
+    std::vector<std::unique_ptr<Transfer>>
+    RemoveIf(const std::function<bool(const Transfer &)> &match);
+
+  private:
+    struct Flow;
+    struct Tagged;
+    struct Slot {
+      Flow *flow;
+      Tagged *tagged;
+    };
+    using Deadlines = std::multimap<CallOptions::Clock::time_point, Slot>;
+    struct Tagged {
+      double tag;
+      uint64_t seq;
+      // Null once the transfer has been taken out early.
+      std::unique_ptr<Transfer> transfer;
+      // Its entry in deadlines_, or deadlines_.end() if it has none.
+      Deadlines::iterator deadline;
+    };
+    struct Flow {
+      // Elements stay put as the ends change, so Slots can point into it.
+      std::deque<Tagged> queue;
+      // Transfers still in queue, not counting empty slots. The front is
+      // always one of them.
+      size_t live = 0;
+      double finish = 0;
+      int priority = 0;
+    };
+    // Ordered by the tag, priority and sequence number of each flow's first
+    // transfer.
+    using Head = std::pair<std::tuple<double, int, uint64_t>, Flow *>;
+
+    static Head HeadOf(Flow &flow);
+    // Pops the empty slots at the front of the flow's queue.
+    static void TrimFront(Flow &flow);
+    // Takes one waiting transfer out from wherever it is in its flow.
+    std::unique_ptr<Transfer> Take(Slot slot);
+    // Drops idle flows that no longer carry any credit. Without a backlog
+    // every transfer passes straight through, so this also runs whenever
+    // idle flows pile up.
+    void Purge();
+
+    std::unordered_map<std::string, Flow> flows_;
+    std::set<Head> heads_;
+    Deadlines deadlines_;
+    double virtual_time_ = 0;
+    uint64_t seq_ = 0;
+    size_t size_ = 0;
+  };
+
+  struct Timer {
+    CallOptions::Clock::time_point at;
+    std::function<void()> fn;
+    Timer *next = nullptr;
+  };
+
+  void Run();
+  // Takes over the submitted transfers. Runs on the I/O thread, or in
+  // Submit once the loop is stopping.
+  std::vector<std::unique_ptr<Transfer>> TakeIncoming();
+  void RunTimers();
+  int PollTimeoutMs() const;
+  void Start(std::unique_ptr<Transfer> transfer);
+  // Starts waiting transfers while the limit allows.
+  void StartWaiting();
+  // Whether transfer was cancelled, by its own token or along with the rest
+  // of its owner's.
+  static bool Cancelled(const Transfer &transfer,
+                        const std::vector<const void *> &owners);
+  // Fails waiting transfers whose deadline has passed.
+  void ExpireWaiting();
+  void AbortCancelled();
+  std::unique_ptr<Transfer> Remove(CURL *handle);
+  void Complete(CURL *handle, CURLcode res);
+  void Fail(std::unique_ptr<Transfer> transfer, Status status);
+
+  static void LockShare(CURL *, curl_lock_data data, curl_lock_access,
+                        void *userp);
+  static void UnlockShare(CURL *, curl_lock_data data, void *userp);
+
+  CURLM *multi_ = nullptr;
+  CURLSH *share_ = nullptr;
+  // Handles are cleaned up on whichever thread drops their request, so the
+  // share is locked even though transfers only run on the I/O thread.
+  std::mutex share_mu_[CURL_LOCK_DATA_LAST];
+  std::mutex owners_mu_;
+  std::vector<const void *> cancelled_owners_;
+  std::atomic<Transfer *> incoming_;
+  std::atomic<Timer *> incoming_timers_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> cancel_pending_;
+  std::unordered_map<CURL *, std::unique_ptr<Transfer>> active_;
+  WaitQueue waiting_;
+  ConcurrencyLimit limit_;
+  std::multimap<CallOptions::Clock::time_point, std::function<void()>> timers_;
+  std::thread thread_;
+};
+
+// The machinery that carries a client's calls: an EventLoop, with its
+// connections, DNS cache and TLS sessions, and the worker pool responses are
+// parsed on. Every Client gets its own unless it is given one, and a process
+// serving many client_ids can hand one Transport to all of their Clients,
+// so that they share warm connections and the concurrency limit instead of
+// each paying for handshakes:
+//
+//   auto transport = plaid::Transport::Create();
+//   auto a = plaid::Client::Create(tenant_a, transport);
+//   auto b = plaid::Client::Create(tenant_b, transport);
+//
+// Clients keep their own credentials, counters, breakers and caches, and
+// each Client's calls wait their turn as their own tenants (see
+// CallOptions::tenant). The Transport lives as long as any Client using it.
+class Transport {
+public:
+  // A size of zero sizes the worker pool to the number of hardware threads.
+  static std::shared_ptr<Transport> Create(size_t threads = 0);
+  ~Transport();
+
+  Transport(const Transport &) = delete;
+  Transport &operator=(const Transport &) = delete;
+
+  ThreadPool &Pool();
+  EventLoop &Loop();
+
+private:
+  explicit Transport(size_t threads);
+
+  std::unique_ptr<ThreadPool> pool_;
+  // Declared last, so it shuts down (failing anything still in flight) while
+  // the pool is still around to deliver those failures.
+  std::unique_ptr<EventLoop> loop_;
 };
 
 } // namespace plaid
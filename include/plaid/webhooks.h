@@ -0,0 +1,204 @@
+#ifndef PLAID_WEBHOOKS_H_
+#define PLAID_WEBHOOKS_H_
+
+#include "plaid/metrics.h"
+#include "plaid/plaid.pb.h"
+#include "plaid/status.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace plaid {
+
+class Client;
+
+// A webhook as it arrived: the decoded payload, plus the raw body and the
+// Plaid-Verification header (a signed JWT) needed to check that Plaid sent
+// it.
+struct WebhookEvent {
+  Webhook webhook;
+  std::string body;
+  std::string verification;
+};
+
+struct WebhookServerOptions {
+  std::string address = "0.0.0.0";
+  // Zero picks a free port; see WebhookServer::Port.
+  uint16_t port = 0;
+  // Only POSTs to this path are accepted. Empty accepts any path.
+  std::string path = "/";
+  // Threads accepting and reading connections, each with its own epoll set
+  // and listening socket.
+  int io_threads = 2;
+  size_t max_body_size = 1 << 20;
+  // Webhooks waiting for the handlers. Past this, new webhooks are answered
+  // with 503 so that Plaid retries them later.
+  size_t max_queued = 1 << 16;
+  // Keep-alive connections that stay quiet this long are closed.
+  std::chrono::seconds idle_timeout = std::chrono::seconds(60);
+};
+
+// An embedded HTTP endpoint for Plaid webhooks. It is built on epoll, so the
+// library only includes it on Linux. Connections are spread over a few epoll
+// threads, one listening socket each (SO_REUSEPORT), and kept alive between
+// requests; no thread is tied to a connection. Each request is answered as
+// soon as its payload has been decoded and queued, and a dispatcher thread
+// hands the queued webhooks to the handlers in the order they were accepted.
+// The queue is a lock-free stack the dispatcher takes over wholesale, so
+// request threads never wait on a handler.
+//
+//   WebhookServer server(options);
+//   server.On("TRANSACTIONS", [](const WebhookEvent &event) { ... });
+//   server.Start();
+//
+// Handlers run one at a time on the dispatcher thread and should hand long
+// work (API calls, say) off elsewhere.
+class WebhookServer {
+public:
+  using Handler = std::function<void(const WebhookEvent &)>;
+
+  explicit WebhookServer(
+      const WebhookServerOptions &options = WebhookServerOptions());
+  // Stops the server if it is running.
+  ~WebhookServer();
+
+  WebhookServer(const WebhookServer &) = delete;
+  WebhookServer &operator=(const WebhookServer &) = delete;
+
+  // Registers a handler for one webhook_type ("TRANSACTIONS", "ITEM",
+  // "ASSETS", ...); an empty type receives every webhook. Handlers must be
+  // registered before Start.
+  void On(const std::string &webhook_type, Handler handler);
+
+  // Binds the listening sockets and starts the threads.
+  Status Start();
+  // Stops accepting, closes every connection, and returns once the
+  // webhooks already accepted have been handled.
+  void Stop();
+
+  // The bound port, once started.
+  uint16_t Port() const;
+  WebhookMetrics Metrics() const;
+
+private:
+  struct Connection;
+  struct Worker;
+
+  struct Queued {
+    WebhookEvent event;
+    Queued *next = nullptr;
+  };
+
+  void Serve(Worker &worker);
+  void Accept(Worker &worker);
+  void Read(Worker &worker, int fd);
+  void Flush(Worker &worker, int fd);
+  void Close(Worker &worker, int fd);
+  // Handles every complete request buffered on the connection.
+  void HandleRequests(Connection &conn);
+  // Decodes and queues one request; returns the status line to answer with.
+  const char *HandleWebhook(const std::string &target, std::string body,
+                            std::string verification);
+
+  void Enqueue(Queued *item);
+  void Dispatch();
+
+  WebhookServerOptions options_;
+  std::unordered_map<std::string, std::vector<Handler>> handlers_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  uint16_t port_ = 0;
+  bool started_ = false;
+  std::atomic<bool> stopping_;
+
+  std::atomic<Queued *> queue_;
+  std::atomic<size_t> queued_;
+  std::atomic<bool> dispatcher_sleeping_;
+  bool dispatch_stopping_ = false;
+  std::mutex dispatch_mu_;
+  std::condition_variable dispatch_cv_;
+  std::thread dispatcher_;
+
+  Counter received_;
+  Counter rejected_;
+  Counter overloaded_;
+};
+
+struct WebhookVerifierOptions {
+  // How long a fetched key is used before it is fetched again. Webhooks keep
+  // verifying against the old key while the new one is on its way.
+  std::chrono::seconds key_ttl = std::chrono::hours(24);
+  // Tokens issued longer ago than this are rejected, so a captured webhook
+  // can't be replayed later.
+  std::chrono::seconds max_age = std::chrono::minutes(5);
+  // A key id whose fetch failed gets the same error back for this long
+  // before it is tried again (a key that failed to refresh keeps being used
+  // meanwhile), so webhooks with a made-up key id can't each cost a fetch.
+  std::chrono::seconds miss_ttl = std::chrono::seconds(30);
+  // Key ids remembered at once. Past this, those that failed to resolve are
+  // forgotten first, then the keys fetched longest ago.
+  size_t max_keys = 1024;
+};
+
+// Checks that a webhook was sent by Plaid: the Plaid-Verification header is
+// an ES256-signed JWT whose payload carries the SHA-256 of the body. Keys
+// are fetched by key id the first time they are seen and cached, with one
+// fetch per key however many webhooks arrive while it is in flight, so
+// steady-state verification never leaves the process. Tokens and hashes are
+// decoded into fixed buffers on the stack, and each thread keeps its OpenSSL
+// verification context between calls.
+//
+// Verify may block on a key fetch, so call it from a webhook handler rather
+// than from inside a client callback. The verifier uses OpenSSL 3, and the
+// library only includes it when libcrypto is found.
+class WebhookVerifier {
+public:
+  explicit WebhookVerifier(
+      Client &client,
+      const WebhookVerifierOptions &options = WebhookVerifierOptions());
+  ~WebhookVerifier();
+
+  WebhookVerifier(const WebhookVerifier &) = delete;
+  WebhookVerifier &operator=(const WebhookVerifier &) = delete;
+
+  // OK if the token is valid, recent, signed by a current Plaid key, and
+  // matches the body; a VerificationError (or the key fetch's error)
+  // otherwise.
+  Status Verify(const std::string &body, const std::string &verification);
+  Status Verify(const WebhookEvent &event);
+
+private:
+  struct Key;
+  struct Flight;
+  struct Entry {
+    std::shared_ptr<const Key> key;
+    std::chrono::steady_clock::time_point fetched;
+    // The last fetch's error, and when it came back, if it failed.
+    Status failure = Status::OK();
+    std::chrono::steady_clock::time_point failed;
+    // Set while a fetch for this key id is in flight.
+    std::shared_ptr<Flight> flight;
+  };
+
+  StatusWrapped<std::shared_ptr<const Key>> KeyFor(const std::string &kid);
+  // Evicts entries until another key id fits. Called with mu_ held.
+  void MakeRoom();
+  StatusWrapped<std::shared_ptr<const Key>> Fetch(const std::string &kid);
+
+  Client &client_;
+  WebhookVerifierOptions options_;
+  std::mutex mu_;
+  std::unordered_map<std::string, Entry> keys_;
+};
+
+} // namespace plaid
+
+#endif // PLAID_WEBHOOKS_H_
\ No newline at end of file
@@ -0,0 +1,205 @@
+#include "plaid/breaker.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
+namespace plaid {
+
+class InstitutionBreakers::Breaker {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit Breaker(const std::string &id)
+      : institution_id(id), state(0), failures(0) {}
+
+  const std::string institution_id;
+  // A BreakerState, readable without the lock so closed breakers cost one
+  // load per call.
+  std::atomic<int> state;
+  // Written under mu, but read without it, so a success only takes the lock
+  // when there are failures to reset.
+  std::atomic<int> failures;
+
+  std::mutex mu;
+  Clock::time_point open_until;
+  // How long the next opening lasts; zero means options.open_time.
+  std::chrono::milliseconds open_time = std::chrono::milliseconds(0);
+  bool probing = false;
+  // Opened by Prime rather than by failed calls.
+  bool primed = false;
+};
+
+using Breaker = InstitutionBreakers::Breaker;
+
+static const int kClosed = static_cast<int>(BreakerState::kClosed);
+static const int kOpen = static_cast<int>(BreakerState::kOpen);
+static const int kHalfOpen = static_cast<int>(BreakerState::kHalfOpen);
+
+// Failures that say the institution itself is in trouble. Other API errors
+// (a bad access token, an Item that needs its login updated) show that the
+// institution answered, and network errors say nothing about it either way;
+// nor does a call whose deadline passed before it was even sent.
+static bool institution_failure(const Status &status) {
+  return (status.IsTimeout() && !status.IsLocalTimeout()) ||
+         (status.IsApiError() && status.ErrorType() == "INSTITUTION_ERROR");
+}
+
+static bool institution_answered(const Status &status) {
+  return status.IsOk() || status.IsApiError();
+}
+
+// Requires breaker.mu.
+static void open(Breaker &breaker, std::chrono::milliseconds duration) {
+  breaker.open_until = Breaker::Clock::now() + duration;
+  breaker.probing = false;
+  breaker.state.store(kOpen);
+}
+
+static void close(Breaker &breaker) {
+  breaker.failures.store(0);
+  breaker.open_time = std::chrono::milliseconds(0);
+  breaker.probing = false;
+  breaker.primed = false;
+  breaker.state.store(kClosed);
+}
+
+InstitutionBreakers::InstitutionBreakers() {}
+
+InstitutionBreakers::~InstitutionBreakers() {}
+
+void InstitutionBreakers::SetOptions(const CircuitBreakerOptions &options) {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  options_ = options;
+}
+
+CircuitBreakerOptions InstitutionBreakers::Options() const {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  return options_;
+}
+
+InstitutionBreakers::Shard &
+InstitutionBreakers::ShardFor(Shard *shards, const std::string &key) {
+  return shards[std::hash<std::string>()(key) % kShards];
+}
+
+std::shared_ptr<Breaker>
+InstitutionBreakers::Get(const std::string &institution_id) {
+  Shard &shard = ShardFor(institutions_, institution_id);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto &breaker = shard.map[institution_id];
+  if (!breaker)
+    breaker = std::make_shared<Breaker>(institution_id);
+  return breaker;
+}
+
+void InstitutionBreakers::Learn(const std::string &access_token,
+                                const std::string &institution_id) {
+  if (access_token.empty() || institution_id.empty())
+    return;
+  Shard &shard = ShardFor(tokens_, access_token);
+  {
+    std::lock_guard<std::mutex> lock(shard.mu);
+    auto it = shard.map.find(access_token);
+    if (it != shard.map.end() && it->second->institution_id == institution_id)
+      return;
+  }
+  auto breaker = Get(institution_id);
+  const size_t max_tokens =
+      std::max<size_t>(1, Options().max_tokens / kShards);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  // Any token will do: a busy one is learned again soon enough.
+  if (shard.map.size() >= max_tokens && !shard.map.count(access_token))
+    shard.map.erase(shard.map.begin());
+  shard.map[access_token] = std::move(breaker);
+}
+
+void InstitutionBreakers::Prime(const Institution &institution) {
+  if (institution.institution_id().empty() || !institution.has_status())
+    return;
+  const auto &logins = institution.status().item_logins();
+  const bool down = logins.status() == "DOWN" ||
+                    logins.breakdown().error_institution() >
+                        Options().error_threshold;
+  auto breaker = Get(institution.institution_id());
+  std::lock_guard<std::mutex> lock(breaker->mu);
+  if (down && breaker->state.load() == kClosed) {
+    breaker->primed = true;
+    open(*breaker, Options().open_time);
+  } else if (!down && breaker->primed) {
+    close(*breaker);
+  }
+}
+
+BreakerState
+InstitutionBreakers::State(const std::string &institution_id) const {
+  Shard &shard = ShardFor(institutions_, institution_id);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto it = shard.map.find(institution_id);
+  if (it == shard.map.end())
+    return BreakerState::kClosed;
+  return static_cast<BreakerState>(it->second->state.load());
+}
+
+std::shared_ptr<Breaker>
+InstitutionBreakers::For(const std::string &access_token) const {
+  Shard &shard = ShardFor(tokens_, access_token);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto it = shard.map.find(access_token);
+  return it == shard.map.end() ? nullptr : it->second;
+}
+
+Status InstitutionBreakers::Admit(Breaker &breaker, bool &probe) const {
+  probe = false;
+  if (breaker.state.load() == kClosed)
+    return Status::OK();
+  std::lock_guard<std::mutex> lock(breaker.mu);
+  const int state = breaker.state.load();
+  if (state == kClosed)
+    return Status::OK();
+  if (state == kOpen && Breaker::Clock::now() >= breaker.open_until)
+    breaker.state.store(kHalfOpen);
+  if (breaker.state.load() == kHalfOpen && !breaker.probing) {
+    breaker.probing = true;
+    probe = true;
+    return Status::OK();
+  }
+  return Status::Unavailable("institution " + breaker.institution_id +
+                             " is failing; call not sent");
+}
+
+void InstitutionBreakers::Record(Breaker &breaker, const Status &status,
+                                 bool probe) const {
+  const bool failed = institution_failure(status);
+  if (!failed && !probe && breaker.state.load() == kClosed) {
+    // The common case: nothing to reset unless failures were piling up.
+    if (institution_answered(status) && breaker.failures.load() != 0) {
+      std::lock_guard<std::mutex> lock(breaker.mu);
+      breaker.failures.store(0);
+    }
+    return;
+  }
+  const CircuitBreakerOptions options = Options();
+  std::lock_guard<std::mutex> lock(breaker.mu);
+  if (failed) {
+    breaker.failures.fetch_add(1);
+    if (probe) {
+      // Still down: wait twice as long before the next probe.
+      const auto base = breaker.open_time.count() > 0 ? breaker.open_time
+                                                      : options.open_time;
+      breaker.open_time = std::min(base * 2, options.max_open_time);
+      open(breaker, breaker.open_time);
+    } else if (breaker.state.load() == kClosed &&
+               breaker.failures.load() >= options.failure_threshold) {
+      open(breaker, options.open_time);
+    }
+  } else if (institution_answered(status)) {
+    if (probe || breaker.state.load() == kClosed)
+      close(breaker);
+  } else if (probe) {
+    // The probe told us nothing; let the next call try.
+    breaker.probing = false;
+  }
+}
+
+} // namespace plaid
\ No newline at end of file
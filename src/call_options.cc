@@ -0,0 +1,97 @@
+#include "plaid/call_options.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace plaid {
+
+CancellationToken::CancellationToken()
+    : state_(std::make_shared<State>()) {
+  state_->cancelled.store(false);
+}
+
+CancellationToken::CancellationToken(std::shared_ptr<State> state)
+    : state_(std::move(state)) {}
+
+CancellationToken CancellationToken::None() {
+  return CancellationToken(nullptr);
+}
+
+void CancellationToken::Cancel() {
+  if (!state_ || state_->cancelled.exchange(true))
+    return;
+  // Listeners run under the lock, so once Unsubscribe returns its listener is
+  // guaranteed not to be running (or about to run) on another thread.
+  std::lock_guard<std::mutex> lock(state_->mu);
+  for (auto &listener : state_->listeners)
+    listener.second();
+  state_->listeners.clear();
+}
+
+bool CancellationToken::IsCancelled() const {
+  return state_ && state_->cancelled.load();
+}
+
+uint64_t CancellationToken::Subscribe(std::function<void()> fn) const {
+  if (!state_)
+    return 0;
+  {
+    std::lock_guard<std::mutex> lock(state_->mu);
+    if (!state_->cancelled.load()) {
+      uint64_t id = state_->next_id++;
+      state_->listeners.push_back(std::make_pair(id, std::move(fn)));
+      return id;
+    }
+  }
+  fn();
+  return 0;
+}
+
+void CancellationToken::Unsubscribe(uint64_t id) const {
+  if (!state_ || id == 0)
+    return;
+  std::lock_guard<std::mutex> lock(state_->mu);
+  auto &listeners = state_->listeners;
+  for (auto it = listeners.begin(); it != listeners.end(); ++it) {
+    if (it->first == id) {
+      listeners.erase(it);
+      return;
+    }
+  }
+}
+
+CallOptions &CallOptions::WithDeadline(Clock::time_point at) {
+  deadline = at;
+  return *this;
+}
+
+CallOptions &CallOptions::WithTimeout(std::chrono::milliseconds timeout) {
+  deadline = Clock::now() + timeout;
+  return *this;
+}
+
+CallOptions &CallOptions::WithCancellation(const CancellationToken &token) {
+  cancel = token;
+  return *this;
+}
+
+CallOptions &CallOptions::WithHedging(double percentile,
+                                      double max_extra_load) {
+  hedging.enabled = true;
+  hedging.percentile = percentile;
+  hedging.max_extra_load = max_extra_load;
+  return *this;
+}
+
+CallOptions &CallOptions::WithPriority(Priority p) {
+  priority = p;
+  return *this;
+}
+
+CallOptions &CallOptions::WithTenant(const std::string &name) {
+  tenant = name;
+  return *this;
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -1,9 +1,20 @@
 #include "plaid/client.h"
+#include "plaid/thread_pool.h"
 #include "plaid/transport.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <functional>
+#include <future>
+#include <google/protobuf/util/json_util.h>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <unordered_set>
 #include <vector>
 
 namespace plaid {
@@ -31,306 +42,874 @@ Credentials::Credentials(Enviroment env, const std::string &client_id,
 }
 
 std::unique_ptr<Client> Client::Create(const Credentials &creds) {
+  return Create(creds, Transport::Create());
+}
+
+std::unique_ptr<Client> Client::Create(const Credentials &creds,
+                                       std::shared_ptr<Transport> transport) {
   // cannot use std::make_unique in C++11
-  return std::unique_ptr<Client>(new Client(creds));
+  return std::unique_ptr<Client>(new Client(creds, std::move(transport)));
+}
+
+// Renders msg as JSON without its closing brace, ready to be continued by
+// the rest of a request body. Empty if there is nothing to render.
+static std::string render_prefix(const google::protobuf::Message &msg) {
+  std::string json;
+  auto s = google::protobuf::util::MessageToJsonString(msg, &json);
+  if (!s.ok() || json.size() <= 2)
+    return std::string();
+  json.pop_back();
+  return json;
+}
+
+Client::Client(const Credentials &creds, std::shared_ptr<Transport> transport)
+    : creds_(creds), transport_(std::move(transport)),
+      pool_(&transport_->Pool()), loop_(&transport_->Loop()), outstanding_(0) {
+  // Credentials never change, so their JSON is rendered once here and
+  // streamed ahead of each request body instead of being copied into every
+  // request message and escaped again.
+  GetItemRequest secret;
+  secret.set_client_id(creds_.client_id);
+  secret.set_secret(creds_.secret);
+  secret_prefix_ = render_prefix(secret);
+  GetInstitutionByIDRequest public_key;
+  public_key.set_public_key(creds_.public_key);
+  public_key_prefix_ = render_prefix(public_key);
+}
+
+// The transport may outlive this client, so its calls are cancelled rather
+// than left to a shutdown of the loop, and their callbacks (which use the
+// client) drained before anything is torn down.
+Client::~Client() {
+  loop_->CancelOwned(this);
+  std::unique_lock<std::mutex> lock(outstanding_mu_);
+  auto drained = [this]() { return outstanding_.load() == 0; };
+  // As in Await, a pool worker helps run the callbacks it is waiting on.
+  while (pool_->InWorkerThread() && !drained()) {
+    lock.unlock();
+    if (!pool_->RunPendingTask())
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    lock.lock();
+  }
+  outstanding_cv_.wait(lock, drained);
 }
 
-Client::Client(const Credentials &creds) : creds_(creds) {}
+ThreadPool &Client::Pool() { return *pool_; }
+
+std::shared_ptr<Transport> Client::GetTransport() const { return transport_; }
+
+PageSizer &Client::PageSizerFor(EndpointId endpoint) {
+  return page_sizers_[static_cast<int>(endpoint)];
+}
+
+InstitutionBreakers &Client::Breakers() { return breakers_; }
+
+ItemErrorCache &Client::ItemErrors() { return item_errors_; }
+
+ConcurrencyLimit &Client::Concurrency() { return loop_->Limit(); }
+
+ClientMetrics Client::Metrics() const {
+  ClientMetrics m;
+  m.requests = requests_.Value();
+  m.request_errors = request_errors_.Value();
+  m.parse_errors = parse_errors_.Value();
+  m.bytes_received = bytes_received_.Value();
+  m.bytes_saved = bytes_saved_.Value();
+  m.hedged_requests = hedged_requests_.Value();
+  m.hedge_wins = hedge_wins_.Value();
+  m.breaker_rejections = breaker_rejections_.Value();
+  m.item_error_skips = item_error_skips_.Value();
+  m.concurrency_limit = loop_->Limit().Limit();
+  return m;
+}
 
 std::string Client::AppendUrl(const std::string &extra) const {
   return creds_.url + extra;
 }
 
+// Fills in whichever credentials an endpoint authenticates with.
+template <class Msg>
+static void authenticate(Msg &, const Credentials &,
+                         std::integral_constant<Auth, Auth::None>) {}
+
+template <class Msg>
+static void authenticate(Msg &msg, const Credentials &creds,
+                         std::integral_constant<Auth, Auth::Secret>) {
+  msg.set_client_id(creds.client_id);
+  msg.set_secret(creds.secret);
+}
+
+template <class Msg>
+static void authenticate(Msg &msg, const Credentials &creds,
+                         std::integral_constant<Auth, Auth::PublicKey>) {
+  msg.set_public_key(creds.public_key);
+}
+
+const std::string *Client::CredentialPrefix(Auth auth) const {
+  const std::string *prefix = nullptr;
+  if (auth == Auth::Secret)
+    prefix = &secret_prefix_;
+  else if (auth == Auth::PublicKey)
+    prefix = &public_key_prefix_;
+  return prefix && !prefix->empty() ? prefix : nullptr;
+}
+
+// The access token of requests that carry one; calls without one (institution
+// lookups, link token exchanges, ...) bypass the circuit breakers.
+template <class Msg>
+static auto access_token_of(const Msg &msg, int)
+    -> decltype(msg.access_token(), std::string()) {
+  return msg.access_token();
+}
+
+template <class Msg>
+static std::string access_token_of(const Msg &, long) {
+  return std::string();
+}
+
+// Learns what a response says about the Items and institutions it mentions:
+// which institution an Item belongs to and whether the Item is in an error
+// state (GetItem, GetAccounts, ...), and how an institution's logins are
+// faring (GetInstitutionByID, GetInstitutions, ...). StatusWrapped only
+// hands its value out by copy or by move, so the value is moved out and
+// wrapped again.
+template <class T>
+static auto learn_item(InstitutionBreakers &breakers,
+                       ItemErrorCache &item_errors, const std::string &token,
+                       const T &value, int)
+    -> decltype(value.item().error(), void()) {
+  const Item &item = value.item();
+  breakers.Learn(token, item.institution_id());
+  if (item.error().error_type().empty())
+    item_errors.Clear(token);
+  else
+    item_errors.Record(token, Status::ApiError(item.error().error_type(),
+                                               item.error().error_code(),
+                                               item.error().error_message()));
+}
+
+template <class T>
+static void learn_item(InstitutionBreakers &, ItemErrorCache &,
+                       const std::string &, const T &, long) {}
+
+template <class T>
+static auto prime_institutions(InstitutionBreakers &breakers, const T &value,
+                               int) -> decltype(value.institution(), void()) {
+  breakers.Prime(value.institution());
+}
+
+template <class T>
+static auto prime_institutions(InstitutionBreakers &breakers, const T &value,
+                               int) -> decltype(value.institutions(), void()) {
+  for (const auto &institution : value.institutions())
+    breakers.Prime(institution);
+}
+
 template <class T>
-static StatusWrapped<T> make_plaid_request(std::function<Request()> req) {
-  auto r = req();
-  auto resp = r.Execute();
-  if (!resp.IsOk())
+static void prime_institutions(InstitutionBreakers &, const T &, long) {}
+
+template <class T>
+static StatusWrapped<T> observe_response(InstitutionBreakers &breakers,
+                                         ItemErrorCache &item_errors,
+                                         const std::string &token,
+                                         StatusWrapped<T> res) {
+  if (!res.IsOk()) {
+    if (!token.empty())
+      item_errors.Record(token, res.GetStatus());
+    return res;
+  }
+  T value = res.Take();
+  if (!token.empty())
+    learn_item(breakers, item_errors, token, value, 0);
+  prime_institutions(breakers, value, 0);
+  return StatusWrapped<T>(std::move(value));
+}
+
+// The last step of a call on its way back: tells the Item's breaker how it
+// went and passes the result through observe_response to the caller. The
+// steps along the way are function objects that the callback is moved
+// through, rather than std::functions wrapping one another.
+template <class T> struct ObservedCallback {
+  InstitutionBreakers *breakers;
+  ItemErrorCache *item_errors;
+  std::shared_ptr<InstitutionBreakers::Breaker> breaker;
+  bool probe;
+  std::string token;
+  Callback<T> cb;
+
+  void operator()(StatusWrapped<T> res) {
+    if (breaker)
+      breakers->Record(*breaker, res.GetStatus(), probe);
+    cb(observe_response(*breakers, *item_errors, token, std::move(res)));
+  }
+};
+
+template <class E>
+void Client::Call(typename E::RequestType &body,
+                  Callback<typename E::ResponseType> cb,
+                  const CallOptions &call) {
+  const std::string *prefix = CredentialPrefix(E::kAuth);
+  // Without a rendered prefix, fall back to setting the fields directly.
+  if (!prefix)
+    authenticate(body, creds_, std::integral_constant<Auth, E::kAuth>());
+  LatencyHistogram *latency =
+      E::kIdempotent ? &latencies_[static_cast<int>(E::kId)] : nullptr;
+  using T = typename E::ResponseType;
+  std::string token = access_token_of(body, 0);
+  // Data reads for an Item already known to be unusable get the error back
+  // without a round trip. GetItem is still sent, since it is how callers
+  // look at the Item's state.
+  if (!token.empty() && E::kIdempotent && E::kId != EndpointId::GetItem) {
+    const Status cached = item_errors_.Check(token);
+    if (!cached.IsOk()) {
+      item_error_skips_.Add();
+      return cb(StatusWrapped<T>::FromStatus(cached));
+    }
+  }
+  // Calls for an Item go through its institution's breaker, once the
+  // institution is known.
+  std::shared_ptr<InstitutionBreakers::Breaker> breaker;
+  bool probe = false;
+  if (!token.empty())
+    breaker = breakers_.For(token);
+  if (breaker) {
+    const Status admitted = breakers_.Admit(*breaker, probe);
+    if (!admitted.IsOk()) {
+      breaker_rejections_.Add();
+      return cb(StatusWrapped<T>::FromStatus(admitted));
+    }
+  }
+  ObservedCallback<T> done = {&breakers_, &item_errors_, std::move(breaker),
+                              probe, token, std::move(cb)};
+  // Calls for different Items (and calls for no Item from different
+  // clients) wait for a connection slot side by side unless the caller
+  // groups them by tenant.
+  if (!call.tenant.empty())
+    return Dispatch<T>(E::Path(), body, prefix, std::move(done), call,
+                       latency);
+  CallOptions by_item = call;
+  by_item.tenant = token.empty() ? creds_.client_id : std::move(token);
+  Dispatch<T>(E::Path(), body, prefix, std::move(done), by_item, latency);
+}
+
+template <class T, class Done> struct Client::Decoder {
+  Client *client;
+  Done done;
+  std::shared_ptr<StatusWrapped<Response>> resp;
+
+  // On the I/O thread. Parsing is CPU-bound, so it runs on the pool instead;
+  // the response is handed over by pointer, since copying it would copy the
+  // whole body.
+  void operator()(StatusWrapped<Response> finished) {
+    resp = std::make_shared<StatusWrapped<Response>>(std::move(finished));
+    Client *c = client;
+    c->pool_->Submit(std::move(*this));
+  }
+
+  // On the pool.
+  void operator()() {
+    done(client->Decode<T>(*resp));
+    client->Release();
+  }
+};
+
+template <class T, class Done>
+void Client::Dispatch(const char *path, const google::protobuf::Message &body,
+                      const std::string *prefix, Done done,
+                      const CallOptions &call, LatencyHistogram *latency) {
+  if (call.cancel.IsCancelled())
+    return done(StatusWrapped<T>::FromStatus(
+        Status::Cancelled("request cancelled before it was sent")));
+  requests_.Add();
+  Hold();
+  Send(path, body, prefix, call, latency,
+       Decoder<T, Done>{this, std::move(done), nullptr});
+}
+
+template <class T>
+StatusWrapped<T> Client::Decode(StatusWrapped<Response> &resp) {
+  if (!resp.IsOk()) {
+    request_errors_.Add();
     return StatusWrapped<T>::FromStatus(resp.GetStatus());
-  return resp.Unwrap().Parse<T>();
+  }
+  const Response body = resp.Take();
+  bytes_received_.Add(body.WireSize());
+  if (body.BodySize() > body.WireSize())
+    bytes_saved_.Add(body.BodySize() - body.WireSize());
+  const Status error = body.ErrorStatus();
+  if (!error.IsOk()) {
+    request_errors_.Add();
+    return StatusWrapped<T>::FromStatus(error);
+  }
+  auto res = body.Parse<T>();
+  if (!res.IsOk())
+    parse_errors_.Add();
+  return res;
+}
+
+void Client::Hold() { ++outstanding_; }
+
+void Client::Release() {
+  if (--outstanding_ != 0)
+    return;
+  std::lock_guard<std::mutex> lock(outstanding_mu_);
+  outstanding_cv_.notify_all();
+}
+
+static std::chrono::microseconds
+elapsed_since(CallOptions::Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+      CallOptions::Clock::now() - start);
+}
+
+// Whether resp is an answer worth timing. Error responses (a 429 turned
+// away at the door, a 500 from a failed lookup) take however long they
+// take, and counting them would drag the hedging delay away from how long
+// real answers need.
+static bool answered(const StatusWrapped<Response> &resp) {
+  return resp.IsOk() && resp.Get().StatusCode() < 400;
+}
+
+// Times an unhedged read on its way back.
+template <class Done> struct TimedCallback {
+  LatencyHistogram *latency;
+  CallOptions::Clock::time_point start;
+  Done done;
+
+  void operator()(StatusWrapped<Response> resp) {
+    if (answered(resp))
+      latency->Record(elapsed_since(start));
+    done(std::move(resp));
+  }
+};
+
+// The legs of one hedged call. Both run under the race token, so settling the
+// race cancels whichever leg is still in flight.
+struct Client::HedgeRace {
+  std::mutex mu;
+  bool settled = false;
+  int in_flight = 1;
+  std::unique_ptr<Request> spare;
+  CancellationToken token;
+  CancellationToken caller;
+  uint64_t caller_listener = 0;
+  LatencyHistogram *latency = nullptr;
+  CallOptions::Clock::time_point start;
+  // Either leg may finish the call, so this is where a hedged call's
+  // completion has to be type-erased.
+  std::function<void(StatusWrapped<Response>)> done;
+};
+
+std::unique_ptr<Request> Client::Build(const char *path,
+                                       const google::protobuf::Message &body,
+                                       const std::string *prefix) const {
+  std::unique_ptr<Request> req(new Request(AppendUrl(path)));
+  req->SetBody(body, prefix);
+  return req;
+}
+
+template <class Done>
+void Client::Send(const char *path, const google::protobuf::Message &body,
+                  const std::string *prefix, const CallOptions &call,
+                  LatencyHistogram *latency, Done done) {
+  std::unique_ptr<Request> r = Build(path, body, prefix);
+  if (!latency) {
+    r->SetCallOptions(call);
+    return loop_->Submit(std::move(r), std::move(done), this);
+  }
+
+  const auto start = CallOptions::Clock::now();
+  std::chrono::microseconds delay(0);
+  if (call.hedging.enabled) {
+    hedge_budget_.Deposit(call.hedging.max_extra_load);
+    delay = latency->Percentile(call.hedging.percentile);
+  }
+  // Reads are timed either way, so the percentile is already known by the
+  // time a caller turns hedging on.
+  if (delay.count() == 0 || start + delay >= call.deadline ||
+      !hedge_budget_.CanWithdraw()) {
+    r->SetCallOptions(call);
+    return loop_->Submit(
+        std::move(r), TimedCallback<Done>{latency, start, std::move(done)},
+        this);
+  }
+
+  // The duplicate is built now, while the request message is still alive,
+  // and is simply dropped if the primary answers in time.
+  auto race = std::make_shared<HedgeRace>();
+  race->spare = Build(path, body, prefix);
+  race->caller = call.cancel;
+  race->latency = latency;
+  race->start = start;
+  race->done = std::move(done);
+  CancellationToken token = race->token;
+  race->caller_listener =
+      call.cancel.Subscribe([token]() mutable { token.Cancel(); });
+
+  CallOptions leg = call;
+  leg.cancel = race->token;
+  r->SetCallOptions(leg);
+  race->spare->SetCallOptions(leg);
+  // Each leg holds the client until it settles, since the losing one can
+  // finish after the call has been reported back.
+  Hold();
+  loop_->Submit(
+      std::move(r),
+      [this, race](StatusWrapped<Response> resp) {
+        Settle(race, std::move(resp), false);
+        Release();
+      },
+      this);
+  loop_->Schedule(start + delay, [this, race]() {
+    std::unique_ptr<Request> spare;
+    {
+      std::lock_guard<std::mutex> lock(race->mu);
+      if (race->settled || !hedge_budget_.TryWithdraw())
+        return;
+      spare = std::move(race->spare);
+      ++race->in_flight;
+    }
+    hedged_requests_.Add();
+    Hold();
+    loop_->Submit(
+        std::move(spare),
+        [this, race](StatusWrapped<Response> resp) {
+          Settle(race, std::move(resp), true);
+          Release();
+        },
+        this);
+  });
+}
+
+void Client::Settle(const std::shared_ptr<HedgeRace> &race,
+                    StatusWrapped<Response> resp, bool hedge) {
+  {
+    std::lock_guard<std::mutex> lock(race->mu);
+    --race->in_flight;
+    // A failed leg only decides the call once no other leg can still answer.
+    if (race->settled || (!resp.IsOk() && race->in_flight > 0))
+      return;
+    race->settled = true;
+  }
+  race->caller.Unsubscribe(race->caller_listener);
+  race->token.Cancel();
+  if (answered(resp))
+    race->latency->Record(elapsed_since(race->start));
+  if (resp.IsOk() && hedge)
+    hedge_wins_.Add();
+  race->done(std::move(resp));
+}
+
+template <class T>
+StatusWrapped<T> Client::Await(std::function<void(Callback<T>)> start) {
+  auto result = std::make_shared<std::promise<StatusWrapped<T>>>();
+  auto ready = result->get_future();
+  start([result](StatusWrapped<T> res) { result->set_value(std::move(res)); });
+  // A pool worker that simply blocked here could starve the very parse it is
+  // waiting on, so it keeps running other queued work until its result lands.
+  if (pool_->InWorkerThread()) {
+    while (ready.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready) {
+      if (!pool_->RunPendingTask())
+        ready.wait_for(std::chrono::milliseconds(1));
+    }
+  }
+  return ready.get();
+}
+
+// Sizes the pages of a read: count if the caller set one, or else whatever
+// the endpoint's PageSizer picks for what remains.
+static std::function<int64_t(int64_t)> page_size_for(PageSizer &sizer,
+                                                     int64_t count) {
+  return [&sizer, count](int64_t remaining) {
+    return count > 0 ? count
+                     : sizer.Next(remaining, kPagesInFlight, kMinPageSize,
+                                  kMaxPageSize);
+  };
 }
 
 // Accounts
 
 StatusWrapped<GetBalancesResponse>
 Client::GetBalancesWithOptions(const std::string &access_token,
-                               const GetBalancesOptions &options) {
+                               const GetBalancesOptions &options,
+                               const CallOptions &call) {
+  auto start = [&](Callback<GetBalancesResponse> cb) {
+    GetBalancesWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetBalancesResponse>(start);
+}
+
+void Client::GetBalancesWithOptionsAsync(const std::string &access_token,
+                                         const GetBalancesOptions &options,
+                                         Callback<GetBalancesResponse> cb,
+                                         const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetBalancesResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("accounts/balance/get"));
-    auto req_data = GetBalancesRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_data.mutable_options()->add_account_ids(options.account_ids(i));
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetBalancesResponse>(req);
+    return cb(StatusWrapped<GetBalancesResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetBalancesRequest();
+  req_data.set_access_token(access_token);
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_data.mutable_options()->add_account_ids(options.account_ids(i));
+  Call<GetBalancesEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetBalancesResponse>
-Client::GetBalances(const std::string &access_token) {
-  return GetBalancesWithOptions(access_token, GetBalancesOptions());
+Client::GetBalances(const std::string &access_token, const CallOptions &call) {
+  return GetBalancesWithOptions(access_token, GetBalancesOptions(), call);
+}
+
+void Client::GetBalancesAsync(const std::string &access_token,
+                              Callback<GetBalancesResponse> cb,
+                              const CallOptions &call) {
+  GetBalancesWithOptionsAsync(access_token, GetBalancesOptions(), cb, call);
 }
 
 StatusWrapped<GetAccountsResponse>
 Client::GetAccountsWithOptions(const std::string &access_token,
-                               const GetAccountsOptions &options) {
+                               const GetAccountsOptions &options,
+                               const CallOptions &call) {
+  auto start = [&](Callback<GetAccountsResponse> cb) {
+    GetAccountsWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetAccountsResponse>(start);
+}
+
+void Client::GetAccountsWithOptionsAsync(const std::string &access_token,
+                                         const GetAccountsOptions &options,
+                                         Callback<GetAccountsResponse> cb,
+                                         const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetAccountsResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("accounts/get"));
-    auto req_data = GetAccountsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_data.mutable_options()->add_account_ids(options.account_ids(i));
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetAccountsResponse>(req);
+    return cb(StatusWrapped<GetAccountsResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetAccountsRequest();
+  req_data.set_access_token(access_token);
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_data.mutable_options()->add_account_ids(options.account_ids(i));
+  Call<GetAccountsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetAccountsResponse>
-Client::GetAccounts(const std::string &access_token) {
-  return GetAccountsWithOptions(access_token, GetAccountsOptions());
+Client::GetAccounts(const std::string &access_token, const CallOptions &call) {
+  return GetAccountsWithOptions(access_token, GetAccountsOptions(), call);
+}
+
+void Client::GetAccountsAsync(const std::string &access_token,
+                              Callback<GetAccountsResponse> cb,
+                              const CallOptions &call) {
+  GetAccountsWithOptionsAsync(access_token, GetAccountsOptions(), cb, call);
 }
 
 // Assets
 
 StatusWrapped<GetAssetReportResponse>
-Client::GetAssetReport(const std::string &asset_report_token) {
-  if (asset_report_token == "")
-    return StatusWrapped<GetAssetReportResponse>::FromStatus(
-        Status::MissingInfo("missing asset report token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("asset_report/get"));
-    auto req_data = GetAssetReportRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_asset_report_token(asset_report_token);
-    req.SetBody(req_data);
-    return req;
+Client::GetAssetReport(const std::string &asset_report_token,
+                       const CallOptions &call) {
+  auto start = [&](Callback<GetAssetReportResponse> cb) {
+    GetAssetReportAsync(asset_report_token, cb, call);
   };
-  return make_plaid_request<GetAssetReportResponse>(req);
+  return Await<GetAssetReportResponse>(start);
+}
+
+void Client::GetAssetReportAsync(const std::string &asset_report_token,
+                                 Callback<GetAssetReportResponse> cb,
+                                 const CallOptions &call) {
+  if (asset_report_token == "")
+    return cb(StatusWrapped<GetAssetReportResponse>::FromStatus(
+        Status::MissingInfo("missing asset report token")));
+  auto req_data = GetAssetReportRequest();
+  req_data.set_asset_report_token(asset_report_token);
+  Call<GetAssetReportEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<CreateAuditCopyTokenResponse>
 Client::CreateAuditCopy(const std::string &asset_report_token,
-                        const std::string &auditor_id) {
+                        const std::string &auditor_id,
+                        const CallOptions &call) {
+  auto start = [&](Callback<CreateAuditCopyTokenResponse> cb) {
+    CreateAuditCopyAsync(asset_report_token, auditor_id, cb, call);
+  };
+  return Await<CreateAuditCopyTokenResponse>(start);
+}
+
+void Client::CreateAuditCopyAsync(const std::string &asset_report_token,
+                                  const std::string &auditor_id,
+                                  Callback<CreateAuditCopyTokenResponse> cb,
+                                  const CallOptions &call) {
   if (asset_report_token == "")
-    return StatusWrapped<CreateAuditCopyTokenResponse>::FromStatus(
-        Status::MissingInfo("missing asset report token"));
+    return cb(StatusWrapped<CreateAuditCopyTokenResponse>::FromStatus(
+        Status::MissingInfo("missing asset report token")));
   if (auditor_id == "")
-    return StatusWrapped<CreateAuditCopyTokenResponse>::FromStatus(
-        Status::MissingInfo("missing auditor id"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("asset_report/audit_copy/create"));
-    auto req_data = CreateAuditCopyRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_asset_report_token(asset_report_token);
-    req_data.set_auditor_id(auditor_id);
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<CreateAuditCopyTokenResponse>(req);
+    return cb(StatusWrapped<CreateAuditCopyTokenResponse>::FromStatus(
+        Status::MissingInfo("missing auditor id")));
+  auto req_data = CreateAuditCopyRequest();
+  req_data.set_asset_report_token(asset_report_token);
+  req_data.set_auditor_id(auditor_id);
+  Call<CreateAuditCopyEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<RemoveAssetReportResponse>
-Client::RemoveAssetReport(const std::string &asset_report_token) {
-  if (asset_report_token == "")
-    return StatusWrapped<RemoveAssetReportResponse>::FromStatus(
-        Status::MissingInfo("missing asset report token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("asset_report/remove"));
-    auto req_data = RemoveAssetReportRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_asset_report_token(asset_report_token);
-    req.SetBody(req_data);
-    return req;
+Client::RemoveAssetReport(const std::string &asset_report_token,
+                          const CallOptions &call) {
+  auto start = [&](Callback<RemoveAssetReportResponse> cb) {
+    RemoveAssetReportAsync(asset_report_token, cb, call);
   };
-  return make_plaid_request<RemoveAssetReportResponse>(req);
+  return Await<RemoveAssetReportResponse>(start);
+}
+
+void Client::RemoveAssetReportAsync(const std::string &asset_report_token,
+                                    Callback<RemoveAssetReportResponse> cb,
+                                    const CallOptions &call) {
+  if (asset_report_token == "")
+    return cb(StatusWrapped<RemoveAssetReportResponse>::FromStatus(
+        Status::MissingInfo("missing asset report token")));
+  auto req_data = RemoveAssetReportRequest();
+  req_data.set_asset_report_token(asset_report_token);
+  Call<RemoveAssetReportEndpoint>(req_data, cb, call);
 }
 
 // Authentication
 
 StatusWrapped<GetAuthResponse>
 Client::GetAuthWithOptions(const std::string &access_token,
-                           const GetAuthOptions &options) {
+                           const GetAuthOptions &options,
+                           const CallOptions &call) {
+  auto start = [&](Callback<GetAuthResponse> cb) {
+    GetAuthWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetAuthResponse>(start);
+}
+
+void Client::GetAuthWithOptionsAsync(const std::string &access_token,
+                                     const GetAuthOptions &options,
+                                     Callback<GetAuthResponse> cb,
+                                     const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetAuthResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&] {
-    auto req = Request(AppendUrl("auth/get"));
-    auto req_data = GetAuthRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_data.mutable_options()->add_account_ids(options.account_ids(i));
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetAuthResponse>(req);
+    return cb(StatusWrapped<GetAuthResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetAuthRequest();
+  req_data.set_access_token(access_token);
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_data.mutable_options()->add_account_ids(options.account_ids(i));
+  Call<GetAuthEndpoint>(req_data, cb, call);
 }
 
-StatusWrapped<GetAuthResponse>
-Client::GetAuth(const std::string &access_token) {
-  return GetAuthWithOptions(access_token, GetAuthOptions());
+StatusWrapped<GetAuthResponse> Client::GetAuth(const std::string &access_token,
+                                               const CallOptions &call) {
+  return GetAuthWithOptions(access_token, GetAuthOptions(), call);
+}
+
+void Client::GetAuthAsync(const std::string &access_token,
+                          Callback<GetAuthResponse> cb,
+                          const CallOptions &call) {
+  GetAuthWithOptionsAsync(access_token, GetAuthOptions(), cb, call);
 }
 
 // Categories
 
-StatusWrapped<GetCategoriesResponse> Client::GetCategories() {
-  auto req = [&]() { return Request(AppendUrl("categories/get")); };
-  return make_plaid_request<GetCategoriesResponse>(req);
+StatusWrapped<GetCategoriesResponse>
+Client::GetCategories(const CallOptions &call) {
+  auto start = [&](Callback<GetCategoriesResponse> cb) {
+    GetCategoriesAsync(cb, call);
+  };
+  return Await<GetCategoriesResponse>(start);
+}
+
+void Client::GetCategoriesAsync(Callback<GetCategoriesResponse> cb,
+                                const CallOptions &call) {
+  auto req_data = google::protobuf::Empty();
+  Call<GetCategoriesEndpoint>(req_data, cb, call);
 }
 
 // Holdings
 
 StatusWrapped<GetHoldingsResponse>
 Client::GetHoldingsWithOptions(const std::string &access_token,
-                               const GetHoldingsOptions &options) {
+                               const GetHoldingsOptions &options,
+                               const CallOptions &call) {
+  auto start = [&](Callback<GetHoldingsResponse> cb) {
+    GetHoldingsWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetHoldingsResponse>(start);
+}
+
+void Client::GetHoldingsWithOptionsAsync(const std::string &access_token,
+                                         const GetHoldingsOptions &options,
+                                         Callback<GetHoldingsResponse> cb,
+                                         const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetHoldingsResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("investments/holdings/get"));
-    auto req_data = GetHoldingsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_data.mutable_options()->add_account_ids(options.account_ids(i));
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetHoldingsResponse>(req);
+    return cb(StatusWrapped<GetHoldingsResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetHoldingsRequest();
+  req_data.set_access_token(access_token);
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_data.mutable_options()->add_account_ids(options.account_ids(i));
+  Call<GetHoldingsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetHoldingsResponse>
-Client::GetHoldings(const std::string &access_token) {
-  return GetHoldingsWithOptions(access_token, GetHoldingsOptions());
+Client::GetHoldings(const std::string &access_token, const CallOptions &call) {
+  return GetHoldingsWithOptions(access_token, GetHoldingsOptions(), call);
+}
+
+void Client::GetHoldingsAsync(const std::string &access_token,
+                              Callback<GetHoldingsResponse> cb,
+                              const CallOptions &call) {
+  GetHoldingsWithOptionsAsync(access_token, GetHoldingsOptions(), cb, call);
 }
 
 // Identity
 
 StatusWrapped<GetIdentityResponse>
-Client::GetIdentity(const std::string &access_token) {
-  if (access_token == "")
-    return StatusWrapped<GetIdentityResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("identity/get"));
-    auto req_data = GetIdentityRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+Client::GetIdentity(const std::string &access_token, const CallOptions &call) {
+  auto start = [&](Callback<GetIdentityResponse> cb) {
+    GetIdentityAsync(access_token, cb, call);
   };
-  return make_plaid_request<GetIdentityResponse>(req);
+  return Await<GetIdentityResponse>(start);
+}
+
+void Client::GetIdentityAsync(const std::string &access_token,
+                              Callback<GetIdentityResponse> cb,
+                              const CallOptions &call) {
+  if (access_token == "")
+    return cb(StatusWrapped<GetIdentityResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetIdentityRequest();
+  req_data.set_access_token(access_token);
+  Call<GetIdentityEndpoint>(req_data, cb, call);
 }
 
 // Income
 
 StatusWrapped<GetIncomeResponse>
-Client::GetIncome(const std::string &access_token) {
-  if (access_token == "")
-    return StatusWrapped<GetIncomeResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("income/get"));
-    auto req_data = GetIncomeRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+Client::GetIncome(const std::string &access_token, const CallOptions &call) {
+  auto start = [&](Callback<GetIncomeResponse> cb) {
+    GetIncomeAsync(access_token, cb, call);
   };
-  return make_plaid_request<GetIncomeResponse>(req);
+  return Await<GetIncomeResponse>(start);
+}
+
+void Client::GetIncomeAsync(const std::string &access_token,
+                            Callback<GetIncomeResponse> cb,
+                            const CallOptions &call) {
+  if (access_token == "")
+    return cb(StatusWrapped<GetIncomeResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetIncomeRequest();
+  req_data.set_access_token(access_token);
+  Call<GetIncomeEndpoint>(req_data, cb, call);
 }
 
 // Institutions
 
-StatusWrapped<GetInstitutionByIDResponse> Client::GetInstitutionByIDWithOptions(
-    const std::string &id, const GetInstitutionByIDOptions &options) {
-  if (id == "")
-    return StatusWrapped<GetInstitutionByIDResponse>::FromStatus(
-        Status::MissingInfo("missing id"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("institutions/get_by_id"));
-    auto req_data = GetInstitutionByIDRequest();
-    req_data.set_institution_id(id);
-    req_data.set_public_key(creds_.public_key);
-    *req_data.mutable_options() = options;
-    req.SetBody(req_data);
-    return req;
+StatusWrapped<GetInstitutionByIDResponse>
+Client::GetInstitutionByIDWithOptions(const std::string &id,
+                                      const GetInstitutionByIDOptions &options,
+                                      const CallOptions &call) {
+  auto start = [&](Callback<GetInstitutionByIDResponse> cb) {
+    GetInstitutionByIDWithOptionsAsync(id, options, cb, call);
   };
-  return make_plaid_request<GetInstitutionByIDResponse>(req);
+  return Await<GetInstitutionByIDResponse>(start);
+}
+
+void Client::GetInstitutionByIDWithOptionsAsync(
+    const std::string &id, const GetInstitutionByIDOptions &options,
+    Callback<GetInstitutionByIDResponse> cb, const CallOptions &call) {
+  if (id == "")
+    return cb(StatusWrapped<GetInstitutionByIDResponse>::FromStatus(
+        Status::MissingInfo("missing id")));
+  auto req_data = GetInstitutionByIDRequest();
+  req_data.set_institution_id(id);
+  *req_data.mutable_options() = options;
+  Call<GetInstitutionByIDEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetInstitutionByIDResponse>
-Client::GetInstitutionByID(const std::string &id) {
-  return GetInstitutionByIDWithOptions(id, GetInstitutionByIDOptions());
+Client::GetInstitutionByID(const std::string &id, const CallOptions &call) {
+  return GetInstitutionByIDWithOptions(id, GetInstitutionByIDOptions(), call);
+}
+
+void Client::GetInstitutionByIDAsync(const std::string &id,
+                                     Callback<GetInstitutionByIDResponse> cb,
+                                     const CallOptions &call) {
+  GetInstitutionByIDWithOptionsAsync(id, GetInstitutionByIDOptions(), cb, call);
 }
 
 StatusWrapped<GetInstitutionsResponse>
 Client::GetInstitutionsWithOptions(int count, int offset,
-                                   const GetInstitutionsOptions &options) {
+                                   const GetInstitutionsOptions &options,
+                                   const CallOptions &call) {
+  auto start = [&](Callback<GetInstitutionsResponse> cb) {
+    GetInstitutionsWithOptionsAsync(count, offset, options, cb, call);
+  };
+  return Await<GetInstitutionsResponse>(start);
+}
+
+void Client::GetInstitutionsWithOptionsAsync(
+    int count, int offset, const GetInstitutionsOptions &options,
+    Callback<GetInstitutionsResponse> cb, const CallOptions &call) {
   if (count == 0)
     count = 50;
-  auto req = [&]() {
-    auto req = Request(AppendUrl("institutions/get"));
-    auto req_data = GetInstitutionsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_count(count);
-    req_data.set_offset(offset);
-    *req_data.mutable_options() = options;
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetInstitutionsResponse>(req);
+  auto req_data = GetInstitutionsRequest();
+  req_data.set_count(count);
+  req_data.set_offset(offset);
+  *req_data.mutable_options() = options;
+  Call<GetInstitutionsEndpoint>(req_data, cb, call);
+}
+
+StatusWrapped<GetInstitutionsResponse>
+Client::GetInstitutions(int count, int offset, const CallOptions &call) {
+  return GetInstitutionsWithOptions(count, offset, GetInstitutionsOptions(),
+                                    call);
 }
 
-StatusWrapped<GetInstitutionsResponse> Client::GetInstitutions(int count,
-                                                               int offset) {
-  return GetInstitutionsWithOptions(count, offset, GetInstitutionsOptions());
+void Client::GetInstitutionsAsync(int count, int offset,
+                                  Callback<GetInstitutionsResponse> cb,
+                                  const CallOptions &call) {
+  GetInstitutionsWithOptionsAsync(count, offset, GetInstitutionsOptions(), cb,
+                                  call);
 }
 
-StatusWrapped<SearchInstitutionsResponse> Client::SearchInstitutionsWithOptions(
+StatusWrapped<SearchInstitutionsResponse>
+Client::SearchInstitutionsWithOptions(const std::string &query,
+                                      const std::vector<std::string> &products,
+                                      const SearchInstitutionsOptions &options,
+                                      const CallOptions &call) {
+  auto start = [&](Callback<SearchInstitutionsResponse> cb) {
+    SearchInstitutionsWithOptionsAsync(query, products, options, cb, call);
+  };
+  return Await<SearchInstitutionsResponse>(start);
+}
+
+void Client::SearchInstitutionsWithOptionsAsync(
     const std::string &query, const std::vector<std::string> &products,
-    const SearchInstitutionsOptions &options) {
+    const SearchInstitutionsOptions &options,
+    Callback<SearchInstitutionsResponse> cb, const CallOptions &call) {
   if (query == "")
-    return StatusWrapped<SearchInstitutionsResponse>::FromStatus(
-        Status::MissingInfo("missing query"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("institutions/search"));
-    auto req_data = SearchInstitutionsRequest();
-    req_data.set_query(query);
-    for (const auto &product : products)
-      req_data.add_products(product);
-    *req_data.mutable_options() = options;
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<SearchInstitutionsResponse>(req);
+    return cb(StatusWrapped<SearchInstitutionsResponse>::FromStatus(
+        Status::MissingInfo("missing query")));
+  auto req_data = SearchInstitutionsRequest();
+  req_data.set_query(query);
+  for (const auto &product : products)
+    req_data.add_products(product);
+  *req_data.mutable_options() = options;
+  Call<SearchInstitutionsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<SearchInstitutionsResponse>
 Client::SearchInstitutions(const std::string &query,
-                           const std::vector<std::string> &products) {
+                           const std::vector<std::string> &products,
+                           const CallOptions &call) {
   return SearchInstitutionsWithOptions(query, products,
-                                       SearchInstitutionsOptions());
+                                       SearchInstitutionsOptions(), call);
+}
+
+void Client::SearchInstitutionsAsync(const std::string &query,
+                                     const std::vector<std::string> &products,
+                                     Callback<SearchInstitutionsResponse> cb,
+                                     const CallOptions &call) {
+  SearchInstitutionsWithOptionsAsync(query, products,
+                                     SearchInstitutionsOptions(), cb, call);
 }
 
 // Investment Transactions
@@ -338,187 +917,294 @@ Client::SearchInstitutions(const std::string &query,
 StatusWrapped<GetInvestmentTransactionsResponse>
 Client::GetInvestmentTransactionsWithOptions(
     const std::string &access_token,
-    const GetInvestmentTransactionsOptions &options) {
+    const GetInvestmentTransactionsOptions &options, const CallOptions &call) {
+  auto start = [&](Callback<GetInvestmentTransactionsResponse> cb) {
+    GetInvestmentTransactionsWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetInvestmentTransactionsResponse>(start);
+}
+
+void Client::GetInvestmentTransactionsWithOptionsAsync(
+    const std::string &access_token,
+    const GetInvestmentTransactionsOptions &options,
+    Callback<GetInvestmentTransactionsResponse> cb, const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetInvestmentTransactionsResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("investments/transactions/get"));
-    auto req_data = GetInvestmentTransactionsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req_data.set_start_date(options.start_date());
-    req_data.set_end_date(options.end_date());
-    auto req_ops = GetInvestmentTransactionsRequestOptions();
-    req_ops.set_count(options.count());
-    req_ops.set_offset(options.offset());
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_ops.add_account_ids(options.account_ids(i));
-    *req_data.mutable_options() = req_ops;
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetInvestmentTransactionsResponse>(req);
+    return cb(StatusWrapped<GetInvestmentTransactionsResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetInvestmentTransactionsRequest();
+  req_data.set_access_token(access_token);
+  req_data.set_start_date(options.start_date());
+  req_data.set_end_date(options.end_date());
+  auto req_ops = GetInvestmentTransactionsRequestOptions();
+  req_ops.set_count(options.count());
+  req_ops.set_offset(options.offset());
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_ops.add_account_ids(options.account_ids(i));
+  *req_data.mutable_options() = req_ops;
+  Call<GetInvestmentTransactionsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetInvestmentTransactionsResponse>
-Client::GetInvestmentTransactions(const std::string &access_token) {
+Client::GetInvestmentTransactions(const std::string &access_token,
+                                  const CallOptions &call) {
   return GetInvestmentTransactionsWithOptions(
-      access_token, GetInvestmentTransactionsOptions());
+      access_token, GetInvestmentTransactionsOptions(), call);
+}
+
+void Client::GetInvestmentTransactionsAsync(
+    const std::string &access_token,
+    Callback<GetInvestmentTransactionsResponse> cb, const CallOptions &call) {
+  GetInvestmentTransactionsWithOptionsAsync(access_token,
+                                            GetInvestmentTransactionsOptions(),
+                                            cb, call);
+}
+
+StatusWrapped<GetInvestmentTransactionsResponse>
+Client::GetAllInvestmentTransactions(
+    const std::string &access_token,
+    const GetInvestmentTransactionsOptions &options, const CallOptions &call) {
+  auto start = [&](Callback<GetInvestmentTransactionsResponse> cb) {
+    GetAllInvestmentTransactionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetInvestmentTransactionsResponse>(start);
+}
+
+// Appends the later pages to the first, keeping the first copy of each
+// transaction and security. Pages can overlap when transactions land while
+// they are being read.
+static GetInvestmentTransactionsResponse
+merge_investment_pages(std::vector<GetInvestmentTransactionsResponse> pages) {
+  GetInvestmentTransactionsResponse merged;
+  merged.set_request_id(pages[0].request_id());
+  merged.set_total_investment_transactions(
+      pages[0].total_investment_transactions());
+  merged.mutable_item()->Swap(pages[0].mutable_item());
+  merged.mutable_accounts()->Swap(pages[0].mutable_accounts());
+  std::unordered_set<std::string> transactions, securities;
+  for (auto &page : pages) {
+    for (auto &txn : *page.mutable_investment_transactions()) {
+      if (transactions.insert(txn.investment_transaction_id()).second)
+        *merged.add_investment_transactions() = std::move(txn);
+    }
+    for (auto &security : *page.mutable_securities()) {
+      if (securities.insert(security.security_id()).second)
+        *merged.add_securities() = std::move(security);
+    }
+  }
+  return merged;
+}
+
+void Client::GetAllInvestmentTransactionsAsync(
+    const std::string &access_token,
+    const GetInvestmentTransactionsOptions &options,
+    Callback<GetInvestmentTransactionsResponse> cb, const CallOptions &call) {
+  using Response = GetInvestmentTransactionsResponse;
+  PageSizer &sizer = PageSizerFor(EndpointId::GetInvestmentTransactions);
+  auto size = page_size_for(sizer, options.count());
+
+  auto fetch = [this, access_token, options, call,
+                &sizer](int64_t offset, int64_t count,
+                        Callback<Response> page_cb) {
+    auto page = options;
+    page.set_offset(offset);
+    page.set_count(count);
+    GetInvestmentTransactionsWithOptionsAsync(
+        access_token, page,
+        TimedPage(sizer, &Response::investment_transactions_size, page_cb),
+        call);
+  };
+  auto done = [cb](StatusWrapped<std::vector<Response>> res) {
+    if (!res.IsOk())
+      return cb(StatusWrapped<Response>::FromStatus(res.GetStatus()));
+    cb(StatusWrapped<Response>(merge_investment_pages(res.Take())));
+  };
+  PagedRead<Response>::Read(
+      options.offset(), size(-1), fetch,
+      [](const Response &page) { return page.total_investment_transactions(); },
+      size, done);
 }
 
 // Items
 
-StatusWrapped<GetItemResponse>
-Client::GetItem(const std::string &access_token) {
-  if (access_token == "")
-    return StatusWrapped<GetItemResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/get"));
-    auto req_data = GetItemRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+StatusWrapped<GetItemResponse> Client::GetItem(const std::string &access_token,
+                                               const CallOptions &call) {
+  auto start = [&](Callback<GetItemResponse> cb) {
+    GetItemAsync(access_token, cb, call);
   };
-  return make_plaid_request<GetItemResponse>(req);
+  return Await<GetItemResponse>(start);
 }
 
-StatusWrapped<RemoveItemResponse>
-Client::RemoveItem(const std::string &access_token) {
+void Client::GetItemAsync(const std::string &access_token,
+                          Callback<GetItemResponse> cb,
+                          const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<RemoveItemResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/remove"));
-    auto req_data = RemoveItemRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+    return cb(StatusWrapped<GetItemResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetItemRequest();
+  req_data.set_access_token(access_token);
+  Call<GetItemEndpoint>(req_data, cb, call);
+}
+
+StatusWrapped<RemoveItemResponse>
+Client::RemoveItem(const std::string &access_token, const CallOptions &call) {
+  auto start = [&](Callback<RemoveItemResponse> cb) {
+    RemoveItemAsync(access_token, cb, call);
   };
-  return make_plaid_request<RemoveItemResponse>(req);
+  return Await<RemoveItemResponse>(start);
+}
+
+void Client::RemoveItemAsync(const std::string &access_token,
+                             Callback<RemoveItemResponse> cb,
+                             const CallOptions &call) {
+  if (access_token == "")
+    return cb(StatusWrapped<RemoveItemResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = RemoveItemRequest();
+  req_data.set_access_token(access_token);
+  Call<RemoveItemEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<UpdateItemWebhookResponse>
 Client::UpdateItemWebhook(const std::string &access_token,
-                          const std::string &webhook) {
+                          const std::string &webhook, const CallOptions &call) {
+  auto start = [&](Callback<UpdateItemWebhookResponse> cb) {
+    UpdateItemWebhookAsync(access_token, webhook, cb, call);
+  };
+  return Await<UpdateItemWebhookResponse>(start);
+}
+
+void Client::UpdateItemWebhookAsync(const std::string &access_token,
+                                    const std::string &webhook,
+                                    Callback<UpdateItemWebhookResponse> cb,
+                                    const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<UpdateItemWebhookResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
+    return cb(StatusWrapped<UpdateItemWebhookResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
   if (webhook == "")
-    return StatusWrapped<UpdateItemWebhookResponse>::FromStatus(
-        Status::MissingInfo("missing webhook"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/webhook/update"));
-    auto req_data = UpdateItemWebhookRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req_data.set_webhook(webhook);
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<UpdateItemWebhookResponse>(req);
+    return cb(StatusWrapped<UpdateItemWebhookResponse>::FromStatus(
+        Status::MissingInfo("missing webhook")));
+  auto req_data = UpdateItemWebhookRequest();
+  req_data.set_access_token(access_token);
+  req_data.set_webhook(webhook);
+  Call<UpdateItemWebhookEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<InvalidateAccessTokenResponse>
-Client::InvalidateAccessToken(const std::string &access_token) {
-  if (access_token == "")
-    return StatusWrapped<InvalidateAccessTokenResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/access_token/invalidate"));
-    auto req_data = InvalidateAccessTokenRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+Client::InvalidateAccessToken(const std::string &access_token,
+                              const CallOptions &call) {
+  auto start = [&](Callback<InvalidateAccessTokenResponse> cb) {
+    InvalidateAccessTokenAsync(access_token, cb, call);
   };
-  return make_plaid_request<InvalidateAccessTokenResponse>(req);
+  return Await<InvalidateAccessTokenResponse>(start);
 }
 
-StatusWrapped<UpdateAccessTokenVersionResponse>
-Client::UpdateAccessTokenVersion(const std::string &access_token) {
+void Client::InvalidateAccessTokenAsync(
+    const std::string &access_token, Callback<InvalidateAccessTokenResponse> cb,
+    const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<UpdateAccessTokenVersionResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/access_token/update_version"));
-    auto req_data = UpdateAccessTokenVersionRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token_v1(access_token);
-    req.SetBody(req_data);
-    return req;
+    return cb(StatusWrapped<InvalidateAccessTokenResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = InvalidateAccessTokenRequest();
+  req_data.set_access_token(access_token);
+  Call<InvalidateAccessTokenEndpoint>(req_data, cb, call);
+}
+
+StatusWrapped<UpdateAccessTokenVersionResponse>
+Client::UpdateAccessTokenVersion(const std::string &access_token,
+                                 const CallOptions &call) {
+  auto start = [&](Callback<UpdateAccessTokenVersionResponse> cb) {
+    UpdateAccessTokenVersionAsync(access_token, cb, call);
   };
-  return make_plaid_request<UpdateAccessTokenVersionResponse>(req);
+  return Await<UpdateAccessTokenVersionResponse>(start);
 }
 
-StatusWrapped<CreatePublicTokenResponse>
-Client::CreatePublicToken(const std::string &access_token) {
+void Client::UpdateAccessTokenVersionAsync(
+    const std::string &access_token,
+    Callback<UpdateAccessTokenVersionResponse> cb, const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<CreatePublicTokenResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/public_token/create"));
-    auto req_data = CreatePublicTokenRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+    return cb(StatusWrapped<UpdateAccessTokenVersionResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = UpdateAccessTokenVersionRequest();
+  req_data.set_access_token_v1(access_token);
+  Call<UpdateAccessTokenVersionEndpoint>(req_data, cb, call);
+}
+
+StatusWrapped<CreatePublicTokenResponse>
+Client::CreatePublicToken(const std::string &access_token,
+                          const CallOptions &call) {
+  auto start = [&](Callback<CreatePublicTokenResponse> cb) {
+    CreatePublicTokenAsync(access_token, cb, call);
   };
-  return make_plaid_request<CreatePublicTokenResponse>(req);
+  return Await<CreatePublicTokenResponse>(start);
+}
+
+void Client::CreatePublicTokenAsync(const std::string &access_token,
+                                    Callback<CreatePublicTokenResponse> cb,
+                                    const CallOptions &call) {
+  if (access_token == "")
+    return cb(StatusWrapped<CreatePublicTokenResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = CreatePublicTokenRequest();
+  req_data.set_access_token(access_token);
+  Call<CreatePublicTokenEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<ExchangePublicTokenResponse>
-Client::ExchangePublicToken(const std::string &public_token) {
-  if (public_token == "")
-    return StatusWrapped<ExchangePublicTokenResponse>::FromStatus(
-        Status::MissingInfo("missing public token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("item/public_token/exchange"));
-    auto req_data = ExchangePublicTokenRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_public_token(public_token);
-    req.SetBody(req_data);
-    return req;
+Client::ExchangePublicToken(const std::string &public_token,
+                            const CallOptions &call) {
+  auto start = [&](Callback<ExchangePublicTokenResponse> cb) {
+    ExchangePublicTokenAsync(public_token, cb, call);
   };
-  return make_plaid_request<ExchangePublicTokenResponse>(req);
+  return Await<ExchangePublicTokenResponse>(start);
+}
+
+void Client::ExchangePublicTokenAsync(const std::string &public_token,
+                                      Callback<ExchangePublicTokenResponse> cb,
+                                      const CallOptions &call) {
+  if (public_token == "")
+    return cb(StatusWrapped<ExchangePublicTokenResponse>::FromStatus(
+        Status::MissingInfo("missing public token")));
+  auto req_data = ExchangePublicTokenRequest();
+  req_data.set_public_token(public_token);
+  Call<ExchangePublicTokenEndpoint>(req_data, cb, call);
 }
 
 // Liabilities
 
 StatusWrapped<GetLiabilitiesResponse>
 Client::GetLiabilitiesWithOptions(const std::string &access_token,
-                                  const GetLiabilitiesOptions &options) {
+                                  const GetLiabilitiesOptions &options,
+                                  const CallOptions &call) {
+  auto start = [&](Callback<GetLiabilitiesResponse> cb) {
+    GetLiabilitiesWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetLiabilitiesResponse>(start);
+}
+
+void Client::GetLiabilitiesWithOptionsAsync(
+    const std::string &access_token, const GetLiabilitiesOptions &options,
+    Callback<GetLiabilitiesResponse> cb, const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<GetLiabilitiesResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("liabilities/get"));
-    auto req_data = GetLiabilitiesRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    for (int i = 0; i < options.account_ids_size(); ++i)
-      req_data.mutable_options()->add_account_ids(options.account_ids(i));
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetLiabilitiesResponse>(req);
+    return cb(StatusWrapped<GetLiabilitiesResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = GetLiabilitiesRequest();
+  req_data.set_access_token(access_token);
+  for (int i = 0; i < options.account_ids_size(); ++i)
+    req_data.mutable_options()->add_account_ids(options.account_ids(i));
+  Call<GetLiabilitiesEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetLiabilitiesResponse>
-Client::GetLiabilities(const std::string &access_token) {
-  return GetLiabilitiesWithOptions(access_token, GetLiabilitiesOptions());
+Client::GetLiabilities(const std::string &access_token,
+                       const CallOptions &call) {
+  return GetLiabilitiesWithOptions(access_token, GetLiabilitiesOptions(), call);
+}
+
+void Client::GetLiabilitiesAsync(const std::string &access_token,
+                                 Callback<GetLiabilitiesResponse> cb,
+                                 const CallOptions &call) {
+  GetLiabilitiesWithOptionsAsync(access_token, GetLiabilitiesOptions(), cb,
+                                 call);
 }
 
 // Payments
@@ -526,177 +1212,225 @@ Client::GetLiabilities(const std::string &access_token) {
 StatusWrapped<CreatePaymentRecipientResponse>
 Client::Client::CreatePaymentRecipient(const std::string &name,
                                        const std::string &iban,
-                                       const PaymentRecipientAddress &address) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/recipient/create"));
-    auto req_data = CreatePaymentRecipientRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_name(name);
-    req_data.set_iban(iban);
-    *req_data.mutable_address() = address;
-    req.SetBody(req_data);
-    return req;
+                                       const PaymentRecipientAddress &address,
+                                       const CallOptions &call) {
+  auto start = [&](Callback<CreatePaymentRecipientResponse> cb) {
+    CreatePaymentRecipientAsync(name, iban, address, cb, call);
   };
-  return make_plaid_request<CreatePaymentRecipientResponse>(req);
+  return Await<CreatePaymentRecipientResponse>(start);
+}
+
+void Client::Client::CreatePaymentRecipientAsync(
+    const std::string &name, const std::string &iban,
+    const PaymentRecipientAddress &address,
+    Callback<CreatePaymentRecipientResponse> cb, const CallOptions &call) {
+  auto req_data = CreatePaymentRecipientRequest();
+  req_data.set_name(name);
+  req_data.set_iban(iban);
+  *req_data.mutable_address() = address;
+  Call<CreatePaymentRecipientEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetPaymentRecipientResponse>
-Client::GetPaymentRecipient(const std::string &recipient_id) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/recipient/get"));
-    auto req_data = GetPaymentRecipientRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_recipient_id(recipient_id);
-    req.SetBody(req_data);
-    return req;
+Client::GetPaymentRecipient(const std::string &recipient_id,
+                            const CallOptions &call) {
+  auto start = [&](Callback<GetPaymentRecipientResponse> cb) {
+    GetPaymentRecipientAsync(recipient_id, cb, call);
   };
-  return make_plaid_request<GetPaymentRecipientResponse>(req);
+  return Await<GetPaymentRecipientResponse>(start);
+}
+
+void Client::GetPaymentRecipientAsync(const std::string &recipient_id,
+                                      Callback<GetPaymentRecipientResponse> cb,
+                                      const CallOptions &call) {
+  auto req_data = GetPaymentRecipientRequest();
+  req_data.set_recipient_id(recipient_id);
+  Call<GetPaymentRecipientEndpoint>(req_data, cb, call);
 }
 
-StatusWrapped<ListPaymentRecipientsResponse> Client::ListPaymentRecipients() {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/recipient/list"));
-    auto req_data = ListPaymentRecipientsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req.SetBody(req_data);
-    return req;
+StatusWrapped<ListPaymentRecipientsResponse>
+Client::ListPaymentRecipients(const CallOptions &call) {
+  auto start = [&](Callback<ListPaymentRecipientsResponse> cb) {
+    ListPaymentRecipientsAsync(cb, call);
   };
-  return make_plaid_request<ListPaymentRecipientsResponse>(req);
+  return Await<ListPaymentRecipientsResponse>(start);
+}
+
+void Client::ListPaymentRecipientsAsync(
+    Callback<ListPaymentRecipientsResponse> cb, const CallOptions &call) {
+  auto req_data = ListPaymentRecipientsRequest();
+  Call<ListPaymentRecipientsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<CreatePaymentResponse>
 Client::CreatePayment(const std::string &recipient_id,
-                      const std::string &reference,
-                      const PaymentAmount &amount) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/payment/create"));
-    auto req_data = CreatePaymentRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_recipient_id(recipient_id);
-    req_data.set_reference(reference);
-    *req_data.mutable_amount() = amount;
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<CreatePaymentResponse>(req);
+                      const std::string &reference, const PaymentAmount &amount,
+                      const CallOptions &call) {
+  auto start = [&](Callback<CreatePaymentResponse> cb) {
+    CreatePaymentAsync(recipient_id, reference, amount, cb, call);
+  };
+  return Await<CreatePaymentResponse>(start);
+}
+
+void Client::CreatePaymentAsync(const std::string &recipient_id,
+                                const std::string &reference,
+                                const PaymentAmount &amount,
+                                Callback<CreatePaymentResponse> cb,
+                                const CallOptions &call) {
+  auto req_data = CreatePaymentRequest();
+  req_data.set_recipient_id(recipient_id);
+  req_data.set_reference(reference);
+  *req_data.mutable_amount() = amount;
+  Call<CreatePaymentEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<CreatePaymentTokenResponse>
-Client::CreatePaymentToken(const std::string &payment_id) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/payment/token/create"));
-    auto req_data = CreatePaymentTokenRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_payment_id(payment_id);
-    req.SetBody(req_data);
-    return req;
+Client::CreatePaymentToken(const std::string &payment_id,
+                           const CallOptions &call) {
+  auto start = [&](Callback<CreatePaymentTokenResponse> cb) {
+    CreatePaymentTokenAsync(payment_id, cb, call);
   };
-  return make_plaid_request<CreatePaymentTokenResponse>(req);
+  return Await<CreatePaymentTokenResponse>(start);
+}
+
+void Client::CreatePaymentTokenAsync(const std::string &payment_id,
+                                     Callback<CreatePaymentTokenResponse> cb,
+                                     const CallOptions &call) {
+  auto req_data = CreatePaymentTokenRequest();
+  req_data.set_payment_id(payment_id);
+  Call<CreatePaymentTokenEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetPaymentResponse>
-Client::GetPayment(const std::string &payment_id) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/payment/get"));
-    auto req_data = GetPaymentRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_payment_id(payment_id);
-    req.SetBody(req_data);
-    return req;
+Client::GetPayment(const std::string &payment_id, const CallOptions &call) {
+  auto start = [&](Callback<GetPaymentResponse> cb) {
+    GetPaymentAsync(payment_id, cb, call);
   };
-  return make_plaid_request<GetPaymentResponse>(req);
+  return Await<GetPaymentResponse>(start);
+}
+
+void Client::GetPaymentAsync(const std::string &payment_id,
+                             Callback<GetPaymentResponse> cb,
+                             const CallOptions &call) {
+  auto req_data = GetPaymentRequest();
+  req_data.set_payment_id(payment_id);
+  Call<GetPaymentEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<ListPaymentsResponse>
-Client::ListPayments(const ListPaymentsOptions &options) {
-  auto req = [&]() {
-    auto req = Request(AppendUrl("payment_initiation/payment/list"));
-    auto req_data = ListPaymentsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_count(options.count());
-    req_data.set_cursor(options.cursor());
-    req.SetBody(req_data);
-    return req;
+Client::ListPayments(const ListPaymentsOptions &options,
+                     const CallOptions &call) {
+  auto start = [&](Callback<ListPaymentsResponse> cb) {
+    ListPaymentsAsync(options, cb, call);
   };
-  return make_plaid_request<ListPaymentsResponse>(req);
+  return Await<ListPaymentsResponse>(start);
+}
+
+void Client::ListPaymentsAsync(const ListPaymentsOptions &options,
+                               Callback<ListPaymentsResponse> cb,
+                               const CallOptions &call) {
+  auto req_data = ListPaymentsRequest();
+  req_data.set_count(options.count());
+  req_data.set_cursor(options.cursor());
+  Call<ListPaymentsEndpoint>(req_data, cb, call);
 }
 
 // Processors
 
-static StatusWrapped<CreateProcessorTokenResponse>
-CreateToken(const std::string &client_id, const std::string &secret,
-            const std::string &url, const std::string &access_token,
-            const std::string &account_id) {
+template <class E>
+void Client::CreateProcessorTokenAsync(
+    const std::string &access_token, const std::string &account_id,
+    Callback<CreateProcessorTokenResponse> cb, const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<CreateProcessorTokenResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
+    return cb(StatusWrapped<CreateProcessorTokenResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
   if (account_id == "")
-    return StatusWrapped<CreateProcessorTokenResponse>::FromStatus(
-        Status::MissingInfo("missing account id"));
-  auto req = [&]() {
-    auto req = Request(url);
-    auto req_data = CreateProcessorTokenRequest();
-    req_data.set_client_id(client_id);
-    req_data.set_secret(secret);
-    req_data.set_access_token(access_token);
-    req_data.set_account_id(account_id);
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<CreateProcessorTokenResponse>(req);
+    return cb(StatusWrapped<CreateProcessorTokenResponse>::FromStatus(
+        Status::MissingInfo("missing account id")));
+  auto req_data = CreateProcessorTokenRequest();
+  req_data.set_access_token(access_token);
+  req_data.set_account_id(account_id);
+  Call<E>(req_data, cb, call);
 }
 
 StatusWrapped<CreateProcessorTokenResponse>
 Client::CreateApexToken(const std::string &access_token,
-                        const std::string &account_id) {
-  return CreateToken(creds_.client_id, creds_.secret,
-                     AppendUrl("processor/apex/processor_token/create"),
-                     access_token, account_id);
+                        const std::string &account_id,
+                        const CallOptions &call) {
+  auto start = [&](Callback<CreateProcessorTokenResponse> cb) {
+    CreateApexTokenAsync(access_token, account_id, cb, call);
+  };
+  return Await<CreateProcessorTokenResponse>(start);
+}
+
+void Client::CreateApexTokenAsync(const std::string &access_token,
+                                  const std::string &account_id,
+                                  Callback<CreateProcessorTokenResponse> cb,
+                                  const CallOptions &call) {
+  CreateProcessorTokenAsync<CreateApexTokenEndpoint>(access_token, account_id,
+                                                     cb, call);
 }
 
 StatusWrapped<CreateProcessorTokenResponse>
 Client::CreateDwollaToken(const std::string &access_token,
-                          const std::string &account_id) {
-  return CreateToken(creds_.client_id, creds_.secret,
-                     AppendUrl("processor/dwolla/processor_token/create"),
-                     access_token, account_id);
+                          const std::string &account_id,
+                          const CallOptions &call) {
+  auto start = [&](Callback<CreateProcessorTokenResponse> cb) {
+    CreateDwollaTokenAsync(access_token, account_id, cb, call);
+  };
+  return Await<CreateProcessorTokenResponse>(start);
+}
+
+void Client::CreateDwollaTokenAsync(const std::string &access_token,
+                                    const std::string &account_id,
+                                    Callback<CreateProcessorTokenResponse> cb,
+                                    const CallOptions &call) {
+  CreateProcessorTokenAsync<CreateDwollaTokenEndpoint>(access_token, account_id,
+                                                       cb, call);
 }
 
 StatusWrapped<CreateProcessorTokenResponse>
 Client::CreateOcrolusToken(const std::string &access_token,
-                           const std::string &account_id) {
-  return CreateToken(creds_.client_id, creds_.secret,
-                     AppendUrl("processor/ocrolus/processor_token/create"),
-                     access_token, account_id);
+                           const std::string &account_id,
+                           const CallOptions &call) {
+  auto start = [&](Callback<CreateProcessorTokenResponse> cb) {
+    CreateOcrolusTokenAsync(access_token, account_id, cb, call);
+  };
+  return Await<CreateProcessorTokenResponse>(start);
+}
+
+void Client::CreateOcrolusTokenAsync(const std::string &access_token,
+                                     const std::string &account_id,
+                                     Callback<CreateProcessorTokenResponse> cb,
+                                     const CallOptions &call) {
+  CreateProcessorTokenAsync<CreateOcrolusTokenEndpoint>(access_token,
+                                                        account_id, cb, call);
 }
 
 StatusWrapped<CreateStripeTokenResponse>
 Client::CreateStripeToken(const std::string &access_token,
-                          const std::string &account_id) {
+                          const std::string &account_id,
+                          const CallOptions &call) {
+  auto start = [&](Callback<CreateStripeTokenResponse> cb) {
+    CreateStripeTokenAsync(access_token, account_id, cb, call);
+  };
+  return Await<CreateStripeTokenResponse>(start);
+}
+
+void Client::CreateStripeTokenAsync(const std::string &access_token,
+                                    const std::string &account_id,
+                                    Callback<CreateStripeTokenResponse> cb,
+                                    const CallOptions &call) {
   if (access_token == "")
-    return StatusWrapped<CreateStripeTokenResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
+    return cb(StatusWrapped<CreateStripeTokenResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
   if (account_id == "")
-    return StatusWrapped<CreateStripeTokenResponse>::FromStatus(
-        Status::MissingInfo("missing account id"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("processor/stripe/bank_account_token/create"));
-    auto req_data = CreateStripeTokenRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req_data.set_account_id(account_id);
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<CreateStripeTokenResponse>(req);
+    return cb(StatusWrapped<CreateStripeTokenResponse>::FromStatus(
+        Status::MissingInfo("missing account id")));
+  auto req_data = CreateStripeTokenRequest();
+  req_data.set_access_token(access_token);
+  req_data.set_account_id(account_id);
+  Call<CreateStripeTokenEndpoint>(req_data, cb, call);
 }
 
 // Sandbox
@@ -704,80 +1438,366 @@ Client::CreateStripeToken(const std::string &access_token,
 StatusWrapped<CreateSandboxPublicTokenResponse>
 Client::CreateSandboxPublicToken(
     const std::string &institution_id,
-    const std::vector<std::string> &initial_products) {
+    const std::vector<std::string> &initial_products, const CallOptions &call) {
+  auto start = [&](Callback<CreateSandboxPublicTokenResponse> cb) {
+    CreateSandboxPublicTokenAsync(institution_id, initial_products, cb, call);
+  };
+  return Await<CreateSandboxPublicTokenResponse>(start);
+}
+
+void Client::CreateSandboxPublicTokenAsync(
+    const std::string &institution_id,
+    const std::vector<std::string> &initial_products,
+    Callback<CreateSandboxPublicTokenResponse> cb, const CallOptions &call) {
   if (institution_id == "")
-    return StatusWrapped<CreateSandboxPublicTokenResponse>::FromStatus(
-        Status::MissingInfo("missing institution id"));
+    return cb(StatusWrapped<CreateSandboxPublicTokenResponse>::FromStatus(
+        Status::MissingInfo("missing institution id")));
   if (initial_products.size() == 0)
-    return StatusWrapped<CreateSandboxPublicTokenResponse>::FromStatus(
-        Status::MissingInfo("missing initial products"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("sandbox/public_token/create"));
-    auto req_data = CreateSandboxPublicTokenRequest();
-    req_data.set_institution_id(institution_id);
-    req_data.set_public_key(creds_.public_key);
-    for (const auto &product : initial_products)
-      req_data.add_inital_products(product);
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<CreateSandboxPublicTokenResponse>(req);
+    return cb(StatusWrapped<CreateSandboxPublicTokenResponse>::FromStatus(
+        Status::MissingInfo("missing initial products")));
+  auto req_data = CreateSandboxPublicTokenRequest();
+  req_data.set_institution_id(institution_id);
+  for (const auto &product : initial_products)
+    req_data.add_inital_products(product);
+  Call<CreateSandboxPublicTokenEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<ResetSandboxItemResponse>
-Client::ResetSandboxItem(const std::string &access_token) {
-  if (access_token == "")
-    return StatusWrapped<ResetSandboxItemResponse>::FromStatus(
-        Status::MissingInfo("missing access token"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("sandbox/item/reset_login"));
-    auto req_data = ResetSandboxItemRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req.SetBody(req_data);
-    return req;
+Client::ResetSandboxItem(const std::string &access_token,
+                         const CallOptions &call) {
+  auto start = [&](Callback<ResetSandboxItemResponse> cb) {
+    ResetSandboxItemAsync(access_token, cb, call);
   };
-  return make_plaid_request<ResetSandboxItemResponse>(req);
+  return Await<ResetSandboxItemResponse>(start);
+}
+
+void Client::ResetSandboxItemAsync(const std::string &access_token,
+                                   Callback<ResetSandboxItemResponse> cb,
+                                   const CallOptions &call) {
+  if (access_token == "")
+    return cb(StatusWrapped<ResetSandboxItemResponse>::FromStatus(
+        Status::MissingInfo("missing access token")));
+  auto req_data = ResetSandboxItemRequest();
+  req_data.set_access_token(access_token);
+  Call<ResetSandboxItemEndpoint>(req_data, cb, call);
 }
 
 // Transactions
 
 StatusWrapped<GetTransactionsResponse>
 Client::GetTransactionsWithOptions(const std::string &access_token,
-                                   const GetTransactionsOptions &options) {
+                                   const GetTransactionsOptions &options,
+                                   const CallOptions &call) {
+  auto start = [&](Callback<GetTransactionsResponse> cb) {
+    GetTransactionsWithOptionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetTransactionsResponse>(start);
+}
+
+void Client::GetTransactionsWithOptionsAsync(
+    const std::string &access_token, const GetTransactionsOptions &options,
+    Callback<GetTransactionsResponse> cb, const CallOptions &call) {
   if (options.start_date() == "")
-    return StatusWrapped<GetTransactionsResponse>::FromStatus(
-        Status::MissingInfo("missing start date"));
+    return cb(StatusWrapped<GetTransactionsResponse>::FromStatus(
+        Status::MissingInfo("missing start date")));
   if (options.end_date() == "")
-    return StatusWrapped<GetTransactionsResponse>::FromStatus(
-        Status::MissingInfo("missing end date"));
-  auto req = [&]() {
-    auto req = Request(AppendUrl("transactions/get"));
-    auto req_data = GetTransactionsRequest();
-    req_data.set_client_id(creds_.client_id);
-    req_data.set_secret(creds_.secret);
-    req_data.set_access_token(access_token);
-    req_data.set_start_date(options.start_date());
-    req_data.set_end_date(options.end_date());
-    req_data.mutable_options()->set_count(options.count());
-    req_data.mutable_options()->set_offset(options.offset());
-    req.SetBody(req_data);
-    return req;
-  };
-  return make_plaid_request<GetTransactionsResponse>(req);
+    return cb(StatusWrapped<GetTransactionsResponse>::FromStatus(
+        Status::MissingInfo("missing end date")));
+  auto req_data = GetTransactionsRequest();
+  req_data.set_access_token(access_token);
+  req_data.set_start_date(options.start_date());
+  req_data.set_end_date(options.end_date());
+  req_data.mutable_options()->set_count(options.count());
+  req_data.mutable_options()->set_offset(options.offset());
+  Call<GetTransactionsEndpoint>(req_data, cb, call);
 }
 
 StatusWrapped<GetTransactionsResponse>
 Client::GetTransactions(const std::string &access_token,
                         const std::string &start_date,
-                        const std::string &end_date) {
+                        const std::string &end_date, const CallOptions &call) {
+  auto options = GetTransactionsOptions();
+  options.set_start_date(start_date);
+  options.set_end_date(end_date);
+  options.set_count(100);
+  options.set_offset(0);
+  return GetTransactionsWithOptions(access_token, options, call);
+}
+
+void Client::GetTransactionsAsync(const std::string &access_token,
+                                  const std::string &start_date,
+                                  const std::string &end_date,
+                                  Callback<GetTransactionsResponse> cb,
+                                  const CallOptions &call) {
   auto options = GetTransactionsOptions();
   options.set_start_date(start_date);
   options.set_end_date(end_date);
   options.set_count(100);
   options.set_offset(0);
-  return GetTransactionsWithOptions(access_token, options);
+  GetTransactionsWithOptionsAsync(access_token, options, cb, call);
+}
+
+// Days since 1970-01-01 of a YYYY-MM-DD date; false if it isn't one.
+static bool parse_date(const std::string &date, int64_t &days) {
+  int y, m, d;
+  char tail;
+  if (sscanf(date.c_str(), "%4d-%2d-%2d%c", &y, &m, &d, &tail) != 3 ||
+      m < 1 || m > 12 || d < 1 || d > 31)
+    return false;
+  // Howard Hinnant's days_from_civil.
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const int64_t yoe = y - era * 400;
+  const int64_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  days = era * 146097 + doe - 719468;
+  return true;
+}
+
+static std::string format_date(int64_t days) {
+  days += 719468;
+  const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const int64_t doe = days - era * 146097;
+  const int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const int64_t mp = (5 * doy + 2) / 153;
+  const int d = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+  const int m = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  const int y = static_cast<int>(yoe + era * 400 + (m <= 2));
+  char buf[16];
+  snprintf(buf, sizeof(buf), "%04d-%02d-%02d", y, m, d);
+  return buf;
+}
+
+// Keeps the first copy of each transaction, in page order. Windows and
+// pages overlap where transactions land or pending ones post mid-read.
+static GetTransactionsResponse
+merge_transaction_pages(std::vector<GetTransactionsResponse> pages) {
+  GetTransactionsResponse merged;
+  merged.set_request_id(pages[0].request_id());
+  merged.set_total_transactions(pages[0].total_transactions());
+  merged.mutable_item()->Swap(pages[0].mutable_item());
+  merged.mutable_accounts()->Swap(pages[0].mutable_accounts());
+  std::unordered_set<std::string> seen;
+  for (auto &page : pages) {
+    for (auto &txn : *page.mutable_transactions()) {
+      if (seen.insert(txn.transaction_id()).second)
+        *merged.add_transactions() = std::move(txn);
+    }
+  }
+  return merged;
+}
+
+StatusWrapped<GetTransactionsResponse>
+Client::GetAllTransactions(const std::string &access_token,
+                           const GetTransactionsOptions &options,
+                           const CallOptions &call) {
+  auto start = [&](Callback<GetTransactionsResponse> cb) {
+    GetAllTransactionsAsync(access_token, options, cb, call);
+  };
+  return Await<GetTransactionsResponse>(start);
+}
+
+void Client::GetAllTransactionsAsync(const std::string &access_token,
+                                     const GetTransactionsOptions &options,
+                                     Callback<GetTransactionsResponse> cb,
+                                     const CallOptions &call) {
+  using Response = GetTransactionsResponse;
+  using Pages = StatusWrapped<std::vector<Response>>;
+  PageSizer &sizer = PageSizerFor(EndpointId::GetTransactions);
+  auto size = page_size_for(sizer, options.count());
+  auto range = options;
+  range.set_offset(0);
+  range.set_count(size(-1));
+
+  auto done = [cb](Pages res) {
+    if (!res.IsOk())
+      return cb(StatusWrapped<Response>::FromStatus(res.GetStatus()));
+    cb(StatusWrapped<Response>(merge_transaction_pages(res.Take())));
+  };
+  auto total = [](const Response &page) { return page.total_transactions(); };
+  // Pages of [start, end] by offset.
+  auto fetch_range = [this, access_token, range, call,
+                      &sizer](const std::string &start,
+                              const std::string &end) {
+    auto window = range;
+    window.set_start_date(start);
+    window.set_end_date(end);
+    return PagedRead<Response>::Fetch(
+        [this, access_token, window, call,
+         &sizer](int64_t offset, int64_t count, Callback<Response> page_cb) {
+          auto page = window;
+          page.set_offset(offset);
+          page.set_count(count);
+          GetTransactionsWithOptionsAsync(
+              access_token, page,
+              TimedPage(sizer, &Response::transactions_size, page_cb), call);
+        });
+  };
+
+  // The first page of the whole range tells how many transactions there
+  // are, and holds the newest of them. Deep offsets are slow for the API to
+  // serve, so rather than paging through the rest of the range it is split
+  // into windows of about a page each (assuming transactions are spread
+  // evenly over the days), newest first, each read from offset 0. Windows
+  // are read concurrently but each one's pages in turn, so the read as a
+  // whole keeps no more pages in flight than any other.
+  auto first = [range, total, size, fetch_range,
+                done](StatusWrapped<Response> res) {
+    if (!res.IsOk())
+      return done(Pages::FromStatus(res.GetStatus()));
+    Response probe = res.Take();
+    const int64_t read = probe.transactions_size();
+    const int64_t remaining = probe.total_transactions() - read;
+    if (remaining <= 0) {
+      std::vector<Response> pages;
+      pages.push_back(std::move(probe));
+      return done(Pages(std::move(pages)));
+    }
+    const int64_t page_size = size(remaining);
+    int64_t first_day, last_day;
+    if (!parse_date(range.start_date(), first_day) ||
+        !parse_date(range.end_date(), last_day) || last_day < first_day) {
+      const size_t pages = 1 + (remaining - 1) / page_size + 1;
+      return PagedRead<Response>::Start(
+          std::move(probe), read, page_size, pages,
+          fetch_range(range.start_date(), range.end_date()), done);
+    }
+    // The probe covers every day after its oldest transaction's, so the
+    // windows start from that day (which the probe may have only partly
+    // covered).
+    int64_t oldest_day = last_day;
+    for (const auto &txn : probe.transactions()) {
+      int64_t day;
+      if (parse_date(txn.date(), day))
+        oldest_day = std::min(oldest_day, day);
+    }
+    oldest_day = std::max(oldest_day, first_day);
+    const int64_t days = oldest_day - first_day + 1;
+    const int64_t window_days =
+        std::max<int64_t>(1, days * page_size / remaining);
+    auto windows = std::make_shared<
+        std::vector<std::pair<std::string, std::string>>>();
+    for (int64_t end = oldest_day; end >= first_day; end -= window_days) {
+      const int64_t start = std::max(first_day, end - window_days + 1);
+      windows->emplace_back(format_date(start), format_date(end));
+    }
+    // Window i is "page" i after the probe.
+    auto fetch_window = [windows, total, size, fetch_range,
+                         page_size](int64_t index, int64_t,
+                                    Callback<Response> window_cb) {
+      const auto &window = (*windows)[index - 1];
+      PagedRead<Response>::Read(
+          0, page_size, fetch_range(window.first, window.second), total, size,
+          [window_cb](Pages res) {
+            if (!res.IsOk())
+              return window_cb(
+                  StatusWrapped<Response>::FromStatus(res.GetStatus()));
+            window_cb(
+                StatusWrapped<Response>(merge_transaction_pages(res.Take())));
+          },
+          1);
+    };
+    PagedRead<Response>::Start(std::move(probe), 1, 1, windows->size() + 1,
+                               fetch_window, done);
+  };
+  Callback<Response> first_cb = first;
+  GetTransactionsWithOptionsAsync(
+      access_token, range,
+      TimedPage(sizer, &Response::transactions_size, first_cb), call);
+}
+
+// Webhooks
+
+StatusWrapped<GetWebhookVerificationKeyResponse>
+Client::GetWebhookVerificationKey(const std::string &key_id,
+                                  const CallOptions &call) {
+  auto start = [&](Callback<GetWebhookVerificationKeyResponse> cb) {
+    GetWebhookVerificationKeyAsync(key_id, cb, call);
+  };
+  return Await<GetWebhookVerificationKeyResponse>(start);
+}
+
+void Client::GetWebhookVerificationKeyAsync(
+    const std::string &key_id, Callback<GetWebhookVerificationKeyResponse> cb,
+    const CallOptions &call) {
+  if (key_id == "")
+    return cb(StatusWrapped<GetWebhookVerificationKeyResponse>::FromStatus(
+        Status::MissingInfo("missing key id")));
+  auto req_data = GetWebhookVerificationKeyRequest();
+  req_data.set_key_id(key_id);
+  Call<GetWebhookVerificationKeyEndpoint>(req_data, cb, call);
+}
+
+// Onboarding
+
+// Stores one read's outcome in the result shared by an onboarding's reads.
+template <typename T, typename State>
+static Callback<T> onboarding_read(std::shared_ptr<State> state,
+                                   T OnboardItemResult::*field,
+                                   Status OnboardItemResult::*status) {
+  return [state, field, status](StatusWrapped<T> res) {
+    state->result.*status = res.GetStatus();
+    if (res.IsOk())
+      state->result.*field = res.Take();
+    state->Finish();
+  };
+}
+
+StatusWrapped<OnboardItemResult>
+Client::OnboardItem(const std::string &public_token,
+                    const OnboardItemOptions &options,
+                    const CallOptions &call) {
+  auto start = [&](Callback<OnboardItemResult> cb) {
+    OnboardItemAsync(public_token, options, cb, call);
+  };
+  return Await<OnboardItemResult>(start);
+}
+
+void Client::OnboardItemAsync(const std::string &public_token,
+                              const OnboardItemOptions &options,
+                              Callback<OnboardItemResult> cb,
+                              const CallOptions &call) {
+  // The reads each fill in their own fields; whichever finishes last
+  // delivers the result.
+  struct State {
+    OnboardItemResult result;
+    std::atomic<int> remaining;
+    Callback<OnboardItemResult> done;
+
+    void Finish() {
+      if (remaining.fetch_sub(1) == 1)
+        done(std::move(result));
+    }
+  };
+
+  auto exchanged = [this, options, cb,
+                    call](StatusWrapped<ExchangePublicTokenResponse> res) {
+    if (!res.IsOk())
+      return cb(StatusWrapped<OnboardItemResult>::FromStatus(res.GetStatus()));
+    auto state = std::make_shared<State>();
+    state->result.exchange = res.Take();
+    state->remaining.store(1 + options.auth + options.identity +
+                           options.balances);
+    state->done = cb;
+    const std::string token = state->result.exchange.access_token();
+    using R = OnboardItemResult;
+    GetAccountsAsync(token,
+                     onboarding_read(state, &R::accounts, &R::accounts_status),
+                     call);
+    if (options.auth)
+      GetAuthAsync(token, onboarding_read(state, &R::auth, &R::auth_status),
+                   call);
+    if (options.identity)
+      GetIdentityAsync(
+          token, onboarding_read(state, &R::identity, &R::identity_status),
+          call);
+    if (options.balances)
+      GetBalancesAsync(
+          token, onboarding_read(state, &R::balances, &R::balances_status),
+          call);
+  };
+  ExchangePublicTokenAsync(public_token, exchanged, call);
 }
 
 } // namespace plaid
\ No newline at end of file
@@ -0,0 +1,121 @@
+#include "plaid/concurrency.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace plaid {
+
+constexpr double ConcurrencyLimit::kShortWeight;
+constexpr double ConcurrencyLimit::kBaselineSeconds;
+
+ConcurrencyLimit::ConcurrencyLimit()
+    : limit_(static_cast<double>(options_.initial_limit)),
+      published_(options_.initial_limit), in_flight_(0), waiting_(0) {}
+
+void ConcurrencyLimit::SetOptions(const ConcurrencyLimitOptions &options) {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  options_ = options;
+  options_changed_ = true;
+}
+
+ConcurrencyLimitOptions ConcurrencyLimit::Options() const {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  return options_;
+}
+
+size_t ConcurrencyLimit::Limit() const { return published_.load(); }
+
+ConcurrencyMetrics ConcurrencyLimit::Metrics() const {
+  ConcurrencyMetrics m;
+  m.limit = published_.load();
+  m.in_flight = in_flight_.load();
+  m.waiting = waiting_.load();
+  m.cuts = cuts_.Value();
+  return m;
+}
+
+void ConcurrencyLimit::Observe(size_t in_flight, size_t waiting) {
+  in_flight_.store(in_flight);
+  waiting_.store(waiting);
+}
+
+void ConcurrencyLimit::Publish() {
+  limit_ = std::max(limit_, static_cast<double>(current_.min_limit));
+  limit_ = std::min(limit_, static_cast<double>(current_.max_limit));
+  published_.store(static_cast<size_t>(limit_));
+}
+
+void ConcurrencyLimit::Cut(double factor, Clock::time_point now) {
+  limit_ *= factor;
+  slow_start_ = false;
+  last_cut_ = now;
+  cuts_.Add();
+}
+
+void ConcurrencyLimit::Record(const std::string &route,
+                              Clock::time_point started, Outcome outcome,
+                              size_t in_flight) {
+  {
+    std::lock_guard<std::mutex> lock(options_mu_);
+    if (options_changed_) {
+      // A new initial limit starts over from it.
+      if (current_.initial_limit != options_.initial_limit)
+        limit_ = static_cast<double>(options_.initial_limit);
+      current_ = options_;
+      options_changed_ = false;
+    }
+  }
+  if (outcome == Outcome::kIgnored)
+    return Publish();
+  const auto now = Clock::now();
+  // A request that was already in flight when the limit was last cut
+  // reflects the load from before the cut.
+  const bool after_cut = started >= last_cut_;
+  const double latency =
+      std::chrono::duration<double, std::micro>(now - started).count();
+  if (outcome == Outcome::kDeadline) {
+    auto it = baselines_.find(route);
+    const bool overdue = it != baselines_.end() &&
+                         it->second.samples >= kBaselineWarmup &&
+                         latency >= current_.tolerance * it->second.latency;
+    if (!overdue)
+      return Publish();
+    outcome = Outcome::kOverloaded;
+  }
+  if (outcome == Outcome::kOverloaded) {
+    if (after_cut)
+      Cut(current_.overload_backoff, now);
+    return Publish();
+  }
+
+  Baseline &baseline = baselines_[route];
+  double weight;
+  if (baseline.samples < kBaselineWarmup) {
+    weight = 1.0 / ++baseline.samples;
+  } else {
+    const double elapsed =
+        std::chrono::duration<double>(now - baseline.updated).count();
+    weight = 1 - std::exp(-elapsed / kBaselineSeconds);
+  }
+  baseline.latency += weight * (latency - baseline.latency);
+  baseline.updated = now;
+  // Until its baseline settles, an endpoint's latencies only feed it.
+  if (baseline.samples < kBaselineWarmup)
+    return Publish();
+  ratio_ += kShortWeight * (latency / std::max(baseline.latency, 1.0) - ratio_);
+
+  if (ratio_ > current_.tolerance) {
+    if (after_cut) {
+      Cut(current_.latency_backoff, now);
+      // Judge the new limit by the latencies it brings.
+      ratio_ = 1;
+    }
+  } else if (static_cast<double>(in_flight) * 2 >= limit_) {
+    // Only grow a limit that is being used; an idle client learns nothing
+    // about how much more it could send.
+    limit_ += slow_start_ ? 1 : 1 / limit_;
+  }
+  Publish();
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -0,0 +1,92 @@
+#include "plaid/hedging.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace plaid {
+
+LatencyHistogram::LatencyHistogram() : samples_(0) {
+  for (auto &bucket : buckets_)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+void LatencyHistogram::Record(std::chrono::microseconds latency) {
+  uint64_t us = latency.count() < 0 ? 0 : latency.count();
+  buckets_[BucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+  // Decay is racy with concurrent records, which at worst loses a sample or
+  // two; the estimate only has to track the shape of the distribution.
+  if ((samples_.fetch_add(1, std::memory_order_relaxed) + 1) % kWindow != 0)
+    return;
+  for (auto &bucket : buckets_)
+    bucket.fetch_sub(bucket.load(std::memory_order_relaxed) / 2,
+                     std::memory_order_relaxed);
+}
+
+std::chrono::microseconds LatencyHistogram::Percentile(double p) const {
+  uint64_t counts[kBuckets];
+  uint64_t total = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    counts[i] = buckets_[i].load(std::memory_order_relaxed);
+    total += counts[i];
+  }
+  if (total < kMinSamples)
+    return std::chrono::microseconds(0);
+  const uint64_t rank = std::max<uint64_t>(1, p * total + 0.5);
+  uint64_t seen = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += counts[i];
+    if (seen >= rank)
+      return std::chrono::microseconds(UpperBound(i));
+  }
+  return std::chrono::microseconds(UpperBound(kBuckets - 1));
+}
+
+// Values below 4us get a bucket each. Above that, a value with its top bit
+// at position e goes into one of four buckets for [2^e, 2^(e+1)), picked by
+// the next two bits.
+int LatencyHistogram::BucketFor(uint64_t us) {
+  if (us < 4)
+    return static_cast<int>(us);
+  int e = 63 - __builtin_clzll(us);
+  int sub = static_cast<int>((us >> (e - 2)) & 3);
+  return std::min(4 * (e - 1) + sub, kBuckets - 1);
+}
+
+uint64_t LatencyHistogram::UpperBound(int bucket) {
+  if (bucket < 4)
+    return bucket;
+  int e = bucket / 4 + 1;
+  uint64_t sub = bucket % 4;
+  return ((5 + sub) << (e - 2)) - 1;
+}
+
+HedgeBudget::HedgeBudget() : balance_(0) {}
+
+void HedgeBudget::Deposit(double fraction) {
+  const int64_t amount =
+      static_cast<int64_t>(std::min(std::max(fraction, 0.0), 1.0) * kUnit);
+  int64_t cur = balance_.load(std::memory_order_relaxed);
+  while (cur < kMaxBalance) {
+    int64_t next = cur + amount < kMaxBalance ? cur + amount : kMaxBalance;
+    if (balance_.compare_exchange_weak(cur, next, std::memory_order_relaxed))
+      return;
+  }
+}
+
+bool HedgeBudget::CanWithdraw() const {
+  return balance_.load(std::memory_order_relaxed) >= kUnit;
+}
+
+bool HedgeBudget::TryWithdraw() {
+  int64_t cur = balance_.load(std::memory_order_relaxed);
+  while (cur >= kUnit) {
+    if (balance_.compare_exchange_weak(cur, cur - kUnit,
+                                       std::memory_order_relaxed))
+      return true;
+  }
+  return false;
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -0,0 +1,495 @@
+#include "plaid/institutions.h"
+#include "plaid/client.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace plaid {
+
+static const char kSnapshotMagic[] = "PLAIDIC1";
+static const size_t kSnapshotMagicSize = sizeof(kSnapshotMagic) - 1;
+static const size_t kSnapshotHeaderSize = kSnapshotMagicSize + 8;
+
+static const std::vector<const Institution *> &
+lookup(const std::unordered_map<std::string,
+                                 std::vector<const Institution *>> &index,
+       const std::string &key) {
+  static const std::vector<const Institution *> none;
+  auto it = index.find(key);
+  return it == index.end() ? none : it->second;
+}
+
+// Lowercases letters and digits and collapses everything else into single
+// spaces, so "Chase Bank, N.A." and "chase bank n a" index alike.
+static std::string normalize(const std::string &text) {
+  std::string out;
+  for (unsigned char c : text) {
+    if (std::isalnum(c))
+      out.push_back(std::tolower(c));
+    else if (!out.empty() && out.back() != ' ')
+      out.push_back(' ');
+  }
+  if (!out.empty() && out.back() == ' ')
+    out.pop_back();
+  return out;
+}
+
+static std::vector<std::string> split_words(const std::string &normalized) {
+  std::vector<std::string> words;
+  size_t start = 0;
+  while (start < normalized.size()) {
+    size_t end = normalized.find(' ', start);
+    if (end == std::string::npos)
+      end = normalized.size();
+    words.push_back(normalized.substr(start, end - start));
+    start = end + 1;
+  }
+  return words;
+}
+
+// The host labels worth matching on: "https://www.chase.com/x" gives
+// "chase".
+static std::vector<std::string> url_words(const std::string &url) {
+  std::string host = url;
+  size_t scheme = host.find("://");
+  if (scheme != std::string::npos)
+    host = host.substr(scheme + 3);
+  host = host.substr(0, host.find('/'));
+  if (host.compare(0, 4, "www.") == 0)
+    host = host.substr(4);
+  size_t tld = host.rfind('.');
+  if (tld != std::string::npos)
+    host = host.substr(0, tld);
+  return split_words(normalize(host));
+}
+
+static std::vector<std::string> trigrams_of(const std::string &normalized) {
+  std::vector<std::string> out;
+  for (size_t i = 0; i + 3 <= normalized.size(); ++i)
+    out.push_back(normalized.substr(i, 3));
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return out;
+}
+
+static bool contains(
+    const google::protobuf::RepeatedPtrField<std::string> &values,
+    const std::string &value) {
+  return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+InstitutionIndex::InstitutionIndex(
+    GetInstitutionsResponse institutions,
+    std::chrono::system_clock::time_point fetched_at)
+    : fetched_at_(fetched_at) {
+  // Pages fetched concurrently can overlap when the catalog shifts under
+  // them, so keep the first listing of each institution.
+  data_.set_request_id(institutions.request_id());
+  std::unordered_set<std::string> seen;
+  for (auto &institution : *institutions.mutable_institutions()) {
+    if (seen.insert(institution.institution_id()).second)
+      *data_.add_institutions() = std::move(institution);
+  }
+  data_.set_total(data_.institutions_size());
+
+  all_.reserve(data_.institutions_size());
+  for (const auto &institution : data_.institutions()) {
+    all_.push_back(&institution);
+    by_id_[institution.institution_id()] = &institution;
+    for (const auto &product : institution.products())
+      by_product_[product].push_back(&institution);
+    for (const auto &country : institution.country_codes())
+      by_country_[country].push_back(&institution);
+  }
+
+  names_.reserve(all_.size());
+  for (uint32_t i = 0; i < all_.size(); ++i) {
+    names_.push_back(normalize(all_[i]->name()));
+    for (const auto &word : split_words(names_[i]))
+      words_.push_back(Word{word, i, false});
+    for (const auto &word : url_words(all_[i]->url()))
+      words_.push_back(Word{word, i, true});
+    for (const auto &trigram : trigrams_of(names_[i]))
+      trigrams_[trigram].push_back(i);
+  }
+  std::sort(words_.begin(), words_.end(), [](const Word &a, const Word &b) {
+    return a.text < b.text;
+  });
+}
+
+const Institution *
+InstitutionIndex::Find(const std::string &institution_id) const {
+  auto it = by_id_.find(institution_id);
+  return it == by_id_.end() ? nullptr : it->second;
+}
+
+const std::vector<const Institution *> &
+InstitutionIndex::WithProduct(const std::string &product) const {
+  return lookup(by_product_, product);
+}
+
+const std::vector<const Institution *> &
+InstitutionIndex::InCountry(const std::string &country_code) const {
+  return lookup(by_country_, country_code);
+}
+
+const std::vector<const Institution *> &InstitutionIndex::All() const {
+  return all_;
+}
+
+// Whether an institution offers all the products and, when any are given, at
+// least one of the country codes.
+static bool offers(const Institution &institution,
+                   const std::vector<std::string> &products,
+                   const std::vector<std::string> &country_codes) {
+  for (const auto &product : products) {
+    if (!contains(institution.products(), product))
+      return false;
+  }
+  for (const auto &country : country_codes) {
+    if (contains(institution.country_codes(), country))
+      return true;
+  }
+  return country_codes.empty();
+}
+
+std::vector<const Institution *>
+InstitutionIndex::Search(const std::string &query,
+                         const std::vector<std::string> &products,
+                         const std::vector<std::string> &country_codes,
+                         size_t limit) const {
+  const std::string q = normalize(query);
+  if (q.empty() || limit == 0)
+    return {};
+
+  // Scores fall in bands, so a weaker kind of match never outranks a
+  // stronger one; trigram matches score below kUrlWords.
+  const int kExact = 4000, kNamePrefix = 3000, kNameWords = 2000,
+            kUrlWords = 1000;
+  std::vector<std::pair<int, uint32_t>> ranked;
+
+  // Every query word has to start some name or URL word of a candidate. Per
+  // position, hit records where the current word matched (1 for the name,
+  // 2 for the URL); state remembers candidates that needed the URL for any
+  // word, and which positions are candidates at all.
+  const uint8_t kViaUrl = 1, kCandidate = 2;
+  std::vector<uint8_t> hit(all_.size(), 0), state(all_.size(), 0);
+  std::vector<uint32_t> candidates, touched;
+  bool first = true;
+  for (const auto &qword : split_words(q)) {
+    auto it = std::lower_bound(
+        words_.begin(), words_.end(), qword,
+        [](const Word &w, const std::string &key) { return w.text < key; });
+    for (; it != words_.end() && it->text.compare(0, qword.size(), qword) == 0;
+         ++it) {
+      if (!hit[it->position])
+        touched.push_back(it->position);
+      hit[it->position] |= it->in_url ? 2 : 1;
+    }
+    if (first)
+      candidates = touched;
+    std::vector<uint32_t> kept;
+    for (uint32_t position : candidates) {
+      if (!hit[position])
+        continue;
+      if (!(hit[position] & 1))
+        state[position] |= kViaUrl;
+      kept.push_back(position);
+    }
+    for (uint32_t position : touched)
+      hit[position] = 0;
+    candidates.swap(kept);
+    touched.clear();
+    first = false;
+  }
+  for (uint32_t position : candidates) {
+    state[position] |= kCandidate;
+    if (!offers(*all_[position], products, country_codes))
+      continue;
+    const std::string &name = names_[position];
+    int score = state[position] & kViaUrl ? kUrlWords : kNameWords;
+    if (name == q)
+      score = kExact;
+    else if (name.compare(0, q.size(), q) == 0)
+      score = kNamePrefix;
+    ranked.push_back(std::make_pair(score, position));
+  }
+
+  // Trigram overlap catches typos and matches inside words. It only ever
+  // adds lower-ranked results, so skip it once the prefix pass has enough.
+  const auto grams = trigrams_of(q);
+  if (ranked.size() < limit && !grams.empty()) {
+    std::vector<uint16_t> shared(all_.size(), 0);
+    for (const auto &gram : grams) {
+      auto postings = trigrams_.find(gram);
+      if (postings == trigrams_.end())
+        continue;
+      for (uint32_t position : postings->second) {
+        if (shared[position]++ == 0)
+          touched.push_back(position);
+      }
+    }
+    for (uint32_t position : touched) {
+      if (state[position] & kCandidate ||
+          shared[position] * 2 <= grams.size() ||
+          !offers(*all_[position], products, country_codes))
+        continue;
+      ranked.push_back(std::make_pair(
+          static_cast<int>((kUrlWords - 1) * shared[position] / grams.size()),
+          position));
+    }
+  }
+
+  // Ties go to shorter names, then to catalog order.
+  auto better = [this](const std::pair<int, uint32_t> &a,
+                       const std::pair<int, uint32_t> &b) {
+    if (a.first != b.first)
+      return a.first > b.first;
+    if (names_[a.second].size() != names_[b.second].size())
+      return names_[a.second].size() < names_[b.second].size();
+    return a.second < b.second;
+  };
+  if (ranked.size() > limit) {
+    std::partial_sort(ranked.begin(), ranked.begin() + limit, ranked.end(),
+                      better);
+    ranked.resize(limit);
+  } else {
+    std::sort(ranked.begin(), ranked.end(), better);
+  }
+
+  std::vector<const Institution *> results;
+  results.reserve(ranked.size());
+  for (const auto &r : ranked)
+    results.push_back(all_[r.second]);
+  return results;
+}
+
+size_t InstitutionIndex::Size() const { return all_.size(); }
+
+std::chrono::system_clock::time_point InstitutionIndex::FetchedAt() const {
+  return fetched_at_;
+}
+
+const GetInstitutionsResponse &InstitutionIndex::Data() const {
+  return data_;
+}
+
+InstitutionCatalog::InstitutionCatalog(Client &client,
+                                       const InstitutionCatalogOptions &options)
+    : client_(client), options_(options) {
+  options_.page_size = std::min(std::max(options_.page_size, 0),
+                                static_cast<int>(kMaxPageSize));
+  if (options_.max_in_flight <= 0)
+    options_.max_in_flight = 1;
+}
+
+InstitutionCatalog::~InstitutionCatalog() { StopRefresh(); }
+
+Status InstitutionCatalog::Load(const CallOptions &call) {
+  using Response = GetInstitutionsResponse;
+  const auto fetched_at = std::chrono::system_clock::now();
+  PageSizer &sizer = client_.PageSizerFor(EndpointId::GetInstitutions);
+  auto size = [this, &sizer](int64_t remaining) {
+    if (options_.page_size > 0)
+      return static_cast<int64_t>(options_.page_size);
+    return sizer.Next(remaining, options_.max_in_flight, kMinPageSize,
+                      kMaxPageSize);
+  };
+  auto fetch = [this, &sizer, call](int64_t offset, int64_t count,
+                                    Callback<Response> page_cb) {
+    client_.GetInstitutionsWithOptionsAsync(
+        static_cast<int>(count), static_cast<int>(offset), options_.filter,
+        TimedPage(sizer, &Response::institutions_size, page_cb), call);
+  };
+  // Everything the read touches lives until it delivers, which is the last
+  // thing it does.
+  auto result =
+      std::make_shared<std::promise<StatusWrapped<std::vector<Response>>>>();
+  auto ready = result->get_future();
+  PagedRead<Response>::Read(
+      0, size(-1), fetch, [](const Response &page) { return page.total(); },
+      size,
+      [result](StatusWrapped<std::vector<Response>> res) {
+        result->set_value(std::move(res));
+      },
+      options_.max_in_flight);
+  auto pages = ready.get();
+  if (!pages.IsOk())
+    return pages.GetStatus();
+
+  std::vector<Response> all = pages.Take();
+  Response merged;
+  merged.set_request_id(all[0].request_id());
+  for (auto &page : all) {
+    for (auto &institution : *page.mutable_institutions())
+      *merged.add_institutions() = std::move(institution);
+  }
+  Swap(std::make_shared<InstitutionIndex>(std::move(merged), fetched_at));
+  return Status::OK();
+}
+
+Status InstitutionCatalog::SaveSnapshot(const std::string &path) const {
+  auto index = Current();
+  if (!index)
+    return Status::MissingInfo("no institutions catalog loaded");
+
+  std::string out(kSnapshotMagic, kSnapshotMagicSize);
+  const int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(
+                              index->FetchedAt().time_since_epoch())
+                              .count();
+  for (int i = 0; i < 8; ++i)
+    out.push_back(static_cast<char>((static_cast<uint64_t>(seconds) >>
+                                     (8 * i)) & 0xff));
+  if (!index->Data().AppendToString(&out))
+    return Status::ParseError("failed to serialize institutions catalog");
+
+  const std::string tmp = path + ".tmp";
+  {
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    file.write(out.data(), out.size());
+    file.close();
+    if (!file) {
+      std::remove(tmp.c_str());
+      return Status::IOError("failed to write " + tmp);
+    }
+  }
+  if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+    std::remove(tmp.c_str());
+    return Status::IOError("failed to replace " + path);
+  }
+  return Status::OK();
+}
+
+Status InstitutionCatalog::LoadSnapshot(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+    return Status::IOError("failed to open " + path);
+  std::ostringstream contents;
+  contents << file.rdbuf();
+  if (file.bad())
+    return Status::IOError("failed to read " + path);
+  const std::string in = contents.str();
+
+  if (in.size() < kSnapshotHeaderSize ||
+      in.compare(0, kSnapshotMagicSize, kSnapshotMagic) != 0)
+    return Status::ParseError(path + " is not an institutions snapshot");
+  uint64_t seconds = 0;
+  for (int i = 0; i < 8; ++i)
+    seconds |= static_cast<uint64_t>(
+                   static_cast<unsigned char>(in[kSnapshotMagicSize + i]))
+               << (8 * i);
+  GetInstitutionsResponse data;
+  if (!data.ParseFromArray(in.data() + kSnapshotHeaderSize,
+                           in.size() - kSnapshotHeaderSize))
+    return Status::ParseError("failed to parse " + path);
+
+  const auto fetched_at = std::chrono::system_clock::time_point(
+      std::chrono::seconds(static_cast<int64_t>(seconds)));
+  Swap(std::make_shared<InstitutionIndex>(std::move(data), fetched_at));
+  return Status::OK();
+}
+
+StatusWrapped<SearchInstitutionsResponse>
+InstitutionCatalog::Search(const std::string &query,
+                           const std::vector<std::string> &products,
+                           const SearchInstitutionsOptions &options,
+                           const CallOptions &call) const {
+  SearchInstitutionsResponse local;
+  if (SearchLocally(query, products, options, local))
+    return StatusWrapped<SearchInstitutionsResponse>(std::move(local));
+  return client_.SearchInstitutionsWithOptions(query, products, options, call);
+}
+
+void InstitutionCatalog::SearchAsync(const std::string &query,
+                                     const std::vector<std::string> &products,
+                                     const SearchInstitutionsOptions &options,
+                                     Callback<SearchInstitutionsResponse> cb,
+                                     const CallOptions &call) const {
+  SearchInstitutionsResponse local;
+  if (SearchLocally(query, products, options, local))
+    return cb(StatusWrapped<SearchInstitutionsResponse>(std::move(local)));
+  client_.SearchInstitutionsWithOptionsAsync(query, products, options, cb,
+                                             call);
+}
+
+bool InstitutionCatalog::SearchLocally(
+    const std::string &query, const std::vector<std::string> &products,
+    const SearchInstitutionsOptions &options,
+    SearchInstitutionsResponse &out) const {
+  // An empty query is left to the client, which rejects it.
+  auto index = Current();
+  if (!index || query.empty() || options.routing_numbers_size() > 0)
+    return false;
+  if (options.include_optional_metadata() &&
+      !options_.filter.include_optional_metadata())
+    return false;
+  if (std::chrono::system_clock::now() - index->FetchedAt() >
+      options_.max_search_age)
+    return false;
+
+  std::vector<std::string> country_codes(options.country_codes().begin(),
+                                         options.country_codes().end());
+  for (const Institution *institution :
+       index->Search(query, products, country_codes, options_.search_limit))
+    *out.add_institutions() = *institution;
+  return true;
+}
+
+std::shared_ptr<const InstitutionIndex> InstitutionCatalog::Current() const {
+  std::lock_guard<std::mutex> lock(index_mu_);
+  return index_;
+}
+
+void InstitutionCatalog::StartRefresh(std::chrono::seconds interval) {
+  StopRefresh();
+  std::lock_guard<std::mutex> lock(refresh_mu_);
+  refresh_stopping_ = false;
+  refresh_cancel_ = CancellationToken();
+  refresh_thread_ =
+      std::thread(&InstitutionCatalog::RefreshLoop, this, interval);
+}
+
+void InstitutionCatalog::StopRefresh() {
+  std::thread thread;
+  {
+    std::lock_guard<std::mutex> lock(refresh_mu_);
+    refresh_stopping_ = true;
+    // A reload in progress gives up rather than holding this up for as long
+    // as the whole catalog takes.
+    refresh_cancel_.Cancel();
+    thread = std::move(refresh_thread_);
+  }
+  refresh_cv_.notify_all();
+  if (thread.joinable())
+    thread.join();
+}
+
+void InstitutionCatalog::Swap(std::shared_ptr<const InstitutionIndex> index) {
+  std::lock_guard<std::mutex> lock(index_mu_);
+  index_ = std::move(index);
+}
+
+void InstitutionCatalog::RefreshLoop(std::chrono::seconds interval) {
+  std::unique_lock<std::mutex> lock(refresh_mu_);
+  CallOptions call;
+  call.cancel = refresh_cancel_;
+  while (!refresh_cv_.wait_for(lock, interval,
+                               [this]() { return refresh_stopping_; })) {
+    lock.unlock();
+    Load(call);
+    lock.lock();
+  }
+}
+
+} // namespace plaid
\ No newline at end of file
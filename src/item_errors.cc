@@ -0,0 +1,76 @@
+#include "plaid/item_errors.h"
+
+#include <functional>
+
+namespace plaid {
+
+ItemErrorCache::ItemErrorCache() : size_(0) {}
+
+ItemErrorCache::~ItemErrorCache() {}
+
+void ItemErrorCache::SetOptions(const ItemErrorCacheOptions &options) {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  options_ = options;
+}
+
+ItemErrorCacheOptions ItemErrorCache::Options() const {
+  std::lock_guard<std::mutex> lock(options_mu_);
+  return options_;
+}
+
+ItemErrorCache::Shard &
+ItemErrorCache::ShardFor(const std::string &access_token) const {
+  return shards_[std::hash<std::string>()(access_token) % kShards];
+}
+
+Status ItemErrorCache::Check(const std::string &access_token) const {
+  if (size_.load() == 0)
+    return Status::OK();
+  Shard &shard = ShardFor(access_token);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto it = shard.map.find(access_token);
+  if (it == shard.map.end())
+    return Status::OK();
+  if (Clock::now() >= it->second.expires) {
+    shard.map.erase(it);
+    --size_;
+    return Status::OK();
+  }
+  const Status &error = it->second.error;
+  return Status::ApiError(error.ErrorType(), error.ErrorCode(),
+                          error.Description() + " (cached; call not sent)");
+}
+
+void ItemErrorCache::Record(const std::string &access_token,
+                            const Status &status) {
+  if (!status.IsApiError())
+    return;
+  Clock::duration ttl;
+  {
+    std::lock_guard<std::mutex> lock(options_mu_);
+    if (options_.ttl.count() <= 0 || !options_.codes.count(status.ErrorCode()))
+      return;
+    ttl = options_.ttl;
+  }
+  Shard &shard = ShardFor(access_token);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  auto inserted = shard.map.insert({access_token, Entry{status, {}}});
+  if (inserted.second)
+    ++size_;
+  else
+    inserted.first->second.error = status;
+  inserted.first->second.expires = Clock::now() + ttl;
+}
+
+void ItemErrorCache::Clear(const std::string &access_token) {
+  if (size_.load() == 0)
+    return;
+  Shard &shard = ShardFor(access_token);
+  std::lock_guard<std::mutex> lock(shard.mu);
+  if (shard.map.erase(access_token))
+    --size_;
+}
+
+size_t ItemErrorCache::Size() const { return size_.load(); }
+
+} // namespace plaid
\ No newline at end of file
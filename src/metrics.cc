@@ -0,0 +1,36 @@
+#include "plaid/metrics.h"
+
+#include <atomic>
+#include <cstdint>
+
+namespace plaid {
+
+// Threads are handed shard slots round-robin the first time they touch any
+// counter, which spreads writers more evenly than hashing thread ids.
+static std::atomic<int> next_shard(0);
+static thread_local int tls_shard = -1;
+
+static int shard_for_thread(int shards) {
+  if (tls_shard < 0)
+    tls_shard = next_shard.fetch_add(1, std::memory_order_relaxed);
+  return tls_shard % shards;
+}
+
+Counter::Counter() {
+  for (auto &shard : shards_)
+    shard.value.store(0, std::memory_order_relaxed);
+}
+
+void Counter::Add(uint64_t n) {
+  shards_[shard_for_thread(kShards)].value.fetch_add(
+      n, std::memory_order_relaxed);
+}
+
+uint64_t Counter::Value() const {
+  uint64_t total = 0;
+  for (const auto &shard : shards_)
+    total += shard.value.load(std::memory_order_relaxed);
+  return total;
+}
+
+} // namespace plaid
\ No newline at end of file
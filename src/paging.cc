@@ -0,0 +1,74 @@
+#include "plaid/paging.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace plaid {
+
+// Each new sample counts this much less than the one after it.
+static const double kDecay = 0.9;
+// The model assumed before any pages have been timed: 150ms per request
+// plus 0.3ms per element, which favours pages of 500.
+static const double kPriorFixed = 150000;
+static const double kPriorPerElement = 300;
+
+PageSizer::PageSizer() {}
+
+void PageSizer::Record(int64_t elements, Clock::duration latency) {
+  const double n = static_cast<double>(elements);
+  const double t = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::microseconds>(latency).count());
+  std::lock_guard<std::mutex> lock(mu_);
+  weight_ = weight_ * kDecay + 1;
+  sum_n_ = sum_n_ * kDecay + n;
+  sum_t_ = sum_t_ * kDecay + t;
+  sum_nn_ = sum_nn_ * kDecay + n * n;
+  sum_nt_ = sum_nt_ * kDecay + n * t;
+}
+
+void PageSizer::Fit(double &fixed, double &per_element) const {
+  fixed = kPriorFixed;
+  per_element = kPriorPerElement;
+  std::lock_guard<std::mutex> lock(mu_);
+  if (weight_ == 0)
+    return;
+  const double mean_n = sum_n_ / weight_;
+  const double mean_t = sum_t_ / weight_;
+  const double var = sum_nn_ / weight_ - mean_n * mean_n;
+  const double cov = sum_nt_ / weight_ - mean_n * mean_t;
+  // Page sizes must vary by a tenth or so before the slope means anything.
+  if (var > 0.01 * mean_n * mean_n && cov > 0) {
+    const double slope = cov / var;
+    const double intercept = mean_t - slope * mean_n;
+    if (intercept > 0) {
+      fixed = intercept;
+      per_element = slope;
+      return;
+    }
+  }
+  // The pages have all been about the same size (or the fit makes no
+  // sense), so only their latency as a whole is known: split it the way the
+  // prior would.
+  const double prior = kPriorFixed + kPriorPerElement * mean_n;
+  fixed = mean_t * kPriorFixed / prior;
+  per_element = mean_t * kPriorPerElement / prior;
+}
+
+int64_t PageSizer::Next(int64_t remaining, int parallel, int64_t min_count,
+                        int64_t max_count) const {
+  if (remaining >= 0 && remaining <= max_count)
+    return std::max(min_count, remaining);
+  double fixed, per_element;
+  Fit(fixed, per_element);
+  // With nothing known about the read, pages where the fixed cost is no
+  // more than half the latency.
+  double best = fixed / per_element;
+  if (remaining >= 0)
+    best = std::sqrt(static_cast<double>(remaining) * fixed /
+                     (std::max(parallel, 1) * per_element));
+  if (!(best < static_cast<double>(max_count)))
+    return max_count;
+  return std::max(min_count, static_cast<int64_t>(std::ceil(best)));
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "plaid/payments.h"
+#include "plaid/thread_pool.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace plaid {
+
+// ListPayments's smallest (and default) page, and its largest.
+static const int64_t kMinPaymentsPage = 10;
+static const int64_t kMaxPaymentsPage = 200;
+
+PaymentStream::Iterator::Iterator(PaymentStream *stream) : stream_(stream) {
+  ++*this;
+}
+
+PaymentStream::Iterator &PaymentStream::Iterator::operator++() {
+  if (stream_ && !stream_->Next(current_))
+    stream_ = nullptr;
+  return *this;
+}
+
+PaymentStream::PaymentStream(Client &client, const ListPaymentsOptions &options,
+                             StopPredicate stop, const CallOptions &call)
+    : state_(std::make_shared<State>()) {
+  state_->client = &client;
+  state_->options = options;
+  state_->stop = std::move(stop);
+  state_->call = call;
+  state_->call.cancel = state_->cancel;
+  state_->caller = call.cancel;
+  CancellationToken token = state_->cancel;
+  state_->caller_listener =
+      call.cancel.Subscribe([token]() mutable { token.Cancel(); });
+  state_->sizer = options.count() > 0
+                      ? nullptr
+                      : &client.PageSizerFor(EndpointId::ListPayments);
+  state_->low_water = options.count() > 0 ? options.count() : kMinPaymentsPage;
+  std::unique_lock<std::mutex> lock(state_->mu);
+  MaybeFetch(state_, lock);
+}
+
+PaymentStream::~PaymentStream() {
+  state_->caller.Unsubscribe(state_->caller_listener);
+  state_->cancel.Cancel();
+  std::unique_lock<std::mutex> lock(state_->mu);
+  state_->exhausted = true;
+  Wait(lock, [this]() { return !state_->fetching; });
+}
+
+void PaymentStream::Wait(std::unique_lock<std::mutex> &lock,
+                         const std::function<bool()> &done) {
+  // As in Client::Await, a pool worker keeps the pool moving while it waits,
+  // and only blocks, briefly, once there is nothing else to run.
+  ThreadPool &pool = state_->client->Pool();
+  while (!done()) {
+    if (!pool.InWorkerThread()) {
+      state_->cv.wait(lock, done);
+      return;
+    }
+    lock.unlock();
+    const bool ran = pool.RunPendingTask();
+    lock.lock();
+    if (!ran)
+      state_->cv.wait_for(lock, std::chrono::milliseconds(1), done);
+  }
+}
+
+bool PaymentStream::Next(Payment &out) {
+  std::unique_lock<std::mutex> lock(state_->mu);
+  Wait(lock, [this]() { return !state_->ready.empty() || !state_->fetching; });
+  if (state_->ready.empty())
+    return false;
+  out = std::move(state_->ready.front());
+  state_->ready.pop_front();
+  MaybeFetch(state_, lock);
+  return true;
+}
+
+Status PaymentStream::GetStatus() const {
+  std::lock_guard<std::mutex> lock(state_->mu);
+  return state_->status;
+}
+
+void PaymentStream::MaybeFetch(const std::shared_ptr<State> &state,
+                               std::unique_lock<std::mutex> &lock) {
+  if (state->fetching || state->exhausted ||
+      state->ready.size() > state->low_water)
+    return;
+  state->fetching = true;
+  if (state->sizer) {
+    // A stream never knows how much is left, so this is the size whose
+    // fixed cost is about half its latency.
+    const int64_t count =
+        state->sizer->Next(-1, 1, kMinPaymentsPage, kMaxPaymentsPage);
+    state->options.set_count(count);
+    state->low_water = count;
+  }
+  state->fetch_start = PageSizer::Clock::now();
+  auto options = state->options;
+  lock.unlock();
+  state->client->ListPaymentsAsync(
+      options,
+      [state](StatusWrapped<ListPaymentsResponse> res) {
+        OnPage(state, std::move(res));
+      },
+      state->call);
+  lock.lock();
+}
+
+void PaymentStream::OnPage(const std::shared_ptr<State> &state,
+                           StatusWrapped<ListPaymentsResponse> res) {
+  std::unique_lock<std::mutex> lock(state->mu);
+  state->fetching = false;
+  if (!res.IsOk()) {
+    state->status = res.GetStatus();
+    state->exhausted = true;
+    state->cv.notify_all();
+    return;
+  }
+  auto page = res.Take();
+  if (state->sizer)
+    state->sizer->Record(page.payments_size(),
+                         PageSizer::Clock::now() - state->fetch_start);
+  for (auto &payment : *page.mutable_payments()) {
+    if (state->stop && state->stop(payment)) {
+      state->exhausted = true;
+      break;
+    }
+    state->ready.push_back(std::move(payment));
+  }
+  if (page.next_cursor().empty() || page.payments_size() == 0)
+    state->exhausted = true;
+  state->options.set_cursor(page.next_cursor());
+  state->cv.notify_all();
+  // Start on the following page while this one is being read.
+  MaybeFetch(state, lock);
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -0,0 +1,462 @@
+#include "plaid/scheduler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <memory>
+#include <utility>
+
+namespace plaid {
+
+struct SyncScheduler::Sync {
+  SyncResult result;
+  uint64_t generation = 0;
+  Status transactions_status = Status::OK();
+  Status balances_status = Status::OK();
+  // Reads still outstanding; the last one to finish completes the sync.
+  std::atomic<int> remaining;
+};
+
+static std::string utc_date(time_t t) {
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char buf[16];
+  strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+  return buf;
+}
+
+static void mix(size_t &hash, size_t value) {
+  hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+}
+
+// Fingerprints let the next read tell whether anything changed without
+// keeping the whole response around.
+static size_t balances_fingerprint(const GetBalancesResponse &balances) {
+  std::hash<std::string> hash_string;
+  std::hash<double> hash_double;
+  size_t hash = 0;
+  for (const auto &account : balances.accounts()) {
+    mix(hash, hash_string(account.account_id()));
+    mix(hash, hash_double(account.balances().current()));
+    mix(hash, hash_double(account.balances().available()));
+  }
+  return hash;
+}
+
+static size_t fingerprint(const SyncResult &result) {
+  std::hash<std::string> hash_string;
+  std::hash<double> hash_double;
+  size_t hash = balances_fingerprint(result.balances);
+  mix(hash, static_cast<size_t>(result.transactions.total_transactions()));
+  for (const auto &tx : result.transactions.transactions()) {
+    mix(hash, hash_string(tx.transaction_id()));
+    mix(hash, hash_double(tx.amount()));
+    mix(hash, hash_string(tx.date()));
+    mix(hash, tx.pending());
+  }
+  return hash;
+}
+
+static bool changes_transactions(const Webhook &webhook) {
+  if (webhook.webhook_type() != "TRANSACTIONS")
+    return false;
+  const std::string &code = webhook.webhook_code();
+  return code == "INITIAL_UPDATE" || code == "HISTORICAL_UPDATE" ||
+         code == "DEFAULT_UPDATE" || code == "TRANSACTIONS_REMOVED";
+}
+
+SyncScheduler::SyncScheduler(Client &client, Handler handler,
+                             const SyncSchedulerOptions &options)
+    : client_(client), handler_(std::move(handler)), options_(options) {}
+
+SyncScheduler::~SyncScheduler() { Stop(); }
+
+void SyncScheduler::Add(const std::string &item_id,
+                        const std::string &access_token) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto inserted = items_.emplace(item_id, Item());
+  Item &item = inserted.first->second;
+  item.access_token = access_token;
+  if (!inserted.second)
+    return;
+  item.generation = ++generations_;
+  item.interval = options_.min_interval;
+  Schedule(item_id, item, Clock::now(), false);
+  cv_.notify_all();
+}
+
+void SyncScheduler::Remove(const std::string &item_id) {
+  std::lock_guard<std::mutex> lock(mu_);
+  // Its queue entries are skipped once they reach the front.
+  items_.erase(item_id);
+}
+
+bool SyncScheduler::OnWebhook(const Webhook &webhook) {
+  if (!changes_transactions(webhook))
+    return false;
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = items_.find(webhook.item_id());
+  if (it == items_.end())
+    return false;
+  Item &item = it->second;
+  if (item.in_flight) {
+    item.webhook_pending = true;
+    return true;
+  }
+  Schedule(it->first, item, Clock::time_point::min(), true);
+  cv_.notify_all();
+  return true;
+}
+
+void SyncScheduler::Start() {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (thread_.joinable())
+    return;
+  stopping_ = false;
+  thread_ = std::thread(&SyncScheduler::Run, this);
+}
+
+void SyncScheduler::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+    cv_.notify_all();
+  }
+  if (thread_.joinable())
+    thread_.join();
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this]() { return in_flight_ == 0; });
+}
+
+std::chrono::seconds SyncScheduler::Interval(const std::string &item_id) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = items_.find(item_id);
+  return it == items_.end() ? std::chrono::seconds(0) : it->second.interval;
+}
+
+size_t SyncScheduler::Size() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return items_.size();
+}
+
+SyncMetrics SyncScheduler::Metrics() const {
+  SyncMetrics metrics;
+  metrics.syncs = syncs_.Value();
+  metrics.webhook_syncs = webhook_syncs_.Value();
+  metrics.unchanged = unchanged_.Value();
+  metrics.failed = failed_.Value();
+  return metrics;
+}
+
+void SyncScheduler::Schedule(const std::string &item_id, Item &item,
+                             Clock::time_point due, bool from_webhook) {
+  Scheduled entry;
+  entry.due = due;
+  entry.seq = seq_++;
+  entry.version = ++item.version;
+  entry.from_webhook = from_webhook;
+  entry.item_id = item_id;
+  queue_.push(std::move(entry));
+}
+
+void SyncScheduler::Run() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!stopping_) {
+    // Drop entries for Items that were removed, queued again since, or are
+    // being synced.
+    while (!queue_.empty()) {
+      const Scheduled &top = queue_.top();
+      auto it = items_.find(top.item_id);
+      if (it != items_.end() && it->second.version == top.version &&
+          !it->second.in_flight)
+        break;
+      queue_.pop();
+    }
+    if (queue_.empty() || in_flight_ >= options_.max_in_flight) {
+      cv_.wait(lock);
+      continue;
+    }
+    const Clock::time_point due = queue_.top().due;
+    if (due > Clock::now()) {
+      cv_.wait_until(lock, due);
+      continue;
+    }
+    Scheduled next = queue_.top();
+    queue_.pop();
+    Item &item = items_[next.item_id];
+    item.in_flight = true;
+    ++in_flight_;
+    const std::string access_token = item.access_token;
+    const uint64_t generation = item.generation;
+    lock.unlock();
+    StartSync(next.item_id, access_token, generation, next.from_webhook);
+    lock.lock();
+  }
+}
+
+void SyncScheduler::StartSync(const std::string &item_id,
+                              const std::string &access_token,
+                              uint64_t generation, bool from_webhook) {
+  auto sync = std::make_shared<Sync>();
+  sync->generation = generation;
+  sync->result.item_id = item_id;
+  sync->result.access_token = access_token;
+  sync->result.from_webhook = from_webhook;
+  sync->remaining = options_.balances ? 2 : 1;
+
+  const time_t now = time(nullptr);
+  GetTransactionsOptions transactions;
+  transactions.set_start_date(utc_date(now - options_.days * 24 * 60 * 60));
+  transactions.set_end_date(utc_date(now));
+  transactions.set_count(options_.count);
+  client_.GetTransactionsWithOptionsAsync(
+      access_token, transactions,
+      [this, sync](StatusWrapped<GetTransactionsResponse> res) {
+        if (res.IsOk())
+          sync->result.transactions = res.Take();
+        else
+          sync->transactions_status = res.GetStatus();
+        if (--sync->remaining == 0)
+          Finish(*sync);
+      },
+      options_.call);
+  if (!options_.balances)
+    return;
+  client_.GetBalancesAsync(
+      access_token,
+      [this, sync](StatusWrapped<GetBalancesResponse> res) {
+        if (res.IsOk())
+          sync->result.balances = res.Take();
+        else
+          sync->balances_status = res.GetStatus();
+        if (--sync->remaining == 0)
+          Finish(*sync);
+      },
+      options_.call);
+}
+
+void SyncScheduler::Finish(Sync &sync) {
+  SyncResult &result = sync.result;
+  result.status = sync.transactions_status.IsOk() ? sync.balances_status
+                                                  : sync.transactions_status;
+  const bool ok = result.status.IsOk();
+  const size_t print = ok ? fingerprint(result) : 0;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = items_.find(result.item_id);
+    // Unless the Item was removed (and perhaps added again) meanwhile.
+    if (it != items_.end() && it->second.generation == sync.generation) {
+      Item &item = it->second;
+      item.in_flight = false;
+      if (ok) {
+        result.changed = !item.synced || print != item.fingerprint;
+        item.fingerprint = print;
+        item.synced = true;
+      }
+      // A change, or a webhook saying one is coming, starts the Item over at
+      // the shortest interval; anything else (failures included) backs off.
+      if (ok && (result.changed || result.from_webhook)) {
+        item.interval = options_.min_interval;
+      } else {
+        const auto longer = std::chrono::seconds(static_cast<int64_t>(
+            item.interval.count() * options_.backoff));
+        item.interval = std::min(longer, options_.max_interval);
+      }
+      if (item.webhook_pending) {
+        item.webhook_pending = false;
+        Schedule(it->first, item, Clock::time_point::min(), true);
+      } else {
+        Schedule(it->first, item, Clock::now() + item.interval, false);
+      }
+    }
+  }
+
+  syncs_.Add();
+  if (result.from_webhook)
+    webhook_syncs_.Add();
+  if (!ok)
+    failed_.Add();
+  else if (!result.changed)
+    unchanged_.Add();
+  handler_(result);
+
+  // Only now, so that Stop can't return while the handler is running.
+  std::lock_guard<std::mutex> lock(mu_);
+  --in_flight_;
+  cv_.notify_all();
+}
+
+BalancePoller::BalancePoller(Client &client, Handler handler,
+                             const BalancePollerOptions &options)
+    : client_(client), handler_(std::move(handler)), options_(options) {}
+
+BalancePoller::~BalancePoller() { Stop(); }
+
+void BalancePoller::Add(const std::string &access_token) {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto inserted = tokens_.emplace(access_token, Token());
+  if (!inserted.second)
+    return;
+  inserted.first->second.generation = ++generations_;
+  inserted.first->second.interval = std::chrono::seconds(0);
+  Schedule(access_token, inserted.first->second, Clock::now());
+  cv_.notify_all();
+}
+
+void BalancePoller::Remove(const std::string &access_token) {
+  std::lock_guard<std::mutex> lock(mu_);
+  tokens_.erase(access_token);
+}
+
+void BalancePoller::Start() {
+  std::lock_guard<std::mutex> lock(mu_);
+  if (thread_.joinable())
+    return;
+  stopping_ = false;
+  thread_ = std::thread(&BalancePoller::Run, this);
+}
+
+void BalancePoller::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    stopping_ = true;
+    cv_.notify_all();
+  }
+  if (thread_.joinable())
+    thread_.join();
+  std::unique_lock<std::mutex> lock(mu_);
+  cv_.wait(lock, [this]() { return in_flight_ == 0; });
+}
+
+std::chrono::seconds
+BalancePoller::Interval(const std::string &access_token) const {
+  std::lock_guard<std::mutex> lock(mu_);
+  auto it = tokens_.find(access_token);
+  return it == tokens_.end() ? std::chrono::seconds(0) : it->second.interval;
+}
+
+size_t BalancePoller::Size() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return tokens_.size();
+}
+
+BalancePollMetrics BalancePoller::Metrics() const {
+  BalancePollMetrics metrics;
+  metrics.polls = polls_.Value();
+  metrics.changes = changes_.Value();
+  metrics.failed = failed_.Value();
+  return metrics;
+}
+
+void BalancePoller::Schedule(const std::string &access_token, Token &token,
+                             Clock::time_point due) {
+  Scheduled entry;
+  entry.due = due;
+  entry.version = ++token.version;
+  entry.access_token = access_token;
+  queue_.push(std::move(entry));
+}
+
+void BalancePoller::Run() {
+  std::unique_lock<std::mutex> lock(mu_);
+  while (!stopping_) {
+    while (!queue_.empty()) {
+      const Scheduled &top = queue_.top();
+      auto it = tokens_.find(top.access_token);
+      if (it != tokens_.end() && it->second.version == top.version &&
+          !it->second.in_flight)
+        break;
+      queue_.pop();
+    }
+    if (queue_.empty() || in_flight_ >= options_.max_in_flight) {
+      cv_.wait(lock);
+      continue;
+    }
+    const Clock::time_point due = queue_.top().due;
+    if (due > Clock::now()) {
+      cv_.wait_until(lock, due);
+      continue;
+    }
+    const std::string access_token = queue_.top().access_token;
+    queue_.pop();
+    Token &token = tokens_[access_token];
+    token.in_flight = true;
+    const uint64_t generation = token.generation;
+    ++in_flight_;
+    lock.unlock();
+    client_.GetBalancesAsync(
+        access_token,
+        [this, access_token,
+         generation](StatusWrapped<GetBalancesResponse> res) {
+          Finish(access_token, generation, std::move(res));
+        },
+        options_.call);
+    lock.lock();
+  }
+}
+
+void BalancePoller::Finish(const std::string &access_token,
+                           uint64_t generation,
+                           StatusWrapped<GetBalancesResponse> res) {
+  BalanceUpdate update;
+  update.access_token = access_token;
+  update.status = res.GetStatus();
+  if (res.IsOk())
+    update.balances = res.Take();
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    // Unless the token was removed (and perhaps added again) meanwhile.
+    auto it = tokens_.find(access_token);
+    if (it != tokens_.end() && it->second.generation == generation) {
+      Token &token = it->second;
+      token.in_flight = false;
+      const auto now = Clock::now();
+      if (update.status.IsOk()) {
+        const size_t print = balances_fingerprint(update.balances);
+        if (!token.polled) {
+          token.polled = true;
+          token.last_change = now;
+        } else if (print != token.fingerprint) {
+          update.changed = true;
+          const double gap =
+              std::chrono::duration<double>(now - token.last_change).count();
+          const double alpha = options_.alpha;
+          token.mean_gap = token.mean_gap == 0
+                               ? gap
+                               : alpha * gap + (1 - alpha) * token.mean_gap;
+          token.last_change = now;
+        }
+        token.fingerprint = print;
+      }
+      // However short the average, a token that has been quiet this long
+      // changes at least that rarely.
+      double expected = token.mean_gap > 0
+                            ? token.mean_gap
+                            : static_cast<double>(
+                                  options_.initial_interval.count());
+      if (token.polled)
+        expected = std::max(expected, std::chrono::duration<double>(
+                                          now - token.last_change)
+                                          .count());
+      const double seconds = std::min(
+          std::max(expected * options_.fraction,
+                   static_cast<double>(options_.min_interval.count())),
+          static_cast<double>(options_.max_interval.count()));
+      token.interval = std::chrono::seconds(static_cast<int64_t>(seconds));
+      Schedule(access_token, token, now + token.interval);
+    }
+  }
+
+  polls_.Add();
+  if (!update.status.IsOk())
+    failed_.Add();
+  else if (update.changed)
+    changes_.Add();
+  handler_(update);
+
+  std::lock_guard<std::mutex> lock(mu_);
+  --in_flight_;
+  cv_.notify_all();
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -24,11 +24,48 @@ Status Status::RequestError(const std::string &description) {
 Status Status::MissingInfo(const std::string &description) {
   return Status(Code::kMissingInfo, description);
 }
+Status Status::Cancelled(const std::string &description) {
+  return Status(Code::kCancelled, description);
+}
+Status Status::Timeout(const std::string &description) {
+  return Status(Code::kTimeout, description);
+}
+Status Status::LocalTimeout(const std::string &description) {
+  Status status(Code::kTimeout, description);
+  status.local_ = true;
+  return status;
+}
+Status Status::IOError(const std::string &description) {
+  return Status(Code::kIOError, description);
+}
+Status Status::VerificationError(const std::string &description) {
+  return Status(Code::kVerificationError, description);
+}
+Status Status::ApiError(const std::string &error_type,
+                        const std::string &error_code,
+                        const std::string &description) {
+  Status status(Code::kApiError, description);
+  status.error_type_ = error_type;
+  status.error_code_ = error_code;
+  return status;
+}
+Status Status::Unavailable(const std::string &description) {
+  return Status(Code::kUnavailable, description);
+}
 
 bool Status::IsOk() const { return code_ == Code::kOk; }
 bool Status::IsParseError() const { return code_ == Code::kParseError; }
 bool Status::IsRequestError() const { return code_ == Code::kRequestError; }
 bool Status::IsMissingInfo() const { return code_ == Code::kMissingInfo; }
+bool Status::IsCancelled() const { return code_ == Code::kCancelled; }
+bool Status::IsTimeout() const { return code_ == Code::kTimeout; }
+bool Status::IsLocalTimeout() const { return IsTimeout() && local_; }
+bool Status::IsIOError() const { return code_ == Code::kIOError; }
+bool Status::IsVerificationError() const {
+  return code_ == Code::kVerificationError;
+}
+bool Status::IsApiError() const { return code_ == Code::kApiError; }
+bool Status::IsUnavailable() const { return code_ == Code::kUnavailable; }
 
 std::string Status::CodeDesc() const {
   switch (code_) {
@@ -40,10 +77,24 @@ std::string Status::CodeDesc() const {
     return "Request Error";
   case Code::kMissingInfo:
     return "Missing Info";
+  case Code::kCancelled:
+    return "Cancelled";
+  case Code::kTimeout:
+    return "Timeout";
+  case Code::kIOError:
+    return "IO Error";
+  case Code::kVerificationError:
+    return "Verification Error";
+  case Code::kApiError:
+    return "API Error";
+  case Code::kUnavailable:
+    return "Unavailable";
   default:
     throw std::runtime_error("invalid code provided");
   }
 }
 std::string Status::Description() const { return description_; }
+const std::string &Status::ErrorType() const { return error_type_; }
+const std::string &Status::ErrorCode() const { return error_code_; }
 
 } // namespace plaid
\ No newline at end of file
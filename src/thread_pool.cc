@@ -0,0 +1,110 @@
+#include "plaid/thread_pool.h"
+
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace plaid {
+
+// Identifies the pool (and queue) owned by the current worker thread, so that
+// tasks submitted from inside the pool stay on the submitting worker.
+static thread_local const ThreadPool *tls_pool = nullptr;
+static thread_local size_t tls_index = 0;
+
+ThreadPool::ThreadPool(size_t threads)
+    : next_queue_(0), pending_(0), sleeping_(0) {
+  if (threads == 0)
+    threads = std::thread::hardware_concurrency();
+  if (threads == 0)
+    threads = 1;
+  for (size_t i = 0; i < threads; ++i)
+    queues_.push_back(std::unique_ptr<Queue>(new Queue()));
+  for (size_t i = 0; i < threads; ++i)
+    threads_.push_back(std::thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(idle_mu_);
+    stopping_ = true;
+  }
+  idle_cv_.notify_all();
+  for (auto &t : threads_)
+    t.join();
+}
+
+void ThreadPool::Submit(std::function<void()> task) {
+  size_t index = InWorkerThread() ? tls_index
+                                  : next_queue_.fetch_add(1) % queues_.size();
+  pending_.fetch_add(1);
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mu);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  // A worker bumps sleeping_ before its final check of pending_, so either it
+  // sees this task or we see it asleep. Taking the idle lock orders the wakeup
+  // against a worker that is between that check and the wait.
+  if (sleeping_.load() > 0) {
+    { std::lock_guard<std::mutex> lock(idle_mu_); }
+    idle_cv_.notify_one();
+  }
+}
+
+bool ThreadPool::RunPendingTask() {
+  if (!InWorkerThread())
+    return false;
+  std::function<void()> task;
+  if (!PopTask(tls_index, task))
+    return false;
+  task();
+  return true;
+}
+
+bool ThreadPool::InWorkerThread() const { return tls_pool == this; }
+
+size_t ThreadPool::Size() const { return threads_.size(); }
+
+bool ThreadPool::PopTask(size_t self, std::function<void()> &task) {
+  {
+    auto &own = *queues_[self];
+    std::lock_guard<std::mutex> lock(own.mu);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+      pending_.fetch_sub(1);
+      return true;
+    }
+  }
+  for (size_t i = 1; i < queues_.size(); ++i) {
+    auto &victim = *queues_[(self + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mu);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      pending_.fetch_sub(1);
+      return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+  tls_pool = this;
+  tls_index = index;
+  std::function<void()> task;
+  while (true) {
+    if (PopTask(index, task)) {
+      task();
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(idle_mu_);
+    sleeping_.fetch_add(1);
+    idle_cv_.wait(lock, [this]() { return stopping_ || pending_.load() > 0; });
+    sleeping_.fetch_sub(1);
+    if (stopping_ && pending_.load() == 0)
+      return;
+  }
+}
+
+} // namespace plaid
\ No newline at end of file
@@ -1,29 +1,162 @@
 #include "plaid/transport.h"
+#include "plaid/plaid.pb.h"
 #include "plaid/status.h"
+#include "plaid/thread_pool.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include <curl/curl.h>
 #include <google/protobuf/util/json_util.h>
+#include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <utility>
 
 namespace plaid {
 
-Response::Response(long status_code, const std::string &body) {
+// Keeps the buffers of finished requests and responses, capacity intact, so
+// later ones don't grow a fresh string from empty. Only ordinary pages are
+// worth keeping: a buffer over kMaxRetained is freed as usual, and the pool
+// holds at most kMaxBuffers buffers and kMaxPooled bytes in all, so a burst
+// of large responses doesn't pin memory for the rest of the process.
+class BufferPool {
+public:
+  std::string Acquire() {
+    std::lock_guard<std::mutex> lock(mu_);
+    if (free_.empty())
+      return std::string();
+    std::string buf = std::move(free_.back());
+    free_.pop_back();
+    pooled_ -= buf.capacity();
+    return buf;
+  }
+
+  void Release(std::string &buf) {
+    const size_t capacity = buf.capacity();
+    if (capacity == 0 || capacity > kMaxRetained)
+      return;
+    buf.clear();
+    std::lock_guard<std::mutex> lock(mu_);
+    if (free_.size() >= kMaxBuffers || pooled_ + capacity > kMaxPooled)
+      return;
+    pooled_ += capacity;
+    free_.push_back(std::move(buf));
+  }
+
+private:
+  static const size_t kMaxBuffers = 64;
+  static const size_t kMaxRetained = 1 << 20;
+  static const size_t kMaxPooled = 8 << 20;
+
+  std::mutex mu_;
+  std::vector<std::string> free_;
+  size_t pooled_ = 0;
+};
+
+// Request and response buffers differ in size by orders of magnitude, so
+// they are pooled separately. The pools are never destroyed, since responses
+// may outlive static destruction.
+static BufferPool &request_buffers() {
+  static BufferPool *pool = new BufferPool();
+  return *pool;
+}
+
+static BufferPool &response_buffers() {
+  static BufferPool *pool = new BufferPool();
+  return *pool;
+}
+
+Response::Response(long status_code, std::string body, size_t wire_size) {
   this->status_code_ = status_code;
-  this->body_ = body;
+  this->body_ = std::move(body);
+  this->wire_size_ = wire_size;
 }
 
+Response::~Response() { response_buffers().Release(body_); }
+
 long Response::StatusCode() const { return status_code_; }
 std::string Response::Body() const { return body_; }
+size_t Response::BodySize() const { return body_.size(); }
+size_t Response::WireSize() const { return wire_size_; }
+
+Status Response::ErrorStatus() const {
+  if (status_code_ < 400)
+    return Status::OK();
+  const std::string http = "HTTP " + std::to_string(status_code_);
+  // Error bodies carry more fields than Error lists, and add new ones over
+  // time.
+  google::protobuf::util::JsonParseOptions options;
+  options.ignore_unknown_fields = true;
+  Error error;
+  if (!google::protobuf::util::JsonStringToMessage(body_, &error, options)
+           .ok() ||
+      error.error_type().empty())
+    return Status::RequestError(http);
+  const std::string &message =
+      error.error_message().empty() ? http : error.error_message();
+  return Status::ApiError(error.error_type(), error.error_code(), message);
+}
 
 // Credit: https://stackoverflow.com/questions/9786150/ (Joachim Isaksson)
-static size_t resp_cb(void *data, size_t len, size_t nmemb, void *userp) {
+size_t Request::WriteCallback(char *data, size_t len, size_t nmemb,
+                              void *userp) {
   size_t real_size = len * nmemb;
-  ((std::string *)userp)->append((char *)data, real_size);
+  Request *req = static_cast<Request *>(userp);
+  if (req->response_buf_.empty()) {
+    // Size the buffer once from Content-Length when the server sends one.
+    // For encoded bodies that is the compressed size, which still saves the
+    // early growth steps.
+    curl_off_t expected = -1;
+    curl_easy_getinfo(req->curl_, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+                      &expected);
+    if (expected > 0)
+      req->response_buf_.reserve(static_cast<size_t>(expected));
+  }
+  req->response_buf_.append(data, real_size);
   return real_size;
 }
 
-Request::Request(const std::string &url) : status_(Status::OK()) {
+// Streams the body as prefix_ followed by request_buf_.
+size_t Request::ReadCallback(char *data, size_t len, size_t nmemb,
+                             void *userp) {
+  Request *req = static_cast<Request *>(userp);
+  const std::string *parts[] = {req->prefix_, &req->request_buf_};
+  const size_t room = len * nmemb;
+  size_t copied = 0;
+  size_t start = 0;
+  for (const std::string *part : parts) {
+    const size_t end = start + part->size();
+    if (copied < room && req->read_pos_ < end) {
+      const size_t offset = req->read_pos_ - start;
+      const size_t n = std::min(room - copied, part->size() - offset);
+      memcpy(data + copied, part->data() + offset, n);
+      copied += n;
+      req->read_pos_ += n;
+    }
+    start = end;
+  }
+  return copied;
+}
+
+// Lets curl rewind the body, which it does to resend it on a redirect.
+int Request::SeekCallback(void *userp, curl_off_t offset, int origin) {
+  Request *req = static_cast<Request *>(userp);
+  if (origin != SEEK_SET || offset < 0 ||
+      static_cast<size_t>(offset) >
+          req->prefix_->size() + req->request_buf_.size())
+    return CURL_SEEKFUNC_CANTSEEK;
+  req->read_pos_ = static_cast<size_t>(offset);
+  return CURL_SEEKFUNC_OK;
+}
+
+Request::Request(const std::string &url)
+    : status_(Status::OK()), request_buf_(request_buffers().Acquire()),
+      response_buf_(response_buffers().Acquire()) {
   curl_ = curl_easy_init();
   if (!curl_)
     throw std::runtime_error("curl_easy_init returned nullptr");
@@ -31,9 +164,12 @@ Request::Request(const std::string &url) : status_(Status::OK()) {
   curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
   curl_easy_setopt(curl_, CURLOPT_FOLLOWLOCATION, 1L);
   curl_easy_setopt(curl_, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, resp_cb);
-  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, (void *)&response_buf_);
+  curl_easy_setopt(curl_, CURLOPT_WRITEFUNCTION, WriteCallback);
   curl_easy_setopt(curl_, CURLOPT_USERAGENT, "plaid-cc/1.0");
+  // An empty list offers every encoding this libcurl was built with (gzip,
+  // and brotli where available). Bodies are decoded as they stream in, so
+  // resp_cb still appends plain JSON straight into the parse buffer.
+  curl_easy_setopt(curl_, CURLOPT_ACCEPT_ENCODING, "");
 
   AddHeader("Content-Type", "application/json");
 }
@@ -43,6 +179,8 @@ Request::~Request() {
     curl_easy_cleanup(curl_);
   if (headers_)
     curl_slist_free_all(headers_);
+  request_buffers().Release(request_buf_);
+  response_buffers().Release(response_buf_);
 }
 
 void Request::AddHeader(const std::string &key, const std::string &value) {
@@ -52,28 +190,82 @@ void Request::AddHeader(const std::string &key, const std::string &value) {
 
 void Request::SetBody(const google::protobuf::Message &msg) {
   using google::protobuf::util::MessageToJsonString;
+  request_buf_.clear();
   google::protobuf::util::Status s = MessageToJsonString(msg, &request_buf_);
-  if (s.ok()) {
-    curl_off_t req_size = static_cast<curl_off_t>(request_buf_.size());
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, req_size);
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, request_buf_.c_str());
+  if (s.ok())
     status_ = Status::OK();
+  else
+    status_ = Status::ParseError(std::string(s.message()));
+}
+
+void Request::SetBody(const google::protobuf::Message &msg,
+                      const std::string *prefix) {
+  SetBody(msg);
+  if (!status_.IsOk() || !prefix)
+    return;
+  // Turn "{...}" into the ",...}" (or just "}") that follows the prefix.
+  if (request_buf_.size() <= 2)
+    request_buf_ = "}";
+  else
+    request_buf_[0] = ',';
+  prefix_ = prefix;
+}
+
+void Request::SetCallOptions(const CallOptions &call) {
+  curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS,
+                   static_cast<long>(call.connect_timeout.count()));
+  curl_easy_setopt(curl_, CURLOPT_LOW_SPEED_LIMIT, call.low_speed_limit);
+  curl_easy_setopt(curl_, CURLOPT_LOW_SPEED_TIME,
+                   static_cast<long>(call.low_speed_time.count()));
+  deadline_ = call.deadline;
+  cancel_ = call.cancel;
+  priority_ = call.priority;
+  tenant_ = call.tenant;
+}
+
+CURL *Request::Prepare() {
+  if (deadline_ != CallOptions::Clock::time_point::max()) {
+    // The deadline covers time spent queued, so the budget is whatever is
+    // left of it now. Zero means no timeout to curl, hence the floor of 1.
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline_ - CallOptions::Clock::now());
+    long ms = left.count() < 1 ? 1 : static_cast<long>(left.count());
+    curl_easy_setopt(curl_, CURLOPT_TIMEOUT_MS, ms);
+  }
+  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers_);
+  curl_easy_setopt(curl_, CURLOPT_WRITEDATA, (void *)this);
+  if (prefix_) {
+    read_pos_ = 0;
+    curl_off_t size =
+        static_cast<curl_off_t>(prefix_->size() + request_buf_.size());
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, nullptr);
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE_LARGE, size);
+    curl_easy_setopt(curl_, CURLOPT_READFUNCTION, ReadCallback);
+    curl_easy_setopt(curl_, CURLOPT_READDATA, (void *)this);
+    curl_easy_setopt(curl_, CURLOPT_SEEKFUNCTION, SeekCallback);
+    curl_easy_setopt(curl_, CURLOPT_SEEKDATA, (void *)this);
+  } else if (request_buf_.size() == 0) {
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, 2L);
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, "{}");
   } else {
-    status_ = Status::ParseError(s.error_message());
+    curl_off_t req_size = static_cast<curl_off_t>(request_buf_.size());
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE_LARGE, req_size);
+    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, request_buf_.c_str());
   }
+  return curl_;
 }
 
 StatusWrapped<Response> Request::Execute() {
-  curl_easy_setopt(curl_, CURLOPT_HTTPHEADER, headers_);
-
   if (!status_.IsOk())
     return StatusWrapped<Response>::FromStatus(status_);
-  if (request_buf_.size() == 0) {
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDSIZE, 2L);
-    curl_easy_setopt(curl_, CURLOPT_POSTFIELDS, "{}");
-  }
+  return Finish(curl_easy_perform(Prepare()));
+}
 
-  CURLcode res = curl_easy_perform(curl_);
+StatusWrapped<Response> Request::Finish(CURLcode res) {
+  if (res == CURLE_OPERATION_TIMEDOUT) {
+    const std::string desc = curl_easy_strerror(res);
+    return StatusWrapped<Response>::FromStatus(Status::Timeout(desc));
+  }
   if (res != CURLE_OK) {
     const std::string desc = curl_easy_strerror(res);
     return StatusWrapped<Response>::FromStatus(Status::RequestError(desc));
@@ -81,7 +273,441 @@ StatusWrapped<Response> Request::Execute() {
 
   long code = 0;
   curl_easy_getinfo(curl_, CURLINFO_RESPONSE_CODE, &code);
-  return Response(code, response_buf_);
+  curl_off_t wire_size = 0;
+  curl_easy_getinfo(curl_, CURLINFO_SIZE_DOWNLOAD_T, &wire_size);
+  return Response(code, std::move(response_buf_),
+                  static_cast<size_t>(wire_size));
+}
+
+EventLoop::EventLoop()
+    : incoming_(nullptr), incoming_timers_(nullptr), stopping_(false),
+      cancel_pending_(false) {
+  multi_ = curl_multi_init();
+  if (!multi_)
+    throw std::runtime_error("curl_multi_init returned nullptr");
+  // The multi handle already pools connections; the share adds resolved
+  // names and TLS sessions, so new connections skip the lookup and resume
+  // rather than repeat the full handshake.
+  share_ = curl_share_init();
+  if (!share_)
+    throw std::runtime_error("curl_share_init returned nullptr");
+  curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, LockShare);
+  curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, UnlockShare);
+  curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+  curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+  thread_ = std::thread(&EventLoop::Run, this);
+}
+
+EventLoop::~EventLoop() {
+  stopping_.store(true);
+  curl_multi_wakeup(multi_);
+  thread_.join();
+  curl_multi_cleanup(multi_);
+  curl_share_cleanup(share_);
+}
+
+void EventLoop::LockShare(CURL *, curl_lock_data data, curl_lock_access,
+                          void *userp) {
+  static_cast<EventLoop *>(userp)->share_mu_[data].lock();
+}
+
+void EventLoop::UnlockShare(CURL *, curl_lock_data data, void *userp) {
+  static_cast<EventLoop *>(userp)->share_mu_[data].unlock();
+}
+
+void EventLoop::CancelOwned(const void *owner) {
+  {
+    std::lock_guard<std::mutex> lock(owners_mu_);
+    cancelled_owners_.push_back(owner);
+  }
+  cancel_pending_.store(true);
+  curl_multi_wakeup(multi_);
+}
+
+void EventLoop::Submit(std::unique_ptr<Request> req, Completion done,
+                       const void *owner) {
+  if (!req->status_.IsOk())
+    return done(StatusWrapped<Response>::FromStatus(req->status_));
+  if (stopping_.load())
+    return done(StatusWrapped<Response>::FromStatus(
+        Status::RequestError("event loop is shutting down")));
+  auto transfer = new Transfer();
+  transfer->req = std::move(req);
+  transfer->done = std::move(done);
+  transfer->owner = owner;
+  // Subscribed before the push, so the listener is always registered by the
+  // time the I/O thread could finish the transfer and unsubscribe it.
+  transfer->cancel_listener = transfer->req->cancel_.Subscribe([this]() {
+    cancel_pending_.store(true);
+    curl_multi_wakeup(multi_);
+  });
+  transfer->next = incoming_.load(std::memory_order_relaxed);
+  while (!incoming_.compare_exchange_weak(transfer->next, transfer))
+    ;
+  // The loop may have stopped, and drained the stack for the last time,
+  // since the check above; nothing pushed after that would ever be looked
+  // at. The push and the drain are both sequentially consistent, so if the
+  // loop missed this transfer, stopping_ reads true here, and whatever is
+  // left is failed on this thread instead. Each transfer goes to exactly one
+  // of the threads taking the stack.
+  if (stopping_.load()) {
+    for (auto &left : TakeIncoming())
+      Fail(std::move(left), Status::Cancelled("event loop is shutting down"));
+    return;
+  }
+  curl_multi_wakeup(multi_);
+}
+
+void EventLoop::Schedule(CallOptions::Clock::time_point at,
+                         std::function<void()> fn) {
+  auto timer = new Timer();
+  timer->at = at;
+  timer->fn = std::move(fn);
+  timer->next = incoming_timers_.load(std::memory_order_relaxed);
+  while (!incoming_timers_.compare_exchange_weak(timer->next, timer,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed))
+    ;
+  curl_multi_wakeup(multi_);
+}
+
+std::vector<std::unique_ptr<EventLoop::Transfer>> EventLoop::TakeIncoming() {
+  std::vector<std::unique_ptr<Transfer>> batch;
+  Transfer *head = incoming_.exchange(nullptr);
+  for (; head; head = head->next)
+    batch.push_back(std::unique_ptr<Transfer>(head));
+  // The stack hands transfers back newest first; start them in the order
+  // they were submitted.
+  std::reverse(batch.begin(), batch.end());
+  return batch;
+}
+
+void EventLoop::RunTimers() {
+  Timer *head = incoming_timers_.exchange(nullptr, std::memory_order_acquire);
+  while (head) {
+    std::unique_ptr<Timer> timer(head);
+    head = head->next;
+    timers_.insert(std::make_pair(timer->at, std::move(timer->fn)));
+  }
+  const auto now = CallOptions::Clock::now();
+  while (!timers_.empty() && timers_.begin()->first <= now) {
+    auto fn = std::move(timers_.begin()->second);
+    timers_.erase(timers_.begin());
+    fn();
+  }
 }
 
+int EventLoop::PollTimeoutMs() const {
+  auto next = waiting_.NextDeadline();
+  if (!timers_.empty())
+    next = std::min(next, timers_.begin()->first);
+  if (next == CallOptions::Clock::time_point::max())
+    return 1000;
+  auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+      next - CallOptions::Clock::now());
+  // Round up, so a timer or deadline is never polled for just before it is
+  // due.
+  long ms = static_cast<long>(wait.count()) + 1;
+  return static_cast<int>(std::max(0L, std::min(ms, 1000L)));
+}
+
+ConcurrencyLimit &EventLoop::Limit() { return limit_; }
+
+void EventLoop::Start(std::unique_ptr<Transfer> transfer) {
+  const Request &req = *transfer->req;
+  if (req.cancel_.IsCancelled())
+    return Fail(std::move(transfer), Status::Cancelled("request cancelled"));
+  if (CallOptions::Clock::now() >= req.deadline_)
+    return Fail(
+        std::move(transfer),
+        Status::LocalTimeout("deadline passed before request started"));
+  CURL *handle = transfer->req->Prepare();
+  curl_easy_setopt(handle, CURLOPT_SHARE, share_);
+  transfer->started = ConcurrencyLimit::Clock::now();
+  active_[handle] = std::move(transfer);
+  curl_multi_add_handle(multi_, handle);
+}
+
+// Each class's share of the waiting room, relative to the others.
+static double priority_weight(Priority priority) {
+  switch (priority) {
+  case Priority::kInteractive:
+    return 64;
+  case Priority::kNormal:
+    return 8;
+  case Priority::kBatch:
+    break;
+  }
+  return 1;
+}
+
+EventLoop::WaitQueue::Head EventLoop::WaitQueue::HeadOf(Flow &flow) {
+  const Tagged &first = flow.queue.front();
+  return Head(std::make_tuple(first.tag, flow.priority, first.seq), &flow);
+}
+
+void EventLoop::WaitQueue::TrimFront(Flow &flow) {
+  while (!flow.queue.empty() && !flow.queue.front().transfer)
+    flow.queue.pop_front();
+}
+
+void EventLoop::WaitQueue::Push(std::unique_ptr<Transfer> transfer) {
+  const Request &req = *transfer->req;
+  const auto deadline = req.deadline_;
+  std::string key(1, static_cast<char>(req.priority_));
+  key += req.tenant_;
+  Flow &flow = flows_[key];
+  flow.priority = static_cast<int>(req.priority_);
+  const bool was_empty = flow.queue.empty();
+  const double tag = std::max(virtual_time_, flow.finish);
+  flow.finish = tag + 1 / priority_weight(req.priority_);
+  flow.queue.push_back(
+      Tagged{tag, seq_++, std::move(transfer), deadlines_.end()});
+  Tagged &tagged = flow.queue.back();
+  if (deadline != CallOptions::Clock::time_point::max())
+    tagged.deadline =
+        deadlines_.insert(std::make_pair(deadline, Slot{&flow, &tagged}));
+  ++flow.live;
+  if (was_empty)
+    heads_.insert(HeadOf(flow));
+  ++size_;
+}
+
+std::unique_ptr<EventLoop::Transfer> EventLoop::WaitQueue::Pop() {
+  if (heads_.empty())
+    return nullptr;
+  Flow &flow = *heads_.begin()->second;
+  heads_.erase(heads_.begin());
+  Tagged first = std::move(flow.queue.front());
+  flow.queue.pop_front();
+  if (first.deadline != deadlines_.end())
+    deadlines_.erase(first.deadline);
+  --flow.live;
+  TrimFront(flow);
+  virtual_time_ = first.tag;
+  if (!flow.queue.empty())
+    heads_.insert(HeadOf(flow));
+  --size_;
+  if (flows_.size() > 2 * heads_.size() + 64)
+    Purge();
+  return std::move(first.transfer);
+}
+
+std::unique_ptr<EventLoop::Transfer> EventLoop::WaitQueue::Take(Slot slot) {
+  Flow &flow = *slot.flow;
+  Tagged &tagged = *slot.tagged;
+  const bool front = &tagged == &flow.queue.front();
+  if (front)
+    heads_.erase(HeadOf(flow));
+  std::unique_ptr<Transfer> transfer = std::move(tagged.transfer);
+  if (tagged.deadline != deadlines_.end()) {
+    deadlines_.erase(tagged.deadline);
+    tagged.deadline = deadlines_.end();
+  }
+  --flow.live;
+  --size_;
+  // The slot stays behind unless it was at the front; Pop skips it later.
+  TrimFront(flow);
+  if (front && !flow.queue.empty())
+    heads_.insert(HeadOf(flow));
+  return transfer;
+}
+
+void EventLoop::WaitQueue::Purge() {
+  // An idle flow that virtual time has caught up with would start from
+  // virtual time anyway.
+  for (auto it = flows_.begin(); it != flows_.end();) {
+    if (it->second.queue.empty() && it->second.finish <= virtual_time_)
+      it = flows_.erase(it);
+    else
+      ++it;
+  }
+}
+
+CallOptions::Clock::time_point EventLoop::WaitQueue::NextDeadline() const {
+  return deadlines_.empty() ? CallOptions::Clock::time_point::max()
+                            : deadlines_.begin()->first;
+}
+
+std::vector<std::unique_ptr<EventLoop::Transfer>>
+EventLoop::WaitQueue::Expire(CallOptions::Clock::time_point now) {
+  std::vector<std::unique_ptr<Transfer>> expired;
+  while (!deadlines_.empty() && deadlines_.begin()->first <= now)
+    expired.push_back(Take(deadlines_.begin()->second));
+  return expired;
+}
+
+std::vector<std::unique_ptr<EventLoop::Transfer>>
+EventLoop::WaitQueue::RemoveIf(
+    const std::function<bool(const Transfer &)> &match) {
+  std::vector<Slot> matched;
+  for (auto &entry : flows_) {
+    for (auto &tagged : entry.second.queue) {
+      if (tagged.transfer && match(*tagged.transfer))
+        matched.push_back(Slot{&entry.second, &tagged});
+    }
+  }
+  std::vector<std::unique_ptr<Transfer>> removed;
+  for (const Slot &slot : matched)
+    removed.push_back(Take(slot));
+  Purge();
+  return removed;
+}
+
+void EventLoop::StartWaiting() {
+  const size_t limit = limit_.Limit();
+  while (!waiting_.Empty() && active_.size() < limit)
+    Start(waiting_.Pop());
+}
+
+bool EventLoop::Cancelled(const Transfer &transfer,
+                          const std::vector<const void *> &owners) {
+  return transfer.req->cancel_.IsCancelled() ||
+         (transfer.owner && std::find(owners.begin(), owners.end(),
+                                      transfer.owner) != owners.end());
+}
+
+void EventLoop::ExpireWaiting() {
+  for (auto &transfer : waiting_.Expire(CallOptions::Clock::now()))
+    Fail(std::move(transfer),
+         Status::LocalTimeout("deadline passed while waiting to be sent"));
+}
+
+void EventLoop::AbortCancelled() {
+  std::vector<const void *> owners;
+  {
+    std::lock_guard<std::mutex> lock(owners_mu_);
+    owners.swap(cancelled_owners_);
+  }
+  auto removed = waiting_.RemoveIf([&](const Transfer &transfer) {
+    return Cancelled(transfer, owners);
+  });
+  for (auto &transfer : removed)
+    Fail(std::move(transfer), Status::Cancelled("request cancelled"));
+  std::vector<CURL *> handles;
+  for (const auto &entry : active_) {
+    if (Cancelled(*entry.second, owners))
+      handles.push_back(entry.first);
+  }
+  for (CURL *handle : handles)
+    Fail(Remove(handle), Status::Cancelled("request cancelled"));
+}
+
+void EventLoop::Run() {
+  while (!stopping_.load()) {
+    RunTimers();
+    for (auto &transfer : TakeIncoming())
+      waiting_.Push(std::move(transfer));
+    if (cancel_pending_.exchange(false))
+      AbortCancelled();
+    ExpireWaiting();
+    StartWaiting();
+
+    int running = 0;
+    curl_multi_perform(multi_, &running);
+    int queued = 0;
+    bool completed = false;
+    while (CURLMsg *msg = curl_multi_info_read(multi_, &queued)) {
+      if (msg->msg == CURLMSG_DONE) {
+        Complete(msg->easy_handle, msg->data.result);
+        completed = true;
+      }
+    }
+    // Fill the slots just freed now rather than after the next poll.
+    if (completed && !waiting_.Empty()) {
+      StartWaiting();
+      curl_multi_perform(multi_, &running);
+    }
+    limit_.Observe(active_.size(), waiting_.Size());
+    curl_multi_poll(multi_, nullptr, 0, PollTimeoutMs(), nullptr);
+  }
+
+  // Fail whatever is still queued or in flight, so no caller waits forever.
+  const auto shutdown = Status::RequestError("event loop is shutting down");
+  for (auto &transfer : TakeIncoming())
+    Fail(std::move(transfer), shutdown);
+  while (!waiting_.Empty())
+    Fail(waiting_.Pop(), shutdown);
+  while (!active_.empty())
+    Fail(Remove(active_.begin()->first), shutdown);
+  Timer *head = incoming_timers_.exchange(nullptr, std::memory_order_acquire);
+  while (head) {
+    std::unique_ptr<Timer> timer(head);
+    head = head->next;
+  }
+  timers_.clear();
+}
+
+std::unique_ptr<EventLoop::Transfer> EventLoop::Remove(CURL *handle) {
+  auto it = active_.find(handle);
+  if (it == active_.end())
+    return nullptr;
+  auto transfer = std::move(it->second);
+  active_.erase(it);
+  // Removing a handle mid-transfer closes its connection, which is what frees
+  // the slot for a cancelled request straight away.
+  curl_multi_remove_handle(multi_, handle);
+  return transfer;
+}
+
+// Slack for telling a transfer stopped by its deadline from one stopped by
+// the connect or stall timeout: curl is given the deadline in whole
+// milliseconds, and its timers can fire a little early or late.
+static const std::chrono::milliseconds kDeadlineSlack(5);
+
+// What a finished transfer says about load on the API (and on the way
+// there).
+static ConcurrencyLimit::Outcome
+outcome_of(const StatusWrapped<Response> &resp, long code,
+           CallOptions::Clock::time_point deadline) {
+  using Outcome = ConcurrencyLimit::Outcome;
+  if (!resp.IsOk()) {
+    if (!resp.GetStatus().IsTimeout())
+      return Outcome::kIgnored;
+    if (deadline != CallOptions::Clock::time_point::max() &&
+        CallOptions::Clock::now() + kDeadlineSlack >= deadline)
+      return Outcome::kDeadline;
+    return Outcome::kOverloaded;
+  }
+  if (code == 429 || code == 503)
+    return Outcome::kOverloaded;
+  return Outcome::kAnswered;
+}
+
+void EventLoop::Complete(CURL *handle, CURLcode res) {
+  const size_t in_flight = active_.size();
+  const char *url = nullptr;
+  curl_easy_getinfo(handle, CURLINFO_EFFECTIVE_URL, &url);
+  const std::string route = url ? url : "";
+  auto transfer = Remove(handle);
+  if (!transfer)
+    return;
+  transfer->req->cancel_.Unsubscribe(transfer->cancel_listener);
+  auto resp = transfer->req->Finish(res);
+  long code = 0;
+  curl_easy_getinfo(handle, CURLINFO_RESPONSE_CODE, &code);
+  limit_.Record(route, transfer->started,
+                outcome_of(resp, code, transfer->req->deadline_), in_flight);
+  transfer->done(std::move(resp));
+}
+
+void EventLoop::Fail(std::unique_ptr<Transfer> transfer, Status status) {
+  transfer->req->cancel_.Unsubscribe(transfer->cancel_listener);
+  transfer->done(StatusWrapped<Response>::FromStatus(status));
+}
+
+std::shared_ptr<Transport> Transport::Create(size_t threads) {
+  return std::shared_ptr<Transport>(new Transport(threads));
+}
+
+Transport::Transport(size_t threads)
+    : pool_(new ThreadPool(threads)), loop_(new EventLoop()) {}
+
+Transport::~Transport() = default;
+
+ThreadPool &Transport::Pool() { return *pool_; }
+
+EventLoop &Transport::Loop() { return *loop_; }
+
 } // namespace plaid
\ No newline at end of file
@@ -0,0 +1,420 @@
+#include "plaid/webhooks.h"
+#include "plaid/client.h"
+
+#include <openssl/core_names.h>
+#include <openssl/evp.h>
+#include <openssl/param_build.h>
+#include <openssl/sha.h>
+
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace plaid {
+
+// Largest JWT header and payload we decode. Plaid's are well under 200
+// bytes each.
+static const size_t kMaxTokenPart = 1024;
+
+struct WebhookVerifier::Key {
+  EVP_PKEY *pkey = nullptr;
+  // Distinguishes this key from every other one loaded in the process, so
+  // each thread can tell whether its cached context is still for it.
+  uint64_t generation = 0;
+  bool expired = false;
+
+  ~Key() { EVP_PKEY_free(pkey); }
+};
+
+struct WebhookVerifier::Flight {
+  std::mutex mu;
+  std::condition_variable cv;
+  bool done = false;
+  Status status = Status::OK();
+  std::shared_ptr<const Key> key;
+};
+
+static std::atomic<uint64_t> key_generation(0);
+
+// A verification context for the last key this thread verified with.
+// Successive webhooks are almost always signed by the same key, so this
+// saves setting up a context per call.
+struct VerifyContext {
+  uint64_t generation = 0;
+  EVP_PKEY_CTX *ctx = nullptr;
+
+  ~VerifyContext() { EVP_PKEY_CTX_free(ctx); }
+};
+
+static thread_local VerifyContext verify_context;
+
+static Status verification_error(const std::string &what) {
+  return Status::VerificationError(what);
+}
+
+static int base64url_value(char c) {
+  if (c >= 'A' && c <= 'Z')
+    return c - 'A';
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 26;
+  if (c >= '0' && c <= '9')
+    return c - '0' + 52;
+  if (c == '-')
+    return 62;
+  if (c == '_')
+    return 63;
+  return -1;
+}
+
+// Decodes base64url (padded or not) into out, which holds max bytes. Returns
+// the decoded length, or -1 if the input is malformed or doesn't fit.
+static int base64url_decode(const char *in, size_t len, unsigned char *out,
+                            size_t max) {
+  uint32_t acc = 0;
+  int bits = 0;
+  size_t n = 0;
+  for (size_t i = 0; i < len; ++i) {
+    if (in[i] == '=')
+      break;
+    int v = base64url_value(in[i]);
+    if (v < 0)
+      return -1;
+    acc = (acc << 6) | static_cast<uint32_t>(v);
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      if (n == max)
+        return -1;
+      out[n++] = static_cast<unsigned char>(acc >> bits);
+    }
+  }
+  return static_cast<int>(n);
+}
+
+// Finds "name": in a flat JSON object and points value at what follows it:
+// the contents of a string, or the text of a number. Strings with escapes
+// are refused; none of the fields we read have any.
+static bool json_field(const char *json, size_t len, const char *name,
+                       const char *&value, size_t &value_len) {
+  const size_t name_len = strlen(name);
+  const char *end = json + len;
+  for (const char *p = json; p + name_len + 2 < end; ++p) {
+    if (p[0] != '"' || p[name_len + 1] != '"' ||
+        memcmp(p + 1, name, name_len) != 0)
+      continue;
+    const char *q = p + name_len + 2;
+    while (q < end && isspace(static_cast<unsigned char>(*q)))
+      ++q;
+    if (q == end || *q != ':')
+      continue;
+    ++q;
+    while (q < end && isspace(static_cast<unsigned char>(*q)))
+      ++q;
+    if (q == end)
+      return false;
+    if (*q == '"') {
+      const char *start = ++q;
+      while (q < end && *q != '"' && *q != '\\')
+        ++q;
+      if (q == end || *q != '"')
+        return false;
+      value = start;
+      value_len = q - start;
+      return true;
+    }
+    const char *start = q;
+    while (q < end && (isdigit(static_cast<unsigned char>(*q)) || *q == '-' ||
+                       *q == '.'))
+      ++q;
+    value = start;
+    value_len = q - start;
+    return value_len > 0;
+  }
+  return false;
+}
+
+static bool field_equals(const char *value, size_t len, const char *expect) {
+  return len == strlen(expect) && memcmp(value, expect, len) == 0;
+}
+
+// Appends a big-endian unsigned integer as a DER INTEGER.
+static size_t der_integer(const unsigned char *v, size_t len,
+                          unsigned char *out) {
+  while (len > 1 && v[0] == 0) {
+    ++v;
+    --len;
+  }
+  const size_t pad = (v[0] & 0x80) ? 1 : 0;
+  size_t n = 0;
+  out[n++] = 0x02;
+  out[n++] = static_cast<unsigned char>(len + pad);
+  if (pad)
+    out[n++] = 0;
+  memcpy(out + n, v, len);
+  return n + len;
+}
+
+// JWS carries ES256 signatures as r || s; OpenSSL wants an ECDSA-Sig-Value.
+static size_t der_signature(const unsigned char sig[64],
+                            unsigned char out[72]) {
+  unsigned char body[70];
+  size_t n = der_integer(sig, 32, body);
+  n += der_integer(sig + 32, 32, body + n);
+  out[0] = 0x30;
+  out[1] = static_cast<unsigned char>(n);
+  memcpy(out + 2, body, n);
+  return n + 2;
+}
+
+static EVP_PKEY *p256_public_key(const unsigned char point[65]) {
+  EVP_PKEY *pkey = nullptr;
+  OSSL_PARAM_BLD *bld = OSSL_PARAM_BLD_new();
+  OSSL_PARAM *params = nullptr;
+  EVP_PKEY_CTX *ctx = EVP_PKEY_CTX_new_from_name(nullptr, "EC", nullptr);
+  const bool ok =
+      bld && ctx &&
+      OSSL_PARAM_BLD_push_utf8_string(bld, OSSL_PKEY_PARAM_GROUP_NAME,
+                                      "prime256v1", 0) &&
+      OSSL_PARAM_BLD_push_octet_string(bld, OSSL_PKEY_PARAM_PUB_KEY, point,
+                                       65) &&
+      (params = OSSL_PARAM_BLD_to_param(bld)) != nullptr &&
+      EVP_PKEY_fromdata_init(ctx) > 0 &&
+      EVP_PKEY_fromdata(ctx, &pkey, EVP_PKEY_PUBLIC_KEY, params) > 0;
+  if (!ok) {
+    EVP_PKEY_free(pkey);
+    pkey = nullptr;
+  }
+  OSSL_PARAM_free(params);
+  OSSL_PARAM_BLD_free(bld);
+  EVP_PKEY_CTX_free(ctx);
+  return pkey;
+}
+
+WebhookVerifier::WebhookVerifier(Client &client,
+                                 const WebhookVerifierOptions &options)
+    : client_(client), options_(options) {
+  if (options_.max_keys == 0)
+    options_.max_keys = 1;
+}
+
+WebhookVerifier::~WebhookVerifier() {}
+
+Status WebhookVerifier::Verify(const WebhookEvent &event) {
+  return Verify(event.body, event.verification);
+}
+
+Status WebhookVerifier::Verify(const std::string &body,
+                               const std::string &verification) {
+  const char *token = verification.data();
+  const size_t dot1 = verification.find('.');
+  const size_t dot2 = dot1 == std::string::npos
+                          ? std::string::npos
+                          : verification.find('.', dot1 + 1);
+  if (dot2 == std::string::npos ||
+      verification.find('.', dot2 + 1) != std::string::npos)
+    return verification_error("malformed verification token");
+
+  unsigned char header[kMaxTokenPart];
+  int header_len = base64url_decode(token, dot1, header, sizeof(header));
+  if (header_len < 0)
+    return verification_error("malformed verification token");
+  const char *header_json = reinterpret_cast<const char *>(header);
+  const char *value;
+  size_t value_len;
+  if (!json_field(header_json, header_len, "alg", value, value_len) ||
+      !field_equals(value, value_len, "ES256"))
+    return verification_error("unsupported signing algorithm");
+  if (!json_field(header_json, header_len, "kid", value, value_len))
+    return verification_error("missing key id");
+  // Kept per thread so that looking the key up doesn't allocate.
+  static thread_local std::string kid;
+  kid.assign(value, value_len);
+
+  auto found = KeyFor(kid);
+  if (!found.IsOk())
+    return found.GetStatus();
+  std::shared_ptr<const Key> key = found.Take();
+  if (key->expired)
+    return verification_error("verification key has expired");
+
+  unsigned char sig[64];
+  if (base64url_decode(token + dot2 + 1, verification.size() - dot2 - 1, sig,
+                       sizeof(sig)) != 64)
+    return verification_error("malformed signature");
+  unsigned char der[72];
+  const size_t der_len = der_signature(sig, der);
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(token), dot2, digest);
+
+  VerifyContext &vc = verify_context;
+  if (vc.generation != key->generation) {
+    EVP_PKEY_CTX_free(vc.ctx);
+    vc.generation = 0;
+    vc.ctx = EVP_PKEY_CTX_new(key->pkey, nullptr);
+    if (!vc.ctx || EVP_PKEY_verify_init(vc.ctx) <= 0)
+      return verification_error("couldn't set up signature check");
+    vc.generation = key->generation;
+  }
+  if (EVP_PKEY_verify(vc.ctx, der, der_len, digest, sizeof(digest)) != 1)
+    return verification_error("bad signature");
+
+  unsigned char payload[kMaxTokenPart];
+  int payload_len = base64url_decode(token + dot1 + 1, dot2 - dot1 - 1,
+                                     payload, sizeof(payload));
+  if (payload_len < 0)
+    return verification_error("malformed verification token");
+  const char *payload_json = reinterpret_cast<const char *>(payload);
+
+  if (!json_field(payload_json, payload_len, "iat", value, value_len))
+    return verification_error("missing issue time");
+  int64_t iat = 0;
+  for (size_t i = 0; i < value_len && isdigit(value[i]); ++i)
+    iat = iat * 10 + (value[i] - '0');
+  const int64_t now = static_cast<int64_t>(time(nullptr));
+  if (now - iat > options_.max_age.count())
+    return verification_error("verification token is too old");
+
+  if (!json_field(payload_json, payload_len, "request_body_sha256", value,
+                  value_len) ||
+      value_len != 2 * SHA256_DIGEST_LENGTH)
+    return verification_error("missing body hash");
+  SHA256(reinterpret_cast<const unsigned char *>(body.data()), body.size(),
+         digest);
+  static const char kHex[] = "0123456789abcdef";
+  unsigned char diff = 0;
+  for (size_t i = 0; i < SHA256_DIGEST_LENGTH; ++i) {
+    diff |= kHex[digest[i] >> 4] ^
+            tolower(static_cast<unsigned char>(value[2 * i]));
+    diff |= kHex[digest[i] & 0xf] ^
+            tolower(static_cast<unsigned char>(value[2 * i + 1]));
+  }
+  if (diff != 0)
+    return verification_error("body doesn't match its signature");
+  return Status::OK();
+}
+
+StatusWrapped<std::shared_ptr<const WebhookVerifier::Key>>
+WebhookVerifier::KeyFor(const std::string &kid) {
+  using Result = StatusWrapped<std::shared_ptr<const Key>>;
+  const auto now = std::chrono::steady_clock::now();
+  std::shared_ptr<Flight> flight;
+  std::shared_ptr<const Key> stale;
+  bool fetch = false;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto it = keys_.find(kid);
+    if (it == keys_.end()) {
+      MakeRoom();
+      it = keys_.emplace(kid, Entry()).first;
+    }
+    Entry &entry = it->second;
+    if (entry.key && now - entry.fetched < options_.key_ttl)
+      return Result(entry.key);
+    if (!entry.flight && !entry.failure.IsOk() &&
+        now - entry.failed < options_.miss_ttl) {
+      if (entry.key)
+        return Result(entry.key);
+      return Result::FromStatus(entry.failure);
+    }
+    stale = entry.key;
+    if (!entry.flight) {
+      entry.flight = std::make_shared<Flight>();
+      fetch = true;
+    }
+    flight = entry.flight;
+  }
+
+  if (fetch) {
+    auto res = Fetch(kid);
+    std::lock_guard<std::mutex> lock(mu_);
+    Entry &entry = keys_[kid];
+    entry.flight.reset();
+    {
+      std::lock_guard<std::mutex> flight_lock(flight->mu);
+      flight->done = true;
+      flight->status = res.GetStatus();
+      if (res.IsOk())
+        flight->key = res.Unwrap();
+      flight->cv.notify_all();
+    }
+    if (res.IsOk()) {
+      entry.key = flight->key;
+      entry.fetched = std::chrono::steady_clock::now();
+      entry.failure = Status::OK();
+    } else {
+      entry.failure = res.GetStatus();
+      entry.failed = std::chrono::steady_clock::now();
+    }
+  } else if (stale) {
+    // Someone else is refreshing it; the old key is still good meanwhile.
+    return Result(stale);
+  }
+
+  std::unique_lock<std::mutex> lock(flight->mu);
+  flight->cv.wait(lock, [&flight]() { return flight->done; });
+  if (flight->key)
+    return Result(flight->key);
+  // A failed refresh keeps the key we had.
+  if (stale)
+    return Result(stale);
+  return Result::FromStatus(flight->status);
+}
+
+void WebhookVerifier::MakeRoom() {
+  if (keys_.size() < options_.max_keys)
+    return;
+  // Entries with a fetch in flight stay, since their waiters need them.
+  for (auto it = keys_.begin(); it != keys_.end();) {
+    if (!it->second.key && !it->second.flight)
+      it = keys_.erase(it);
+    else
+      ++it;
+  }
+  while (keys_.size() >= options_.max_keys) {
+    auto oldest = keys_.end();
+    for (auto it = keys_.begin(); it != keys_.end(); ++it) {
+      if (it->second.flight)
+        continue;
+      if (oldest == keys_.end() || it->second.fetched < oldest->second.fetched)
+        oldest = it;
+    }
+    if (oldest == keys_.end())
+      return;
+    keys_.erase(oldest);
+  }
+}
+
+StatusWrapped<std::shared_ptr<const WebhookVerifier::Key>>
+WebhookVerifier::Fetch(const std::string &kid) {
+  using Result = StatusWrapped<std::shared_ptr<const Key>>;
+  auto res = client_.GetWebhookVerificationKey(kid);
+  if (!res.IsOk())
+    return Result::FromStatus(res.GetStatus());
+  const WebhookVerificationKey jwk = res.Take().key();
+  if (jwk.kty() != "EC" || jwk.crv() != "P-256" ||
+      (!jwk.alg().empty() && jwk.alg() != "ES256"))
+    return Result::FromStatus(
+        verification_error("unsupported verification key type"));
+  unsigned char point[65];
+  point[0] = 0x04;
+  if (base64url_decode(jwk.x().data(), jwk.x().size(), point + 1, 32) != 32 ||
+      base64url_decode(jwk.y().data(), jwk.y().size(), point + 33, 32) != 32)
+    return Result::FromStatus(
+        verification_error("malformed verification key"));
+  auto key = std::make_shared<Key>();
+  key->pkey = p256_public_key(point);
+  if (!key->pkey)
+    return Result::FromStatus(
+        verification_error("malformed verification key"));
+  key->generation = ++key_generation;
+  key->expired = jwk.expired_at() != 0;
+  return Result(std::shared_ptr<const Key>(std::move(key)));
+}
+
+} // namespace plaid
\ No newline at end of file
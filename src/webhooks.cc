@@ -0,0 +1,496 @@
+#include "plaid/webhooks.h"
+
+#include <google/protobuf/util/json_util.h>
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <string>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace plaid {
+
+static const size_t kMaxHeaderSize = 16 * 1024;
+static const int kMaxEvents = 256;
+static const int kSweepIntervalMs = 1000;
+
+struct WebhookServer::Connection {
+  std::string in;
+  std::string out;
+  size_t out_pos = 0;
+  // Set once a response says "Connection: close"; nothing more is read.
+  bool close_after_write = false;
+  // Whether the socket is registered for EPOLLOUT.
+  bool writing = false;
+  std::chrono::steady_clock::time_point last_active;
+};
+
+struct WebhookServer::Worker {
+  int epoll_fd = -1;
+  int listen_fd = -1;
+  int wake_fd = -1;
+  std::unordered_map<int, std::unique_ptr<Connection>> connections;
+  std::thread thread;
+
+  ~Worker() {
+    for (int fd : {epoll_fd, listen_fd, wake_fd}) {
+      if (fd >= 0)
+        close(fd);
+    }
+  }
+};
+
+static Status io_error(const std::string &what) {
+  return Status::IOError(what + ": " + std::strerror(errno));
+}
+
+static bool equals_lower(const std::string &a, const char *lower) {
+  size_t n = std::strlen(lower);
+  if (a.size() != n)
+    return false;
+  for (size_t i = 0; i < n; ++i) {
+    if (std::tolower(static_cast<unsigned char>(a[i])) != lower[i])
+      return false;
+  }
+  return true;
+}
+
+static void respond(std::string &out, const char *status, bool close) {
+  out += "HTTP/1.1 ";
+  out += status;
+  out += "\r\nContent-Length: 0\r\n";
+  if (close)
+    out += "Connection: close\r\n";
+  out += "\r\n";
+}
+
+WebhookServer::WebhookServer(const WebhookServerOptions &options)
+    : options_(options), stopping_(false), queue_(nullptr), queued_(0),
+      dispatcher_sleeping_(false) {
+  if (options_.io_threads <= 0)
+    options_.io_threads = 1;
+}
+
+WebhookServer::~WebhookServer() { Stop(); }
+
+void WebhookServer::On(const std::string &webhook_type, Handler handler) {
+  handlers_[webhook_type].push_back(std::move(handler));
+}
+
+Status WebhookServer::Start() {
+  if (started_)
+    return Status::OK();
+  in_addr addr;
+  if (inet_pton(AF_INET, options_.address.c_str(), &addr) != 1)
+    return Status::MissingInfo("invalid listen address " + options_.address);
+
+  std::vector<std::unique_ptr<Worker>> workers;
+  uint16_t port = options_.port;
+  for (int i = 0; i < options_.io_threads; ++i) {
+    std::unique_ptr<Worker> worker(new Worker());
+    worker->listen_fd =
+        socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (worker->listen_fd < 0)
+      return io_error("socket");
+    const int on = 1;
+    setsockopt(worker->listen_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+    setsockopt(worker->listen_fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on));
+    sockaddr_in sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sin_family = AF_INET;
+    sa.sin_addr = addr;
+    sa.sin_port = htons(port);
+    if (bind(worker->listen_fd, reinterpret_cast<sockaddr *>(&sa),
+             sizeof(sa)) != 0)
+      return io_error("bind");
+    if (listen(worker->listen_fd, SOMAXCONN) != 0)
+      return io_error("listen");
+    // Later sockets join the port the first one was given.
+    if (i == 0) {
+      socklen_t len = sizeof(sa);
+      getsockname(worker->listen_fd, reinterpret_cast<sockaddr *>(&sa), &len);
+      port = ntohs(sa.sin_port);
+    }
+
+    worker->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    worker->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (worker->epoll_fd < 0 || worker->wake_fd < 0)
+      return io_error("epoll");
+    for (int fd : {worker->listen_fd, worker->wake_fd}) {
+      epoll_event ev;
+      ev.events = EPOLLIN;
+      ev.data.fd = fd;
+      epoll_ctl(worker->epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    }
+    workers.push_back(std::move(worker));
+  }
+
+  workers_ = std::move(workers);
+  port_ = port;
+  started_ = true;
+  stopping_.store(false);
+  dispatch_stopping_ = false;
+  dispatcher_ = std::thread(&WebhookServer::Dispatch, this);
+  for (auto &worker : workers_)
+    worker->thread =
+        std::thread(&WebhookServer::Serve, this, std::ref(*worker));
+  return Status::OK();
+}
+
+void WebhookServer::Stop() {
+  if (!started_)
+    return;
+  stopping_.store(true);
+  const uint64_t one = 1;
+  for (auto &worker : workers_) {
+    // Only fails if the counter is saturated, which wakes the thread anyway.
+    ssize_t written = write(worker->wake_fd, &one, sizeof(one));
+    (void)written;
+  }
+  for (auto &worker : workers_)
+    worker->thread.join();
+  workers_.clear();
+  // Only now can nothing more be queued, so the dispatcher may finish.
+  {
+    std::lock_guard<std::mutex> lock(dispatch_mu_);
+    dispatch_stopping_ = true;
+  }
+  dispatch_cv_.notify_all();
+  dispatcher_.join();
+  started_ = false;
+}
+
+uint16_t WebhookServer::Port() const { return port_; }
+
+WebhookMetrics WebhookServer::Metrics() const {
+  WebhookMetrics m;
+  m.received = received_.Value();
+  m.rejected = rejected_.Value();
+  m.overloaded = overloaded_.Value();
+  return m;
+}
+
+void WebhookServer::Serve(Worker &worker) {
+  epoll_event events[kMaxEvents];
+  auto last_sweep = std::chrono::steady_clock::now();
+  while (!stopping_.load()) {
+    int n = epoll_wait(worker.epoll_fd, events, kMaxEvents, kSweepIntervalMs);
+    for (int i = 0; i < n; ++i) {
+      const int fd = events[i].data.fd;
+      if (fd == worker.wake_fd)
+        continue;
+      if (fd == worker.listen_fd) {
+        Accept(worker);
+        continue;
+      }
+      if (events[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        Read(worker, fd);
+      if (events[i].events & EPOLLOUT && worker.connections.count(fd))
+        Flush(worker, fd);
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - last_sweep < std::chrono::milliseconds(kSweepIntervalMs))
+      continue;
+    last_sweep = now;
+    std::vector<int> idle;
+    for (const auto &conn : worker.connections) {
+      if (now - conn.second->last_active > options_.idle_timeout)
+        idle.push_back(conn.first);
+    }
+    for (int fd : idle)
+      Close(worker, fd);
+  }
+  std::vector<int> open;
+  for (const auto &conn : worker.connections)
+    open.push_back(conn.first);
+  for (int fd : open)
+    Close(worker, fd);
+}
+
+void WebhookServer::Accept(Worker &worker) {
+  while (true) {
+    int fd = accept4(worker.listen_fd, nullptr, nullptr,
+                     SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0)
+      return;
+    const int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    if (epoll_ctl(worker.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+      close(fd);
+      continue;
+    }
+    std::unique_ptr<Connection> conn(new Connection());
+    conn->last_active = std::chrono::steady_clock::now();
+    worker.connections[fd] = std::move(conn);
+  }
+}
+
+void WebhookServer::Read(Worker &worker, int fd) {
+  auto it = worker.connections.find(fd);
+  if (it == worker.connections.end())
+    return;
+  Connection &conn = *it->second;
+  char buf[64 * 1024];
+  while (true) {
+    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+    if (n > 0) {
+      conn.in.append(buf, n);
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      break;
+    if (n < 0 && errno == EINTR)
+      continue;
+    // Closed by the peer, or failed. Anything still unanswered is dropped.
+    return Close(worker, fd);
+  }
+  conn.last_active = std::chrono::steady_clock::now();
+  if (conn.close_after_write)
+    conn.in.clear();
+  else
+    HandleRequests(conn);
+  Flush(worker, fd);
+}
+
+void WebhookServer::Flush(Worker &worker, int fd) {
+  Connection &conn = *worker.connections[fd];
+  while (conn.out_pos < conn.out.size()) {
+    ssize_t n = send(fd, conn.out.data() + conn.out_pos,
+                     conn.out.size() - conn.out_pos, MSG_NOSIGNAL);
+    if (n > 0) {
+      conn.out_pos += n;
+      continue;
+    }
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      if (!conn.writing) {
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLOUT;
+        ev.data.fd = fd;
+        epoll_ctl(worker.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+        conn.writing = true;
+      }
+      return;
+    }
+    return Close(worker, fd);
+  }
+  conn.out.clear();
+  conn.out_pos = 0;
+  if (conn.close_after_write)
+    return Close(worker, fd);
+  if (conn.writing) {
+    epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    epoll_ctl(worker.epoll_fd, EPOLL_CTL_MOD, fd, &ev);
+    conn.writing = false;
+  }
+}
+
+void WebhookServer::Close(Worker &worker, int fd) {
+  epoll_ctl(worker.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+  close(fd);
+  worker.connections.erase(fd);
+}
+
+void WebhookServer::HandleRequests(Connection &conn) {
+  // Requests may be pipelined, so keep going while whole ones are buffered.
+  size_t consumed = 0;
+  while (!conn.close_after_write) {
+    const size_t header_end = conn.in.find("\r\n\r\n", consumed);
+    if (header_end == std::string::npos) {
+      if (conn.in.size() - consumed > kMaxHeaderSize) {
+        rejected_.Add();
+        respond(conn.out, "431 Request Header Fields Too Large", true);
+        conn.close_after_write = true;
+      }
+      break;
+    }
+
+    // Request line, then one header per line.
+    size_t line_end = conn.in.find("\r\n", consumed);
+    const std::string request_line =
+        conn.in.substr(consumed, line_end - consumed);
+    const size_t sp1 = request_line.find(' ');
+    const size_t sp2 = request_line.find(' ', sp1 + 1);
+    if (sp1 == std::string::npos || sp2 == std::string::npos) {
+      rejected_.Add();
+      respond(conn.out, "400 Bad Request", true);
+      conn.close_after_write = true;
+      break;
+    }
+    const std::string method = request_line.substr(0, sp1);
+    const std::string target = request_line.substr(sp1 + 1, sp2 - sp1 - 1);
+    const std::string version = request_line.substr(sp2 + 1);
+
+    bool keep_alive = version == "HTTP/1.1";
+    bool chunked = false;
+    bool bad_length = false;
+    size_t content_length = 0;
+    std::string verification;
+    for (size_t pos = line_end + 2; pos < header_end;) {
+      size_t end = conn.in.find("\r\n", pos);
+      if (end == std::string::npos || end > header_end)
+        end = header_end;
+      const size_t colon = conn.in.find(':', pos);
+      if (colon != std::string::npos && colon < end) {
+        const std::string name = conn.in.substr(pos, colon - pos);
+        size_t value_start = colon + 1;
+        while (value_start < end && conn.in[value_start] == ' ')
+          ++value_start;
+        const std::string value =
+            conn.in.substr(value_start, end - value_start);
+        if (equals_lower(name, "content-length")) {
+          bad_length = value.empty() ||
+                       value.find_first_not_of("0123456789") !=
+                           std::string::npos ||
+                       value.size() > 18;
+          if (!bad_length)
+            content_length = std::stoull(value);
+        } else if (equals_lower(name, "transfer-encoding")) {
+          chunked = true;
+        } else if (equals_lower(name, "connection")) {
+          if (equals_lower(value, "close"))
+            keep_alive = false;
+          else if (equals_lower(value, "keep-alive"))
+            keep_alive = true;
+        } else if (equals_lower(name, "plaid-verification")) {
+          verification = value;
+        }
+      }
+      pos = end + 2;
+    }
+
+    // Plaid always sends a Content-Length; anything else is refused rather
+    // than parsed.
+    const char *error = nullptr;
+    if (bad_length)
+      error = "400 Bad Request";
+    else if (chunked)
+      error = "411 Length Required";
+    else if (content_length > options_.max_body_size)
+      error = "413 Payload Too Large";
+    if (error) {
+      rejected_.Add();
+      respond(conn.out, error, true);
+      conn.close_after_write = true;
+      break;
+    }
+
+    const size_t body_start = header_end + 4;
+    if (conn.in.size() - body_start < content_length)
+      break;
+    std::string body = conn.in.substr(body_start, content_length);
+    consumed = body_start + content_length;
+
+    const char *status;
+    if (method != "POST") {
+      rejected_.Add();
+      status = "405 Method Not Allowed";
+    } else {
+      status = HandleWebhook(target, std::move(body), std::move(verification));
+    }
+    respond(conn.out, status, !keep_alive);
+    conn.close_after_write = !keep_alive;
+  }
+  conn.in.erase(0, consumed);
+}
+
+const char *WebhookServer::HandleWebhook(const std::string &target,
+                                         std::string body,
+                                         std::string verification) {
+  if (!options_.path.empty() &&
+      target.compare(0, target.find('?'), options_.path) != 0) {
+    rejected_.Add();
+    return "404 Not Found";
+  }
+  std::unique_ptr<Queued> item(new Queued());
+  // Plaid adds fields to webhooks over time; those are skipped, not errors.
+  google::protobuf::util::JsonParseOptions parse_options;
+  parse_options.ignore_unknown_fields = true;
+  if (!google::protobuf::util::JsonStringToMessage(body, &item->event.webhook,
+                                                   parse_options)
+           .ok()) {
+    rejected_.Add();
+    return "400 Bad Request";
+  }
+  if (queued_.fetch_add(1) >= options_.max_queued) {
+    queued_.fetch_sub(1);
+    overloaded_.Add();
+    return "503 Service Unavailable";
+  }
+  item->event.body = std::move(body);
+  item->event.verification = std::move(verification);
+  received_.Add();
+  Enqueue(item.release());
+  return "200 OK";
+}
+
+void WebhookServer::Enqueue(Queued *item) {
+  item->next = queue_.load();
+  while (!queue_.compare_exchange_weak(item->next, item))
+    ;
+  // The dispatcher flags itself before its last look at the queue, so either
+  // it sees this item or we see it asleep. Taking its lock orders the wakeup
+  // against a dispatcher that is between that look and the wait.
+  if (dispatcher_sleeping_.load()) {
+    { std::lock_guard<std::mutex> lock(dispatch_mu_); }
+    dispatch_cv_.notify_one();
+  }
+}
+
+void WebhookServer::Dispatch() {
+  std::vector<Queued *> batch;
+  while (true) {
+    Queued *head = queue_.exchange(nullptr);
+    if (!head) {
+      std::unique_lock<std::mutex> lock(dispatch_mu_);
+      dispatcher_sleeping_.store(true);
+      dispatch_cv_.wait(lock, [this]() {
+        return queue_.load() != nullptr || dispatch_stopping_;
+      });
+      dispatcher_sleeping_.store(false);
+      if (queue_.load() == nullptr)
+        return;
+      continue;
+    }
+    // The stack hands webhooks back newest first; deliver them in the order
+    // they were accepted.
+    for (; head; head = head->next)
+      batch.push_back(head);
+    std::reverse(batch.begin(), batch.end());
+    for (Queued *item : batch) {
+      std::unique_ptr<Queued> owned(item);
+      queued_.fetch_sub(1);
+      const WebhookEvent &event = owned->event;
+      auto typed = handlers_.find(event.webhook.webhook_type());
+      if (typed != handlers_.end()) {
+        for (const auto &handler : typed->second)
+          handler(event);
+      }
+      if (!event.webhook.webhook_type().empty()) {
+        auto any = handlers_.find("");
+        if (any != handlers_.end()) {
+          for (const auto &handler : any->second)
+            handler(event);
+        }
+      }
+    }
+    batch.clear();
+  }
+}
+
+} // namespace plaid
\ No newline at end of file
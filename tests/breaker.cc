@@ -0,0 +1,157 @@
+// Walks an institution's circuit breaker through its states: failures open
+// it, a single probe goes through once open_time has passed, a failed probe
+// keeps it open for longer and a good one closes it. Calls whose deadline
+// passed before they were sent, and errors that aren't the institution's,
+// never count against it, and the token-to-institution map stays bounded.
+
+#include "check.h"
+#include "plaid/breaker.h"
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+using Breaker = plaid::InstitutionBreakers::Breaker;
+
+plaid::Status InstitutionDown() {
+  return plaid::Status::ApiError("INSTITUTION_ERROR", "INSTITUTION_DOWN",
+                                 "down");
+}
+
+plaid::CircuitBreakerOptions Options() {
+  plaid::CircuitBreakerOptions options;
+  options.failure_threshold = 3;
+  options.open_time = std::chrono::milliseconds(100);
+  options.max_open_time = std::chrono::milliseconds(200);
+  return options;
+}
+
+// Whether a call would be sent now, and as the probe.
+bool Admitted(plaid::InstitutionBreakers &breakers, Breaker &breaker,
+              bool &probe) {
+  return breakers.Admit(breaker, probe).IsOk();
+}
+
+void TestOpenHalfOpenClose() {
+  plaid::InstitutionBreakers breakers;
+  breakers.SetOptions(Options());
+  CHECK(!breakers.For("tok"));
+  breakers.Learn("tok", "ins_1");
+  std::shared_ptr<Breaker> breaker = breakers.For("tok");
+  CHECK(breaker);
+  bool probe = true;
+
+  // A success in between starts the count over.
+  breakers.Record(*breaker, InstitutionDown(), false);
+  breakers.Record(*breaker, InstitutionDown(), false);
+  breakers.Record(*breaker, plaid::Status::OK(), false);
+  breakers.Record(*breaker, InstitutionDown(), false);
+  breakers.Record(*breaker, plaid::Status::Timeout("timed out"), false);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kClosed);
+  CHECK(Admitted(breakers, *breaker, probe) && !probe);
+
+  breakers.Record(*breaker, InstitutionDown(), false);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kOpen);
+  const plaid::Status rejected = breakers.Admit(*breaker, probe);
+  CHECK(rejected.IsUnavailable());
+
+  // After open_time one probe goes through, and only one.
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  CHECK(Admitted(breakers, *breaker, probe) && probe);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kHalfOpen);
+  CHECK(!Admitted(breakers, *breaker, probe));
+
+  // A failed probe reopens it for twice as long.
+  breakers.Record(*breaker, InstitutionDown(), true);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kOpen);
+  std::this_thread::sleep_for(std::chrono::milliseconds(120));
+  CHECK(!Admitted(breakers, *breaker, probe));
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  CHECK(Admitted(breakers, *breaker, probe) && probe);
+
+  // A probe that says nothing about the institution lets the next call try.
+  breakers.Record(*breaker, plaid::Status::IOError("reset"), true);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kHalfOpen);
+  CHECK(Admitted(breakers, *breaker, probe) && probe);
+
+  // A good probe closes it.
+  breakers.Record(*breaker, plaid::Status::OK(), true);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kClosed);
+  CHECK(Admitted(breakers, *breaker, probe) && !probe);
+
+  // Other tokens at the institution share the breaker; others don't.
+  breakers.Learn("tok-2", "ins_1");
+  breakers.Learn("tok-3", "ins_2");
+  CHECK(breakers.For("tok-2") == breaker);
+  CHECK(breakers.For("tok-3") != breaker);
+}
+
+void TestOnlyInstitutionFailuresCount() {
+  plaid::InstitutionBreakers breakers;
+  breakers.SetOptions(Options());
+  breakers.Learn("tok", "ins_1");
+  std::shared_ptr<Breaker> breaker = breakers.For("tok");
+
+  // Calls that timed out waiting to be sent, errors about the Item, and
+  // network errors leave the breaker closed however many there are.
+  for (int i = 0; i < 10; ++i) {
+    breakers.Record(*breaker, plaid::Status::LocalTimeout("deadline passed"),
+                    false);
+    breakers.Record(*breaker,
+                    plaid::Status::ApiError("ITEM_ERROR",
+                                            "ITEM_LOGIN_REQUIRED", "login"),
+                    false);
+    breakers.Record(*breaker, plaid::Status::IOError("refused"), false);
+  }
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kClosed);
+
+  // Nor do they reset the count of real failures.
+  breakers.Record(*breaker, InstitutionDown(), false);
+  breakers.Record(*breaker, InstitutionDown(), false);
+  breakers.Record(*breaker, plaid::Status::LocalTimeout("deadline passed"),
+                  false);
+  breakers.Record(*breaker, InstitutionDown(), false);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kOpen);
+}
+
+void TestPrime() {
+  plaid::InstitutionBreakers breakers;
+  breakers.SetOptions(Options());
+  plaid::Institution institution;
+  institution.set_institution_id("ins_1");
+  institution.mutable_status()->mutable_item_logins()->set_status("DOWN");
+  breakers.Prime(institution);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kOpen);
+  institution.mutable_status()->mutable_item_logins()->set_status("HEALTHY");
+  breakers.Prime(institution);
+  CHECK(breakers.State("ins_1") == plaid::BreakerState::kClosed);
+}
+
+void TestTokensAreBounded() {
+  plaid::InstitutionBreakers breakers;
+  plaid::CircuitBreakerOptions options = Options();
+  options.max_tokens = 64;
+  breakers.SetOptions(options);
+  for (int i = 0; i < 10000; ++i)
+    breakers.Learn("tok-" + std::to_string(i), "ins_" + std::to_string(i % 3));
+  int known = 0;
+  for (int i = 0; i < 10000; ++i)
+    known += breakers.For("tok-" + std::to_string(i)) ? 1 : 0;
+  CHECK(known > 0);
+  CHECK(known <= 64);
+  // The token learned last is always kept.
+  CHECK(breakers.For("tok-9999"));
+}
+
+} // namespace
+
+int main() {
+  TestOpenHalfOpenClose();
+  TestOnlyInstitutionFailuresCount();
+  TestPrime();
+  TestTokensAreBounded();
+  return 0;
+}
\ No newline at end of file
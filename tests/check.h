@@ -0,0 +1,19 @@
+// The assertion the tests are written with.
+
+#ifndef PLAID_TESTS_CHECK_H_
+#define PLAID_TESTS_CHECK_H_
+
+#include <cstdio>
+#include <cstdlib>
+
+// Ends the test, saying where, unless cond holds.
+#define CHECK(cond)                                                            \
+  do {                                                                         \
+    if (!(cond)) {                                                             \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,        \
+              #cond);                                                          \
+      _Exit(1);                                                                \
+    }                                                                          \
+  } while (0)
+
+#endif // PLAID_TESTS_CHECK_H_
\ No newline at end of file
@@ -0,0 +1,95 @@
+// Calls one Client, and a second Client sharing its Transport, from many
+// threads at once against a loopback server. Build with
+// -Db_sanitize=thread to have ThreadSanitizer check the client's shared
+// state along the way.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/transport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kThreads = 16;
+const int kCallsPerThread = 60;
+
+// A canned body for each path.
+plaid_test::Reply Answer(const std::string &, const std::string &path,
+                         const std::string &) {
+  plaid_test::Reply reply;
+  if (path == "/accounts/get")
+    reply.body = "{\"request_id\":\"r\",\"accounts\":[],"
+                 "\"item\":{\"item_id\":\"item\",\"institution_id\":"
+                 "\"ins_1\"}}";
+  else
+    reply.body = "{\"request_id\":\"r\",\"categories\":[]}";
+  return reply;
+}
+
+} // namespace
+
+int main() {
+  plaid_test::LoopbackServer server(Answer);
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.Url();
+  auto client = plaid::Client::Create(creds);
+  auto other = plaid::Client::Create(creds, client->GetTransport());
+
+  std::atomic<int> failures(0);
+  std::atomic<int> pending(0);
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      plaid::Client &c = t % 4 == 3 ? *other : *client;
+      const std::string token = "access-token-" + std::to_string(t % 5);
+      for (int i = 0; i < kCallsPerThread; ++i) {
+        switch (i % 3) {
+        case 0:
+          if (!c.GetCategories().IsOk())
+            ++failures;
+          break;
+        case 1:
+          if (!c.GetAccounts(token).IsOk())
+            ++failures;
+          break;
+        default:
+          ++pending;
+          c.GetCategoriesAsync(
+              [&](plaid::StatusWrapped<plaid::GetCategoriesResponse> res) {
+                if (!res.IsOk())
+                  ++failures;
+                std::lock_guard<std::mutex> lock(mu);
+                if (--pending == 0)
+                  cv.notify_all();
+              });
+        }
+      }
+    });
+  }
+  for (auto &t : threads)
+    t.join();
+  {
+    std::unique_lock<std::mutex> lock(mu);
+    cv.wait(lock, [&]() { return pending.load() == 0; });
+  }
+
+  const uint64_t sent = client->Metrics().requests + other->Metrics().requests;
+  const uint64_t expected = kThreads * kCallsPerThread;
+  if (failures.load() != 0 || sent != expected) {
+    fprintf(stderr, "%d calls failed; %llu of %llu requests counted\n",
+            failures.load(), static_cast<unsigned long long>(sent),
+            static_cast<unsigned long long>(expected));
+    return 1;
+  }
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,240 @@
+// Feeds a ConcurrencyLimit completions directly to check its AIMD rules:
+// slow start, additive growth only while the limit is in use, cuts on
+// overload and rising latency (once per burst), and callers' own deadlines
+// cutting only requests that were overdue anyway. Then checks the same
+// against loopback servers through a client: 429s, 503s and connect
+// timeouts cut the limit, and sixteen calls stopped by a tight deadline on
+// a slow endpoint don't.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/concurrency.h"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <fcntl.h>
+#include <memory>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+using Clock = plaid::ConcurrencyLimit::Clock;
+using Outcome = plaid::ConcurrencyLimit::Outcome;
+
+const char kCategories[] = "{\"request_id\":\"r\",\"categories\":[]}";
+
+// Records n completions on route that took about latency each. Only
+// requests started after the last cut can cut the limit again, so the
+// completions meant to cut it take no time.
+void Complete(plaid::ConcurrencyLimit &limit, int n, Outcome outcome,
+              size_t in_flight, std::chrono::microseconds latency =
+                                    std::chrono::microseconds(1000),
+              const std::string &route = "/a") {
+  for (int i = 0; i < n; ++i)
+    limit.Record(route, Clock::now() - latency, outcome, in_flight);
+}
+
+std::chrono::microseconds Instant() { return std::chrono::microseconds(0); }
+
+void TestGrowth() {
+  plaid::ConcurrencyLimit limit;
+  CHECK(limit.Limit() == 16);
+  // The endpoint's baseline warms up on a quiet client.
+  Complete(limit, 32, Outcome::kAnswered, 1);
+  CHECK(limit.Limit() == 16);
+  // Then one per completion in slow start...
+  Complete(limit, 8, Outcome::kAnswered, 16);
+  CHECK(limit.Limit() == 24);
+  // ... but only while at least half the limit is in use.
+  Complete(limit, 8, Outcome::kAnswered, 2);
+  CHECK(limit.Limit() == 24);
+  CHECK(limit.Metrics().cuts == 0);
+
+  // After a cut, about one per limit's worth of completions.
+  Complete(limit, 1, Outcome::kOverloaded, 24, Instant());
+  CHECK(limit.Limit() == 12);
+  Complete(limit, 20, Outcome::kAnswered, 12);
+  CHECK(limit.Limit() == 13);
+
+  // The bounds hold either way.
+  plaid::ConcurrencyLimitOptions options;
+  options.min_limit = 4;
+  options.max_limit = 14;
+  limit.SetOptions(options);
+  Complete(limit, 100, Outcome::kAnswered, 16);
+  CHECK(limit.Limit() == 14);
+  for (int i = 0; i < 10; ++i)
+    Complete(limit, 1, Outcome::kOverloaded, 16, Instant());
+  CHECK(limit.Limit() == 4);
+}
+
+void TestCuts() {
+  plaid::ConcurrencyLimit limit;
+  Complete(limit, 32, Outcome::kAnswered, 1);
+
+  // An overloaded reply halves the limit; requests already in flight when
+  // it did don't cut it again.
+  const Clock::time_point before = Clock::now();
+  Complete(limit, 1, Outcome::kOverloaded, 16, Instant());
+  CHECK(limit.Limit() == 8);
+  for (int i = 0; i < 5; ++i)
+    limit.Record("/a", before, Outcome::kOverloaded, 16);
+  CHECK(limit.Limit() == 8);
+  CHECK(limit.Metrics().cuts == 1);
+  Complete(limit, 1, Outcome::kOverloaded, 8, Instant());
+  CHECK(limit.Limit() == 4);
+
+  // Cancelled and unconnected requests say nothing.
+  Complete(limit, 10, Outcome::kIgnored, 4);
+  CHECK(limit.Limit() == 4);
+
+  // Latency rising well past the endpoint's baseline cuts it gently.
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  Complete(limit, 1, Outcome::kAnswered, 4, std::chrono::microseconds(20000));
+  CHECK(limit.Limit() == 3);
+  CHECK(limit.Metrics().cuts == 3);
+}
+
+void TestDeadlines() {
+  plaid::ConcurrencyLimit limit;
+  Complete(limit, 32, Outcome::kAnswered, 1);
+  // Callers giving up sooner than the endpoint usually answers don't cut,
+  // and neither do deadlines on an endpoint with no baseline yet.
+  Complete(limit, 16, Outcome::kDeadline, 16, Instant());
+  Complete(limit, 16, Outcome::kDeadline, 16, std::chrono::seconds(1), "/b");
+  Complete(limit, 4, Outcome::kAnswered, 16, std::chrono::microseconds(1000),
+           "/b");
+  Complete(limit, 16, Outcome::kDeadline, 16, std::chrono::seconds(1), "/b");
+  CHECK(limit.Metrics().cuts == 0);
+  // A request far past the usual latency when its deadline hit was overdue
+  // anyway.
+  Complete(limit, 1, Outcome::kDeadline, 16, std::chrono::milliseconds(100));
+  CHECK(limit.Metrics().cuts == 1);
+}
+
+std::unique_ptr<plaid::Client> NewClient(const std::string &url) {
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = url;
+  return plaid::Client::Create(creds);
+}
+
+void TestOverloadedReplies() {
+  for (int status : {429, 503}) {
+    plaid_test::LoopbackServer server(
+        [status](const std::string &, const std::string &,
+                 const std::string &) {
+          plaid_test::Reply reply;
+          reply.status = status;
+          reply.body = "{\"request_id\":\"r\",\"error_type\":\"RATE_LIMIT_"
+                       "EXCEEDED\",\"error_code\":\"RATE_LIMIT\"}";
+          return reply;
+        });
+    auto client = NewClient(server.Url());
+    CHECK(!client->GetCategories().IsOk());
+    CHECK(client->Concurrency().Metrics().cuts == 1);
+    CHECK(client->Concurrency().Limit() == 8);
+  }
+}
+
+// A listening socket that never accepts, with its backlog filled, so that
+// connecting to it hangs until the connect timeout.
+class BlackHole {
+public:
+  BlackHole() {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    CHECK(bind(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+    CHECK(listen(fd_, 0) == 0);
+    socklen_t len = sizeof(addr);
+    getsockname(fd_, reinterpret_cast<sockaddr *>(&addr), &len);
+    port_ = ntohs(addr.sin_port);
+    for (int i = 0; i < 4; ++i) {
+      const int filler = socket(AF_INET, SOCK_STREAM, 0);
+      fcntl(filler, F_SETFL, O_NONBLOCK);
+      connect(filler, reinterpret_cast<sockaddr *>(&addr), sizeof(addr));
+      fillers_.push_back(filler);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+  ~BlackHole() {
+    for (int filler : fillers_)
+      close(filler);
+    close(fd_);
+  }
+
+  std::string Url() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + "/";
+  }
+
+private:
+  int fd_;
+  uint16_t port_;
+  std::vector<int> fillers_;
+};
+
+void TestConnectTimeout() {
+  BlackHole hole;
+  auto client = NewClient(hole.Url());
+  plaid::CallOptions call;
+  call.connect_timeout = std::chrono::milliseconds(200);
+  CHECK(client->GetCategories(call).GetStatus().IsTimeout());
+  CHECK(client->Concurrency().Metrics().cuts == 1);
+}
+
+void TestDeadlinesOnSlowEndpoint() {
+  plaid_test::LoopbackServer server([](const std::string &,
+                                       const std::string &,
+                                       const std::string &) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    plaid_test::Reply reply;
+    reply.body = kCategories;
+    return reply;
+  });
+  auto client = NewClient(server.Url());
+  // The endpoint's usual latency is 200ms.
+  std::atomic<int> remaining(40);
+  for (int i = 0; i < 40; ++i)
+    client->GetCategoriesAsync(
+        [&](plaid::StatusWrapped<plaid::GetCategoriesResponse> res) {
+          CHECK(res.IsOk());
+          --remaining;
+        });
+  while (remaining.load() > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+  // Sixteen callers that only wait 100ms all time out, which is their
+  // deadline's doing rather than the API's.
+  remaining = 16;
+  for (int i = 0; i < 16; ++i)
+    client->GetCategoriesAsync(
+        [&](plaid::StatusWrapped<plaid::GetCategoriesResponse> res) {
+          CHECK(res.GetStatus().IsTimeout());
+          --remaining;
+        },
+        plaid::CallOptions().WithTimeout(std::chrono::milliseconds(100)));
+  while (remaining.load() > 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  CHECK(client->Concurrency().Metrics().cuts == 0);
+  CHECK(client->Concurrency().Limit() >= 16);
+}
+
+} // namespace
+
+int main() {
+  TestGrowth();
+  TestCuts();
+  TestDeadlines();
+  TestOverloadedReplies();
+  TestConnectTimeout();
+  TestDeadlinesOnSlowEndpoint();
+  return 0;
+}
\ No newline at end of file
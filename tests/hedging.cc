@@ -0,0 +1,160 @@
+// Checks the pieces of request hedging: the hedge budget's accounting, the
+// latency histogram's estimates, and, against a loopback server, that a
+// slow read is hedged and won by the duplicate while error responses never
+// count towards the delay.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/hedging.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char kCategories[] = "{\"request_id\":\"r\",\"categories\":[]}";
+const char kServerError[] =
+    "{\"request_id\":\"r\",\"error_type\":\"API_ERROR\","
+    "\"error_code\":\"INTERNAL_SERVER_ERROR\",\"error_message\":\"boom\"}";
+
+void TestBudget() {
+  plaid::HedgeBudget budget;
+  CHECK(!budget.CanWithdraw());
+  CHECK(!budget.TryWithdraw());
+
+  // Deposits add up to whole hedges, and each hedge spends one.
+  budget.Deposit(0.5);
+  CHECK(!budget.CanWithdraw());
+  budget.Deposit(0.5);
+  CHECK(budget.CanWithdraw());
+  CHECK(budget.TryWithdraw());
+  CHECK(!budget.TryWithdraw());
+
+  // A deposit is worth at most one hedge, and nothing below zero.
+  budget.Deposit(5);
+  budget.Deposit(-1);
+  CHECK(budget.TryWithdraw());
+  CHECK(!budget.TryWithdraw());
+
+  // A long quiet stretch funds no more than ten hedges in a row.
+  for (int i = 0; i < 100; ++i)
+    budget.Deposit(1);
+  int hedges = 0;
+  while (budget.TryWithdraw())
+    ++hedges;
+  CHECK(hedges == 10);
+}
+
+void TestHistogram() {
+  using std::chrono::microseconds;
+  plaid::LatencyHistogram latency;
+  for (int i = 0; i < 31; ++i)
+    latency.Record(microseconds(1000));
+  CHECK(latency.Percentile(0.5).count() == 0);
+
+  // 90 fast samples and 10 slow ones: the median is fast, p95 is slow, and
+  // either is within a bucket (about 20%) of the real value.
+  plaid::LatencyHistogram mixed;
+  for (int i = 0; i < 90; ++i)
+    mixed.Record(microseconds(1000));
+  for (int i = 0; i < 10; ++i)
+    mixed.Record(microseconds(50000));
+  CHECK(mixed.Percentile(0.5) >= microseconds(1000));
+  CHECK(mixed.Percentile(0.5) <= microseconds(1200));
+  CHECK(mixed.Percentile(0.95) >= microseconds(50000));
+  CHECK(mixed.Percentile(0.95) <= microseconds(60000));
+}
+
+// How the server answers /categories/get.
+enum class Mode { kFast, kError, kSlowFirst };
+
+struct Server {
+  std::atomic<Mode> mode{Mode::kFast};
+  std::atomic<int> requests{0};
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &,
+                                         const std::string &) {
+    plaid_test::Reply reply;
+    reply.body = kCategories;
+    const int n = ++requests;
+    switch (mode.load()) {
+    case Mode::kError:
+      reply.status = 500;
+      reply.body = kServerError;
+      break;
+    case Mode::kSlowFirst:
+      // Only the first request after the switch is slow, so a hedge sent
+      // alongside it answers at once.
+      if (n == 1)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+      break;
+    case Mode::kFast:
+      break;
+    }
+    return reply;
+  }};
+
+  void Switch(Mode next) {
+    requests = 0;
+    mode = next;
+  }
+};
+
+plaid::CallOptions Hedged() {
+  plaid::CallOptions call;
+  call.hedging.enabled = true;
+  call.hedging.percentile = 0.9;
+  // Every call pays for a whole hedge, so the budget never gets in the way.
+  call.hedging.max_extra_load = 1;
+  return call;
+}
+
+std::unique_ptr<plaid::Client> NewClient(const Server &server) {
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  return plaid::Client::Create(creds);
+}
+
+void TestSlowReadIsHedged() {
+  Server server;
+  auto client = NewClient(server);
+  for (int i = 0; i < 64; ++i)
+    CHECK(client->GetCategories().IsOk());
+
+  server.Switch(Mode::kSlowFirst);
+  const auto start = std::chrono::steady_clock::now();
+  CHECK(client->GetCategories(Hedged()).IsOk());
+  CHECK(std::chrono::steady_clock::now() - start <
+        std::chrono::milliseconds(1000));
+  const plaid::ClientMetrics m = client->Metrics();
+  CHECK(m.hedged_requests == 1);
+  CHECK(m.hedge_wins == 1);
+}
+
+void TestErrorsAreNotTimed() {
+  Server server;
+  auto client = NewClient(server);
+  server.Switch(Mode::kError);
+  for (int i = 0; i < 64; ++i)
+    CHECK(!client->GetCategories().IsOk());
+
+  // Only errors have been seen so far, so there is no delay to hedge after
+  // and the slow call is left to run its course.
+  server.Switch(Mode::kSlowFirst);
+  CHECK(client->GetCategories(Hedged()).IsOk());
+  CHECK(client->Metrics().hedged_requests == 0);
+}
+
+} // namespace
+
+int main() {
+  TestBudget();
+  TestHistogram();
+  TestSlowReadIsHedged();
+  TestErrorsAreNotTimed();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+// Checks how InstitutionIndex::Search ranks a small catalog: exact names
+// over name prefixes over word matches over URL matches over typos, with
+// case and punctuation folded away, and the product, country and limit
+// filters applied.
+
+#include "check.h"
+#include "plaid/institutions.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Entry {
+  const char *id;
+  const char *name;
+  const char *url;
+  const char *country;
+  const char *product;
+};
+
+const Entry kCatalog[] = {
+    {"ins_chase_eu", "Chase Bank Europe", "", "GB", "transactions"},
+    {"ins_chase", "Chase", "https://www.chase.com", "US", "transactions"},
+    {"ins_bofa", "Bank of America", "https://www.bankofamerica.com", "US",
+     "transactions"},
+    {"ins_wells", "Wells Fargo", "https://www.wellsfargo.com", "US", "auth"},
+    {"ins_schwab", "Charles Schwab", "https://www.schwab.com", "US",
+     "investments"},
+    {"ins_amex", "American Express", "https://www.americanexpress.com", "US",
+     "transactions"},
+    {"ins_first", "First Bank", "", "US", "transactions"},
+};
+
+plaid::GetInstitutionsResponse Catalog() {
+  plaid::GetInstitutionsResponse catalog;
+  for (const Entry &entry : kCatalog) {
+    plaid::Institution *institution = catalog.add_institutions();
+    institution->set_institution_id(entry.id);
+    institution->set_name(entry.name);
+    institution->set_url(entry.url);
+    institution->add_country_codes(entry.country);
+    institution->add_products(entry.product);
+  }
+  return catalog;
+}
+
+std::vector<std::string> Search(const plaid::InstitutionIndex &index,
+                                const std::string &query,
+                                const std::vector<std::string> &products = {},
+                                const std::vector<std::string> &countries = {},
+                                size_t limit = 10) {
+  std::vector<std::string> ids;
+  for (const plaid::Institution *institution :
+       index.Search(query, products, countries, limit))
+    ids.push_back(institution->institution_id());
+  return ids;
+}
+
+using Ids = std::vector<std::string>;
+
+} // namespace
+
+int main() {
+  plaid::InstitutionIndex index(Catalog(), std::chrono::system_clock::now());
+
+  // The whole name beats a name that merely starts with it.
+  CHECK(Search(index, "chase") == Ids({"ins_chase", "ins_chase_eu"}));
+  // A name prefix beats a match on a later word.
+  CHECK(Search(index, "bank") ==
+        Ids({"ins_bofa", "ins_first", "ins_chase_eu"}));
+  CHECK(Search(index, "fargo") == Ids({"ins_wells"}));
+  CHECK(Search(index, "wel far") == Ids({"ins_wells"}));
+  // A URL match ranks below the names, but above Bank of America, which
+  // only shares enough trigrams.
+  CHECK(Search(index, "americanex") == Ids({"ins_amex", "ins_bofa"}));
+  CHECK(Search(index, "bankof") == Ids({"ins_bofa"}));
+  // Ties go to the shorter name.
+  CHECK(Search(index, "ch") ==
+        Ids({"ins_chase", "ins_schwab", "ins_chase_eu"}));
+
+  // Case, punctuation and extra spaces don't matter.
+  CHECK(Search(index, "CHASE") == Search(index, "chase"));
+  CHECK(Search(index, "  Bank of AMERICA!! ").front() == "ins_bofa");
+  CHECK(Search(index, "wells-fargo") == Ids({"ins_wells"}));
+
+  // Misspelled names still come up, on shared trigrams.
+  CHECK(Search(index, "wells fargp") == Ids({"ins_wells"}));
+  CHECK(Search(index, "americn express") == Ids({"ins_amex"}));
+  CHECK(Search(index, "charls schwab").front() == "ins_schwab");
+  // But not when too little of the query matches.
+  CHECK(Search(index, "zzzz chase qqqq").empty());
+
+  // Filters.
+  CHECK(Search(index, "chase", {}, {"US"}) == Ids({"ins_chase"}));
+  CHECK(Search(index, "chase", {}, {"GB", "FR"}) == Ids({"ins_chase_eu"}));
+  CHECK(Search(index, "bank", {"transactions"}, {"US"}) ==
+        Ids({"ins_bofa", "ins_first"}));
+  CHECK(Search(index, "wells", {"transactions"}).empty());
+  CHECK(Search(index, "chase", {}, {}, 1) == Ids({"ins_chase"}));
+  CHECK(Search(index, "", {}, {}).empty());
+  CHECK(Search(index, "!!").empty());
+  return 0;
+}
\ No newline at end of file
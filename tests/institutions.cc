@@ -0,0 +1,197 @@
+// Loads an institutions catalog from a loopback server page by page, saves
+// it to a snapshot and reads it back, checks that damaged snapshots are
+// turned away without touching the loaded catalog, and that StopRefresh
+// cancels a reload stuck on the network.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/institutions.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <google/protobuf/util/json_util.h>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+
+namespace {
+
+const int kInstitutions = 1234;
+
+struct Server {
+  std::atomic<int> requests{0};
+  std::atomic<int> in_flight{0};
+  std::atomic<int> max_in_flight{0};
+  // While hang is set, requests wait until it is cleared.
+  std::mutex mu;
+  std::condition_variable cv;
+  bool hang = false;
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    if (path != "/institutions/get") {
+      reply.status = 404;
+      return reply;
+    }
+    ++requests;
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cv.wait(lock, [this]() { return !hang; });
+    }
+    const int now = ++in_flight;
+    int seen = max_in_flight.load();
+    while (now > seen && !max_in_flight.compare_exchange_weak(seen, now))
+      ;
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    plaid::GetInstitutionsRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    plaid::GetInstitutionsResponse resp;
+    resp.set_request_id("r");
+    resp.set_total(kInstitutions);
+    for (int64_t i = req.offset();
+         i < std::min<int64_t>(req.offset() + req.count(), kInstitutions);
+         ++i) {
+      plaid::Institution *institution = resp.add_institutions();
+      institution->set_institution_id("ins_" + std::to_string(i));
+      institution->set_name("Bank " + std::to_string(i));
+      institution->add_products("transactions");
+      institution->add_country_codes("US");
+    }
+    google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    --in_flight;
+    return reply;
+  }};
+
+  void Hang(bool on) {
+    std::lock_guard<std::mutex> lock(mu);
+    hang = on;
+    cv.notify_all();
+  }
+};
+
+std::unique_ptr<plaid::Client> NewClient(const Server &server) {
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  return plaid::Client::Create(creds);
+}
+
+std::string TempPath(const std::string &name) {
+  const char *dir = getenv("TMPDIR");
+  return std::string(dir ? dir : "/tmp") + "/plaid-" +
+         std::to_string(getpid()) + "-" + name;
+}
+
+void WriteFile(const std::string &path, const std::string &contents) {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(contents.data(), contents.size());
+  CHECK(file.good());
+}
+
+void TestLoad(Server &server, plaid::Client &client) {
+  plaid::InstitutionCatalogOptions options;
+  options.page_size = 100;
+  options.max_in_flight = 4;
+  plaid::InstitutionCatalog catalog(client, options);
+  CHECK(!catalog.Current());
+  CHECK(catalog.Load().IsOk());
+
+  auto index = catalog.Current();
+  CHECK(index);
+  CHECK(index->Size() == kInstitutions);
+  std::unordered_set<std::string> ids;
+  for (const plaid::Institution *institution : index->All())
+    ids.insert(institution->institution_id());
+  CHECK(ids.size() == kInstitutions);
+  for (int i = 0; i < kInstitutions; ++i)
+    CHECK(index->Find("ins_" + std::to_string(i)));
+  CHECK(index->All().front()->institution_id() == "ins_0");
+  CHECK(index->All().back()->institution_id() == "ins_1233");
+  CHECK(server.requests.load() == 13);
+  CHECK(server.max_in_flight.load() <= 4);
+}
+
+void TestSnapshots(plaid::Client &client) {
+  const std::string path = TempPath("institutions.snapshot");
+  plaid::InstitutionCatalog empty(client);
+  CHECK(empty.SaveSnapshot(path).IsMissingInfo());
+  CHECK(empty.LoadSnapshot(path).IsIOError());
+
+  plaid::InstitutionCatalog catalog(client);
+  CHECK(catalog.Load().IsOk());
+  CHECK(catalog.SaveSnapshot(path).IsOk());
+
+  plaid::InstitutionCatalog restored(client);
+  CHECK(restored.LoadSnapshot(path).IsOk());
+  auto saved = catalog.Current();
+  auto loaded = restored.Current();
+  CHECK(loaded->Size() == kInstitutions);
+  CHECK(loaded->Data().SerializeAsString() ==
+        saved->Data().SerializeAsString());
+  CHECK(std::chrono::duration_cast<std::chrono::seconds>(
+            loaded->FetchedAt().time_since_epoch()) ==
+        std::chrono::duration_cast<std::chrono::seconds>(
+            saved->FetchedAt().time_since_epoch()));
+  CHECK(loaded->Find("ins_42")->name() == "Bank 42");
+
+  // Damaged files are turned away and the catalog already loaded stays.
+  std::string good;
+  {
+    std::ifstream file(path, std::ios::binary);
+    good.assign(std::istreambuf_iterator<char>(file),
+                std::istreambuf_iterator<char>());
+  }
+  std::string bad_magic = good;
+  bad_magic[0] = 'X';
+  WriteFile(path, bad_magic);
+  CHECK(restored.LoadSnapshot(path).IsParseError());
+  WriteFile(path, good.substr(0, 12));
+  CHECK(restored.LoadSnapshot(path).IsParseError());
+  WriteFile(path, good.substr(0, 16) + "not a protobuf");
+  CHECK(restored.LoadSnapshot(path).IsParseError());
+  CHECK(restored.Current() == loaded);
+
+  unlink(path.c_str());
+}
+
+void TestStopRefreshCancels(Server &server, plaid::Client &client) {
+  plaid::InstitutionCatalog catalog(client);
+  server.Hang(true);
+  server.requests = 0;
+  catalog.StartRefresh(std::chrono::seconds(1));
+  while (server.requests.load() == 0)
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+  // The reload is stuck on its first page; stopping doesn't wait for it.
+  const auto start = std::chrono::steady_clock::now();
+  catalog.StopRefresh();
+  CHECK(std::chrono::steady_clock::now() - start <
+        std::chrono::milliseconds(500));
+  CHECK(!catalog.Current());
+  server.Hang(false);
+}
+
+} // namespace
+
+int main() {
+  Server server;
+  auto client = NewClient(server);
+  TestLoad(server, *client);
+  TestSnapshots(*client);
+  TestStopRefreshCancels(server, *client);
+  return 0;
+}
\ No newline at end of file
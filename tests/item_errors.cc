@@ -0,0 +1,155 @@
+// Checks the ItemErrorCache on its own and through a client talking to a
+// loopback server: a terminal Item error short-circuits later data reads
+// for its access token, GetItem is still sent (and clears the entry once the
+// Item is fixed), and entries stop applying after the TTL.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/item_errors.h"
+
+#include <atomic>
+#include <chrono>
+#include <google/protobuf/util/json_util.h>
+#include <memory>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char kLoginRequired[] =
+    "{\"request_id\":\"r\",\"error_type\":\"ITEM_ERROR\","
+    "\"error_code\":\"ITEM_LOGIN_REQUIRED\","
+    "\"error_message\":\"the login details of this item have changed\"}";
+
+plaid::Status LoginRequired() {
+  return plaid::Status::ApiError("ITEM_ERROR", "ITEM_LOGIN_REQUIRED",
+                                 "login required");
+}
+
+void TestCache() {
+  plaid::ItemErrorCache cache;
+  CHECK(cache.Check("tok").IsOk());
+
+  // Transient errors aren't kept.
+  cache.Record("tok", plaid::Status::ApiError("RATE_LIMIT_EXCEEDED",
+                                              "RATE_LIMIT", "slow down"));
+  cache.Record("tok", plaid::Status::Timeout("timed out"));
+  CHECK(cache.Check("tok").IsOk());
+  CHECK(cache.Size() == 0);
+
+  cache.Record("tok", LoginRequired());
+  const plaid::Status cached = cache.Check("tok");
+  CHECK(cached.IsApiError());
+  CHECK(cached.ErrorCode() == "ITEM_LOGIN_REQUIRED");
+  CHECK(cache.Check("other").IsOk());
+  CHECK(cache.Size() == 1);
+  cache.Clear("tok");
+  CHECK(cache.Check("tok").IsOk());
+  CHECK(cache.Size() == 0);
+
+  // Entries expire, and a zero TTL keeps nothing.
+  plaid::ItemErrorCacheOptions options;
+  options.ttl = std::chrono::milliseconds(50);
+  cache.SetOptions(options);
+  cache.Record("tok", LoginRequired());
+  CHECK(!cache.Check("tok").IsOk());
+  std::this_thread::sleep_for(std::chrono::milliseconds(80));
+  CHECK(cache.Check("tok").IsOk());
+  CHECK(cache.Size() == 0);
+  options.ttl = std::chrono::milliseconds(0);
+  cache.SetOptions(options);
+  cache.Record("tok", LoginRequired());
+  CHECK(cache.Check("tok").IsOk());
+}
+
+// Answers balances and GetItem for one Item, whose login is broken while
+// broken is set.
+struct Server {
+  std::atomic<bool> broken{true};
+  std::atomic<int> balances{0};
+  std::atomic<int> items{0};
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &) {
+    plaid_test::Reply reply;
+    if (path == "/accounts/balance/get") {
+      ++balances;
+      if (broken) {
+        reply.status = 400;
+        reply.body = kLoginRequired;
+      } else {
+        reply.body = "{\"request_id\":\"r\",\"accounts\":[]}";
+      }
+    } else if (path == "/item/get") {
+      ++items;
+      plaid::GetItemResponse resp;
+      resp.set_request_id("r");
+      resp.mutable_item()->set_item_id("item_1");
+      resp.mutable_item()->set_institution_id("ins_1");
+      if (broken) {
+        plaid::Error *error = resp.mutable_item()->mutable_error();
+        error->set_error_type("ITEM_ERROR");
+        error->set_error_code("ITEM_LOGIN_REQUIRED");
+      }
+      google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    } else {
+      reply.status = 404;
+    }
+    return reply;
+  }};
+};
+
+void TestClient() {
+  Server server;
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  auto client = plaid::Client::Create(creds);
+
+  // The first read is sent and fails; the ones after it aren't sent.
+  auto first = client->GetBalances("tok");
+  CHECK(first.GetStatus().ErrorCode() == "ITEM_LOGIN_REQUIRED");
+  for (int i = 0; i < 5; ++i) {
+    auto again = client->GetBalances("tok");
+    CHECK(again.GetStatus().IsApiError());
+    CHECK(again.GetStatus().ErrorCode() == "ITEM_LOGIN_REQUIRED");
+  }
+  CHECK(server.balances.load() == 1);
+  CHECK(client->Metrics().item_error_skips == 5);
+  // Other access tokens aren't affected.
+  client->GetBalances("other-tok");
+  CHECK(server.balances.load() == 2);
+
+  // GetItem still goes out, and once it shows the Item fixed, reads go out
+  // again.
+  CHECK(client->GetItem("tok").IsOk());
+  CHECK(server.items.load() == 1);
+  CHECK(!client->GetBalances("tok").IsOk());
+  CHECK(server.balances.load() == 2);
+  server.broken = false;
+  CHECK(client->GetItem("tok").IsOk());
+  CHECK(server.items.load() == 2);
+  CHECK(client->GetBalances("tok").IsOk());
+  CHECK(server.balances.load() == 3);
+
+  // After the TTL the error is asked for again.
+  plaid::ItemErrorCacheOptions options;
+  options.ttl = std::chrono::milliseconds(100);
+  client->ItemErrors().SetOptions(options);
+  server.broken = true;
+  CHECK(!client->GetBalances("tok").IsOk());
+  CHECK(!client->GetBalances("tok").IsOk());
+  CHECK(server.balances.load() == 4);
+  std::this_thread::sleep_for(std::chrono::milliseconds(150));
+  CHECK(!client->GetBalances("tok").IsOk());
+  CHECK(server.balances.load() == 5);
+}
+
+} // namespace
+
+int main() {
+  TestCache();
+  TestClient();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,150 @@
+// An HTTP/1.1 server on 127.0.0.1 for tests to point a Client at. Each
+// connection is kept alive and served on its own thread, so a handler may
+// block (to hold a request in flight, say) without holding up the others;
+// it must return before the server is destroyed, though.
+
+#ifndef PLAID_TESTS_LOOPBACK_SERVER_H_
+#define PLAID_TESTS_LOOPBACK_SERVER_H_
+
+#include "check.h"
+
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace plaid_test {
+
+struct Reply {
+  int status = 200;
+  std::string body;
+};
+
+class LoopbackServer {
+public:
+  using Handler = std::function<Reply(const std::string &method,
+                                      const std::string &path,
+                                      const std::string &body)>;
+
+  explicit LoopbackServer(Handler handler) : handler_(std::move(handler)) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), len) != 0 ||
+        listen(listen_fd_, 128) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len) !=
+            0) {
+      perror("loopback server");
+      return;
+    }
+    port_ = ntohs(addr.sin_port);
+    accept_thread_ = std::thread(&LoopbackServer::Accept, this);
+  }
+
+  ~LoopbackServer() {
+    shutdown(listen_fd_, SHUT_RDWR);
+    if (accept_thread_.joinable())
+      accept_thread_.join();
+    std::lock_guard<std::mutex> lock(mu_);
+    for (int fd : conns_)
+      shutdown(fd, SHUT_RDWR);
+    for (auto &t : workers_)
+      t.join();
+    for (int fd : conns_)
+      close(fd);
+    close(listen_fd_);
+  }
+
+  LoopbackServer(const LoopbackServer &) = delete;
+  LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+  std::string Url() const {
+    return "http://127.0.0.1:" + std::to_string(port_) + "/";
+  }
+
+private:
+  void Accept() {
+    for (;;) {
+      int fd = accept(listen_fd_, nullptr, nullptr);
+      if (fd < 0)
+        return;
+      std::lock_guard<std::mutex> lock(mu_);
+      conns_.push_back(fd);
+      workers_.emplace_back(&LoopbackServer::Serve, this, fd);
+    }
+  }
+
+  void Serve(int fd) {
+    std::string in;
+    char buf[4096];
+    for (;;) {
+      size_t end;
+      while ((end = in.find("\r\n\r\n")) == std::string::npos) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+          return;
+        in.append(buf, static_cast<size_t>(n));
+      }
+      const std::string head = in.substr(0, end);
+      size_t length = 0;
+      for (const char *name : {"Content-Length: ", "content-length: "}) {
+        size_t at = head.find(name);
+        if (at != std::string::npos)
+          length = std::stoul(head.substr(at + strlen(name)));
+      }
+      if (head.find("100-continue") != std::string::npos) {
+        const char cont[] = "HTTP/1.1 100 Continue\r\n\r\n";
+        if (send(fd, cont, sizeof(cont) - 1, MSG_NOSIGNAL) < 0)
+          return;
+      }
+      while (in.size() < end + 4 + length) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0)
+          return;
+        in.append(buf, static_cast<size_t>(n));
+      }
+      const std::string body = in.substr(end + 4, length);
+      in.erase(0, end + 4 + length);
+
+      const size_t method_end = head.find(' ');
+      const size_t path_end = head.find(' ', method_end + 1);
+      const Reply reply =
+          handler_(head.substr(0, method_end),
+                   head.substr(method_end + 1, path_end - method_end - 1),
+                   body);
+      const std::string out = "HTTP/1.1 " + std::to_string(reply.status) +
+                              " Reply\r\n"
+                              "Content-Type: application/json\r\n"
+                              "Content-Length: " +
+                              std::to_string(reply.body.size()) + "\r\n\r\n" +
+                              reply.body;
+      // The client may have hung up on a request it no longer wants.
+      if (send(fd, out.data(), out.size(), MSG_NOSIGNAL) !=
+          static_cast<ssize_t>(out.size()))
+        return;
+    }
+  }
+
+  Handler handler_;
+  int listen_fd_ = -1;
+  int port_ = 0;
+  std::thread accept_thread_;
+  std::mutex mu_;
+  std::vector<int> conns_;
+  std::vector<std::thread> workers_;
+};
+
+} // namespace plaid_test
+
+#endif // PLAID_TESTS_LOOPBACK_SERVER_H_
\ No newline at end of file
@@ -0,0 +1,190 @@
+// Reads a PaymentStream against a loopback server: following next_cursor to
+// the end, starting from a cursor, stopping early on the predicate, reading
+// from a pool worker, and dropping or cancelling a page still in flight.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/payments.h"
+#include "plaid/thread_pool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <google/protobuf/util/json_util.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const int kPayments = 95;
+
+struct Server {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::string> cursors;
+  // Requests for this cursor wait until it is cleared.
+  std::string hold;
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    if (path != "/payment_initiation/payment/list") {
+      reply.status = 404;
+      return reply;
+    }
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    plaid::ListPaymentsRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cursors.push_back(req.cursor());
+      cv.notify_all();
+      cv.wait(lock, [&]() { return hold.empty() || hold != req.cursor(); });
+    }
+
+    const int start = req.cursor().empty() ? 0 : std::stoi(req.cursor());
+    const int end = std::min<int>(start + req.count(), kPayments);
+    plaid::ListPaymentsResponse resp;
+    resp.set_request_id("r");
+    for (int i = start; i < end; ++i)
+      resp.add_payments()->set_payment_id("pay_" + std::to_string(i));
+    if (end < kPayments)
+      resp.set_next_cursor(std::to_string(end));
+    google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    return reply;
+  }};
+
+  std::vector<std::string> Cursors() {
+    std::lock_guard<std::mutex> lock(mu);
+    return cursors;
+  }
+
+  void Reset(const std::string &held) {
+    std::lock_guard<std::mutex> lock(mu);
+    cursors.clear();
+    hold = held;
+    cv.notify_all();
+  }
+
+  void WaitFor(const std::string &cursor) {
+    std::unique_lock<std::mutex> lock(mu);
+    cv.wait(lock, [&]() {
+      return std::find(cursors.begin(), cursors.end(), cursor) !=
+             cursors.end();
+    });
+  }
+};
+
+plaid::ListPaymentsOptions Paged(int count, const std::string &cursor = "") {
+  plaid::ListPaymentsOptions options;
+  options.set_count(count);
+  options.set_cursor(cursor);
+  return options;
+}
+
+std::vector<std::string> ReadAll(plaid::PaymentStream &stream) {
+  std::vector<std::string> ids;
+  for (const plaid::Payment &payment : stream)
+    ids.push_back(payment.payment_id());
+  return ids;
+}
+
+std::vector<std::string> Range(int from, int to) {
+  std::vector<std::string> ids;
+  for (int i = from; i < to; ++i)
+    ids.push_back("pay_" + std::to_string(i));
+  return ids;
+}
+
+void TestFollowsCursor(Server &server, plaid::Client &client) {
+  server.Reset("");
+  plaid::PaymentStream stream(client, Paged(10));
+  CHECK(ReadAll(stream) == Range(0, kPayments));
+  CHECK(stream.GetStatus().IsOk());
+  const std::vector<std::string> expected = {"",   "10", "20", "30", "40",
+                                             "50", "60", "70", "80", "90"};
+  CHECK(server.Cursors() == expected);
+
+  server.Reset("");
+  plaid::PaymentStream from(client, Paged(20, "50"));
+  CHECK(ReadAll(from) == Range(50, kPayments));
+  CHECK(server.Cursors() == std::vector<std::string>({"50", "70", "90"}));
+}
+
+void TestStopsEarly(Server &server, plaid::Client &client) {
+  server.Reset("");
+  plaid::PaymentStream stream(
+      client, Paged(10), [](const plaid::Payment &payment) {
+        return payment.payment_id() == "pay_25";
+      });
+  CHECK(ReadAll(stream) == Range(0, 25));
+  CHECK(stream.GetStatus().IsOk());
+  // Nothing past the page holding the stopping payment is asked for.
+  CHECK(server.Cursors() == std::vector<std::string>({"", "10", "20"}));
+}
+
+void TestReadsOnPoolWorker(Server &server, plaid::Client &client) {
+  server.Reset("");
+  // Every page is parsed on the pool, so the worker reading the stream has
+  // to keep the pool going while it waits.
+  std::promise<std::vector<std::string>> result;
+  client.Pool().Submit([&]() {
+    plaid::PaymentStream stream(client, Paged(10));
+    result.set_value(ReadAll(stream));
+  });
+  CHECK(result.get_future().get() == Range(0, kPayments));
+}
+
+void TestDestructorCancelsPrefetch(Server &server, plaid::Client &client) {
+  server.Reset("10");
+  const auto start = std::chrono::steady_clock::now();
+  {
+    plaid::PaymentStream stream(client, Paged(10));
+    plaid::Payment payment;
+    CHECK(stream.Next(payment));
+    // The second page is on its way, and stuck there.
+    server.WaitFor("10");
+  }
+  CHECK(std::chrono::steady_clock::now() - start <
+        std::chrono::milliseconds(1000));
+  server.Reset("");
+}
+
+void TestCallerCancels(Server &server, plaid::Client &client) {
+  server.Reset("10");
+  plaid::CancellationToken cancel;
+  plaid::CallOptions call;
+  call.cancel = cancel;
+  plaid::PaymentStream stream(client, Paged(10), nullptr, call);
+  std::thread canceller([&]() {
+    server.WaitFor("10");
+    cancel.Cancel();
+  });
+  CHECK(ReadAll(stream) == Range(0, 10));
+  CHECK(stream.GetStatus().IsCancelled());
+  canceller.join();
+  server.Reset("");
+}
+
+} // namespace
+
+int main() {
+  Server server;
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  auto client = plaid::Client::Create(creds);
+  TestFollowsCursor(server, *client);
+  TestStopsEarly(server, *client);
+  TestReadsOnPoolWorker(server, *client);
+  TestDestructorCancelsPrefetch(server, *client);
+  TestCallerCancels(server, *client);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,387 @@
+// Runs a SyncScheduler against a loopback server: webhooks put their Items
+// at the front of the queue in arrival order, a sync that started before its
+// Item was removed and added again leaves the new Item alone, and Items that
+// keep coming back unchanged back off to max_interval. Then checks that a
+// BalancePoller's interval follows the average time between balance
+// changes, stays within its bounds, and drifts out while a token is quiet.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <google/protobuf/util/json_util.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Answers /transactions/get with the same transaction every time. Requests
+// for a held access token wait until it is released. Balances change on the
+// polls of an access token listed in balance_changes (counting from one).
+struct Server {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::string> requests;
+  std::vector<Clock::time_point> times;
+  std::map<std::string, int> in_flight;
+  std::map<std::string, int> max_in_flight;
+  std::set<std::string> held;
+  std::set<int> balance_changes;
+  std::map<std::string, int> balance_polls;
+  std::map<std::string, double> balances;
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    if (path == "/accounts/balance/get") {
+      plaid::GetBalancesRequest req;
+      CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+                .ok());
+      plaid::GetBalancesResponse resp;
+      resp.set_request_id("r");
+      plaid::Account *account = resp.add_accounts();
+      account->set_account_id("acc_1");
+      {
+        std::lock_guard<std::mutex> lock(mu);
+        const int n = ++balance_polls[req.access_token()];
+        if (balance_changes.count(n))
+          balances[req.access_token()] += 10;
+        account->mutable_balances()->set_current(balances[req.access_token()]);
+      }
+      google::protobuf::util::MessageToJsonString(resp, &reply.body);
+      return reply;
+    }
+    if (path != "/transactions/get") {
+      reply.status = 404;
+      return reply;
+    }
+    plaid::GetTransactionsRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    const std::string &token = req.access_token();
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      requests.push_back(token);
+      times.push_back(Clock::now());
+      const int now = ++in_flight[token];
+      max_in_flight[token] = std::max(max_in_flight[token], now);
+      cv.notify_all();
+      cv.wait(lock, [&]() { return held.count(token) == 0; });
+      --in_flight[token];
+    }
+    plaid::GetTransactionsResponse resp;
+    resp.set_request_id("r");
+    resp.set_total_transactions(1);
+    plaid::Transaction *tx = resp.add_transactions();
+    tx->set_transaction_id("tx_1");
+    tx->set_amount(12.5);
+    tx->set_date("2026-10-01");
+    google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    return reply;
+  }};
+
+  void Reset() {
+    std::lock_guard<std::mutex> lock(mu);
+    requests.clear();
+    times.clear();
+    max_in_flight.clear();
+  }
+
+  void Hold(const std::string &token) {
+    std::lock_guard<std::mutex> lock(mu);
+    held.insert(token);
+  }
+
+  void Release(const std::string &token) {
+    std::lock_guard<std::mutex> lock(mu);
+    held.erase(token);
+    cv.notify_all();
+  }
+
+  void WaitFor(size_t n) {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(5),
+                      [&]() { return requests.size() >= n; }));
+  }
+
+  std::vector<std::string> Requests() {
+    std::lock_guard<std::mutex> lock(mu);
+    return requests;
+  }
+
+  int Count(const std::string &token) {
+    std::lock_guard<std::mutex> lock(mu);
+    return static_cast<int>(
+        std::count(requests.begin(), requests.end(), token));
+  }
+
+  int MaxInFlight(const std::string &token) {
+    std::lock_guard<std::mutex> lock(mu);
+    return max_in_flight[token];
+  }
+};
+
+// Collects what the scheduler's handler is given.
+struct Results {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<plaid::SyncResult> results;
+
+  plaid::SyncScheduler::Handler Handler() {
+    return [this](const plaid::SyncResult &result) {
+      std::lock_guard<std::mutex> lock(mu);
+      results.push_back(result);
+      cv.notify_all();
+    };
+  }
+
+  // The first n results, once there are that many.
+  std::vector<plaid::SyncResult> WaitFor(size_t n) {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(10),
+                      [&]() { return results.size() >= n; }));
+    return std::vector<plaid::SyncResult>(results.begin(),
+                                          results.begin() + n);
+  }
+};
+
+plaid::Webhook TransactionsWebhook(const std::string &item_id,
+                                   const std::string &code = "DEFAULT_UPDATE") {
+  plaid::Webhook webhook;
+  webhook.set_webhook_type("TRANSACTIONS");
+  webhook.set_webhook_code(code);
+  webhook.set_item_id(item_id);
+  return webhook;
+}
+
+plaid::SyncSchedulerOptions Options() {
+  plaid::SyncSchedulerOptions options;
+  options.balances = false;
+  options.min_interval = std::chrono::hours(1);
+  options.max_in_flight = 1;
+  return options;
+}
+
+void TestWebhooksGoFirst(Server &server, plaid::Client &client) {
+  server.Reset();
+  Results results;
+  plaid::SyncScheduler scheduler(client, results.Handler(), Options());
+  for (const char *item : {"a", "b", "c", "d"})
+    scheduler.Add(item, std::string("tok-") + item);
+  scheduler.Start();
+  results.WaitFor(4);
+  server.Reset();
+
+  // b's sync holds up the only slot while the other webhooks arrive.
+  server.Hold("tok-b");
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("b")));
+  server.WaitFor(1);
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("c", "HISTORICAL_UPDATE")));
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("a")));
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("d", "TRANSACTIONS_REMOVED")));
+  // One for the Item being synced queues it again behind the others.
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("b")));
+  // Webhooks that don't change transactions, or are for unknown Items, are
+  // ignored.
+  plaid::Webhook item_error = TransactionsWebhook("a", "ERROR");
+  item_error.set_webhook_type("ITEM");
+  CHECK(!scheduler.OnWebhook(item_error));
+  CHECK(!scheduler.OnWebhook(TransactionsWebhook("zzz")));
+  server.Release("tok-b");
+
+  const std::vector<plaid::SyncResult> all = results.WaitFor(9);
+  const std::vector<std::string> expected = {"tok-b", "tok-c", "tok-a",
+                                             "tok-d", "tok-b"};
+  CHECK(server.Requests() == expected);
+  for (size_t i = 4; i < all.size(); ++i)
+    CHECK(all[i].from_webhook);
+  scheduler.Stop();
+  CHECK(scheduler.Metrics().syncs == 9);
+  CHECK(scheduler.Metrics().webhook_syncs == 5);
+}
+
+void TestRemoveAndAddDuringSync(Server &server, plaid::Client &client) {
+  server.Reset();
+  Results results;
+  plaid::SyncSchedulerOptions options = Options();
+  options.max_in_flight = 2;
+  plaid::SyncScheduler scheduler(client, results.Handler(), options);
+  server.Hold("tok-1");
+  server.Hold("tok-2");
+  scheduler.Add("item", "tok-1");
+  scheduler.Start();
+  server.WaitFor(1);
+
+  // The Item is replaced while its sync is out, and the new one's first sync
+  // starts alongside.
+  scheduler.Remove("item");
+  scheduler.Add("item", "tok-2");
+  server.WaitFor(2);
+  server.Release("tok-1");
+  CHECK(results.WaitFor(1)[0].access_token == "tok-1");
+
+  // The old sync ending must not have marked the new Item idle: a webhook
+  // now waits for the new sync rather than starting a second one.
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("item")));
+  std::this_thread::sleep_for(std::chrono::milliseconds(300));
+  CHECK(server.Count("tok-2") == 1);
+  server.Release("tok-2");
+
+  const std::vector<plaid::SyncResult> all = results.WaitFor(3);
+  CHECK(all[1].access_token == "tok-2" && !all[1].from_webhook);
+  CHECK(all[2].access_token == "tok-2" && all[2].from_webhook);
+  CHECK(server.MaxInFlight("tok-2") == 1);
+  scheduler.Stop();
+}
+
+void TestBacksOff(Server &server, plaid::Client &client) {
+  server.Reset();
+  Results results;
+  plaid::SyncSchedulerOptions options = Options();
+  options.min_interval = std::chrono::seconds(1);
+  options.max_interval = std::chrono::seconds(2);
+  options.backoff = 3;
+  plaid::SyncScheduler scheduler(client, results.Handler(), options);
+  scheduler.Add("item", "tok");
+  scheduler.Start();
+
+  // The first sync is a change; the ones after it aren't, and each backs
+  // off, stopping at max_interval.
+  CHECK(results.WaitFor(1)[0].changed);
+  CHECK(scheduler.Interval("item") == std::chrono::seconds(1));
+  CHECK(!results.WaitFor(2)[1].changed);
+  CHECK(scheduler.Interval("item") == std::chrono::seconds(2));
+  CHECK(!results.WaitFor(3)[2].changed);
+  CHECK(scheduler.Interval("item") == std::chrono::seconds(2));
+  {
+    std::lock_guard<std::mutex> lock(server.mu);
+    CHECK(server.times[1] - server.times[0] >= std::chrono::milliseconds(900));
+    CHECK(server.times[2] - server.times[1] >=
+          std::chrono::milliseconds(1900));
+  }
+
+  // A webhook starts the Item over at min_interval, changed or not.
+  CHECK(scheduler.OnWebhook(TransactionsWebhook("item")));
+  const plaid::SyncResult fourth = results.WaitFor(4)[3];
+  CHECK(fourth.from_webhook && !fourth.changed);
+  CHECK(scheduler.Interval("item") == std::chrono::seconds(1));
+  CHECK(scheduler.Interval("unknown") == std::chrono::seconds(0));
+  scheduler.Stop();
+  CHECK(scheduler.Metrics().unchanged == 3);
+}
+
+// Collects what a BalancePoller's handler is given.
+struct Updates {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<plaid::BalanceUpdate> updates;
+
+  plaid::BalancePoller::Handler Handler() {
+    return [this](const plaid::BalanceUpdate &update) {
+      std::lock_guard<std::mutex> lock(mu);
+      updates.push_back(update);
+      cv.notify_all();
+    };
+  }
+
+  void WaitFor(size_t n) {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(10),
+                      [&]() { return updates.size() >= n; }));
+  }
+};
+
+void TestPollIntervalBounds(plaid::Client &client) {
+  // A token that's expected to change rarely is polled at max_interval...
+  plaid::BalancePollerOptions options;
+  options.initial_interval = std::chrono::seconds(10);
+  options.max_interval = std::chrono::seconds(3);
+  options.fraction = 1;
+  Updates slow_updates;
+  plaid::BalancePoller slow(client, slow_updates.Handler(), options);
+  slow.Add("tok-slow");
+  CHECK(slow.Interval("tok-slow") == std::chrono::seconds(0));
+  slow.Start();
+  slow_updates.WaitFor(1);
+  CHECK(slow.Interval("tok-slow") == std::chrono::seconds(3));
+  slow.Stop();
+
+  // ... and one expected to change often at min_interval.
+  options = plaid::BalancePollerOptions();
+  options.initial_interval = std::chrono::seconds(1);
+  options.min_interval = std::chrono::seconds(2);
+  options.fraction = 0.5;
+  Updates fast_updates;
+  plaid::BalancePoller fast(client, fast_updates.Handler(), options);
+  fast.Add("tok-fast");
+  fast.Start();
+  fast_updates.WaitFor(1);
+  CHECK(fast.Interval("tok-fast") == std::chrono::seconds(2));
+  CHECK(fast.Interval("unknown") == std::chrono::seconds(0));
+  fast.Stop();
+}
+
+void TestPollIntervalFollowsChanges(Server &server, plaid::Client &client) {
+  {
+    std::lock_guard<std::mutex> lock(server.mu);
+    server.balance_changes = {2, 4};
+  }
+  plaid::BalancePollerOptions options;
+  options.alpha = 0.5;
+  options.fraction = 1;
+  options.initial_interval = std::chrono::seconds(2);
+  options.min_interval = std::chrono::seconds(1);
+  options.max_interval = std::chrono::seconds(100);
+  Updates updates;
+  plaid::BalancePoller poller(client, updates.Handler(), options);
+  poller.Add("tok-ewma");
+  poller.Start();
+
+  // Polls at 0s and 2s follow initial_interval; the change seen at 2s makes
+  // the average 2s. The change at 6s comes 4s after it, which averages to
+  // 3s. Nothing changes after that, so once the token has been quiet for
+  // longer than the average (6s by 12s) the interval follows the quiet.
+  const int expected[] = {2, 2, 2, 3, 3, 6};
+  for (size_t i = 0; i < 6; ++i) {
+    updates.WaitFor(i + 1);
+    CHECK(poller.Interval("tok-ewma") == std::chrono::seconds(expected[i]));
+  }
+  poller.Stop();
+  CHECK(!updates.updates[0].changed);
+  CHECK(updates.updates[1].changed);
+  CHECK(!updates.updates[2].changed);
+  CHECK(updates.updates[3].changed);
+  const plaid::BalancePollMetrics m = poller.Metrics();
+  CHECK(m.polls == 6);
+  CHECK(m.changes == 2);
+  CHECK(m.failed == 0);
+}
+
+} // namespace
+
+int main() {
+  Server server;
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  auto client = plaid::Client::Create(creds);
+  TestWebhooksGoFirst(server, *client);
+  TestRemoveAndAddDuringSync(server, *client);
+  TestBacksOff(server, *client);
+  TestPollIntervalBounds(*client);
+  TestPollIntervalFollowsChanges(server, *client);
+  return 0;
+}
\ No newline at end of file
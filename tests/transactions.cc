@@ -0,0 +1,136 @@
+// Reads a long transaction history with GetAllTransactions from a loopback
+// server: after the probe the range is split into date windows, some of
+// which hold more than a page, and the merged result must list every
+// transaction exactly once, newest first.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <google/protobuf/util/json_util.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+const int kTransactions = 3000;
+const int kDays = 180;
+
+// The date day days after 2026-01-01.
+std::string Date(int day) {
+  const time_t t = 1767225600 + static_cast<time_t>(day) * 24 * 60 * 60;
+  struct tm tm;
+  gmtime_r(&t, &tm);
+  char buf[16];
+  strftime(buf, sizeof(buf), "%Y-%m-%d", &tm);
+  return buf;
+}
+
+struct Server {
+  // (date, transaction_id), newest first, as the API orders them.
+  std::vector<std::pair<std::string, std::string>> history;
+  std::atomic<int> requests{0};
+  std::atomic<int> deep_pages{0};
+
+  Server() {
+    // Spread unevenly: a third of them land on one busy day, so the window
+    // holding it takes several pages.
+    for (int i = 0; i < kTransactions; ++i) {
+      const int day = i < kTransactions / 3 ? 40 : i % kDays;
+      history.emplace_back(Date(day), "tx_" + std::to_string(i));
+    }
+    std::sort(history.begin(), history.end(),
+              [](const std::pair<std::string, std::string> &a,
+                 const std::pair<std::string, std::string> &b) {
+                return a.first != b.first ? a.first > b.first
+                                          : a.second < b.second;
+              });
+  }
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    if (path != "/transactions/get") {
+      reply.status = 404;
+      return reply;
+    }
+    ++requests;
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    plaid::GetTransactionsRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    if (req.options().offset() > 0)
+      ++deep_pages;
+    plaid::GetTransactionsResponse resp;
+    resp.set_request_id("r");
+    int64_t matched = 0;
+    for (const auto &tx : history) {
+      if (tx.first < req.start_date() || tx.first > req.end_date())
+        continue;
+      if (matched >= req.options().offset() &&
+          matched < req.options().offset() + req.options().count()) {
+        plaid::Transaction *out = resp.add_transactions();
+        out->set_transaction_id(tx.second);
+        out->set_date(tx.first);
+        out->set_amount(1);
+      }
+      ++matched;
+    }
+    resp.set_total_transactions(matched);
+    google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    return reply;
+  }};
+};
+
+} // namespace
+
+int main() {
+  Server server;
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  auto client = plaid::Client::Create(creds);
+
+  plaid::GetTransactionsOptions options;
+  options.set_start_date(Date(0));
+  options.set_end_date(Date(kDays - 1));
+  options.set_count(100);
+  auto res = client->GetAllTransactions("access-sandbox", options);
+  CHECK(res.IsOk());
+  const plaid::GetTransactionsResponse all = res.Take();
+  CHECK(all.total_transactions() == kTransactions);
+  CHECK(all.transactions_size() == kTransactions);
+
+  std::set<std::string> ids;
+  for (int i = 0; i < all.transactions_size(); ++i) {
+    const plaid::Transaction &tx = all.transactions(i);
+    CHECK(ids.insert(tx.transaction_id()).second);
+    if (i > 0)
+      CHECK(tx.date() <= all.transactions(i - 1).date());
+  }
+  for (int i = 0; i < kTransactions; ++i)
+    CHECK(ids.count("tx_" + std::to_string(i)));
+
+  // The probe and about one request per window, plus the extra pages of the
+  // busy day's window.
+  CHECK(server.deep_pages.load() > 0);
+  CHECK(server.requests.load() < 2 * kTransactions / 100);
+
+  // A range the probe covers on its own takes no more requests.
+  server.requests = 0;
+  options.set_start_date(Date(100));
+  options.set_end_date(Date(101));
+  auto small = client->GetAllTransactions("access-sandbox", options);
+  CHECK(small.IsOk());
+  CHECK(small.Get().transactions_size() ==
+        small.Get().total_transactions());
+  CHECK(server.requests.load() == 1);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,226 @@
+// Pins a client's concurrency limit to one and queues calls behind a call
+// the loopback server holds, then lets them through one at a time to see
+// the order the EventLoop's wait queue serves them in: classes in
+// proportion to their weights (64, 8 and 1), tenants within a class taking
+// turns, and calls whose deadline passes while they wait failing without
+// ever being sent.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <google/protobuf/util/json_util.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Answers /institutions/get_by_id, recording the ids asked for in order.
+// The call for "hold" waits until it is released.
+struct Server {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::string> served;
+  bool holding = false;
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    if (path != "/institutions/get_by_id") {
+      reply.status = 404;
+      return reply;
+    }
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    plaid::GetInstitutionByIDRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    std::unique_lock<std::mutex> lock(mu);
+    if (req.institution_id() == "hold") {
+      holding = true;
+      cv.notify_all();
+      cv.wait(lock, [this]() { return !holding; });
+    } else {
+      served.push_back(req.institution_id());
+    }
+    reply.body = "{\"request_id\":\"r\"}";
+    return reply;
+  }};
+
+  // Waits for the held call, and forgets what was served before it.
+  void WaitForHold() {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(5),
+                      [this]() { return holding; }));
+    served.clear();
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mu);
+    holding = false;
+    cv.notify_all();
+  }
+
+  std::vector<std::string> Served() {
+    std::lock_guard<std::mutex> lock(mu);
+    return served;
+  }
+};
+
+// Counts calls down to zero.
+struct Pending {
+  std::mutex mu;
+  std::condition_variable cv;
+  int left = 0;
+
+  void Done() {
+    std::lock_guard<std::mutex> lock(mu);
+    --left;
+    cv.notify_all();
+  }
+
+  void Wait() {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(10),
+                      [this]() { return left == 0; }));
+  }
+};
+
+class Fixture {
+public:
+  Fixture() {
+    plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                             "public-key", "secret");
+    creds.url = server_.http.Url();
+    client_ = plaid::Client::Create(creds);
+    plaid::ConcurrencyLimitOptions options;
+    options.initial_limit = 1;
+    options.min_limit = 1;
+    options.max_limit = 1;
+    client_->Concurrency().SetOptions(options);
+    // The new bounds apply from the next completion.
+    CHECK(client_->GetInstitutionByID("warmup").IsOk());
+    CHECK(client_->Concurrency().Limit() == 1);
+  }
+
+  // Takes the only slot until Drain.
+  void Hold() {
+    Queue("hold", plaid::CallOptions());
+    server_.WaitForHold();
+  }
+
+  void Queue(const std::string &id, const plaid::CallOptions &call,
+             bool expect_ok = true) {
+    {
+      std::lock_guard<std::mutex> lock(pending_.mu);
+      ++pending_.left;
+    }
+    client_->GetInstitutionByIDAsync(
+        id,
+        [this, expect_ok](
+            plaid::StatusWrapped<plaid::GetInstitutionByIDResponse> res) {
+          if (expect_ok)
+            CHECK(res.IsOk());
+          else
+            CHECK(res.GetStatus().IsLocalTimeout());
+          pending_.Done();
+        },
+        call);
+  }
+
+  // Lets the held call finish once the queued ones are all in, and returns
+  // the order the server saw them in.
+  std::vector<std::string> Drain() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    server_.Release();
+    pending_.Wait();
+    return server_.Served();
+  }
+
+  Pending &pending() { return pending_; }
+
+private:
+  Server server_;
+  std::unique_ptr<plaid::Client> client_;
+  Pending pending_;
+};
+
+plaid::CallOptions As(plaid::Priority priority, const std::string &tenant) {
+  return plaid::CallOptions().WithPriority(priority).WithTenant(tenant);
+}
+
+std::vector<std::string> Names(const std::string &prefix, int n) {
+  std::vector<std::string> names;
+  for (int i = 0; i < n; ++i)
+    names.push_back(prefix + std::to_string(i));
+  return names;
+}
+
+void TestClassesByWeight() {
+  Fixture f;
+  f.Hold();
+  // Batch first, so that arrival order doesn't explain the result.
+  for (const std::string &id : Names("B", 3))
+    f.Queue(id, As(plaid::Priority::kBatch, "batch"));
+  for (const std::string &id : Names("N", 12))
+    f.Queue(id, As(plaid::Priority::kNormal, "normal"));
+  for (const std::string &id : Names("I", 3))
+    f.Queue(id, As(plaid::Priority::kInteractive, "interactive"));
+
+  // Each class's calls are 1/64, 1/8 and 1 apart in virtual time, so the
+  // first of each goes in class order, then the interactive ones, then
+  // eight normal calls to every batch one.
+  const std::vector<std::string> expected = {
+      "I0", "N0", "B0", "I1", "I2", "N1",  "N2",  "N3",  "N4",
+      "N5", "N6", "N7", "N8", "B1", "N9", "N10", "N11", "B2"};
+  CHECK(f.Drain() == expected);
+}
+
+void TestTenantsTakeTurns() {
+  Fixture f;
+  f.Hold();
+  for (const std::string &id : Names("A", 6))
+    f.Queue(id, As(plaid::Priority::kNormal, "tenant-a"));
+  for (const std::string &id : Names("B", 2))
+    f.Queue(id, As(plaid::Priority::kNormal, "tenant-b"));
+
+  // B's calls don't wait behind A's whole backlog.
+  const std::vector<std::string> expected = {"A0", "B0", "A1", "B1",
+                                             "A2", "A3", "A4", "A5"};
+  CHECK(f.Drain() == expected);
+}
+
+void TestWaitingCallsExpire() {
+  Fixture f;
+  f.Hold();
+  const auto start = std::chrono::steady_clock::now();
+  for (const std::string &id : Names("X", 3))
+    f.Queue(id, plaid::CallOptions().WithTimeout(std::chrono::milliseconds(50)),
+            false);
+  f.Queue("kept", plaid::CallOptions());
+
+  // The expired calls fail while the slot is still held.
+  {
+    Pending &pending = f.pending();
+    std::unique_lock<std::mutex> lock(pending.mu);
+    CHECK(pending.cv.wait_for(lock, std::chrono::seconds(2),
+                              [&]() { return pending.left == 2; }));
+  }
+  CHECK(std::chrono::steady_clock::now() - start <
+        std::chrono::milliseconds(1000));
+  CHECK(f.Drain() == std::vector<std::string>({"kept"}));
+}
+
+} // namespace
+
+int main() {
+  TestClassesByWeight();
+  TestTenantsTakeTurns();
+  TestWaitingCallsExpire();
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,280 @@
+// Verifies webhooks signed with a throwaway P-256 key that a loopback server
+// hands out by key id: a good token passes, a bad signature, a body that
+// doesn't match its hash and an old token are refused, two threads missing
+// the same key share one fetch, a key id that doesn't resolve isn't asked
+// for again until miss_ttl passes, and the key cache stays within max_keys.
+
+#include "loopback_server.h"
+#include "plaid/client.h"
+#include "plaid/webhooks.h"
+
+#include <openssl/bn.h>
+#include <openssl/core_names.h>
+#include <openssl/ecdsa.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+
+#include <chrono>
+#include <ctime>
+#include <google/protobuf/util/json_util.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace {
+
+const char kBadKeyId[] =
+    "{\"request_id\":\"r\",\"error_type\":\"INVALID_INPUT\","
+    "\"error_code\":\"INVALID_WEBHOOK_VERIFICATION_KEY_ID\","
+    "\"error_message\":\"no such key\"}";
+
+std::string Base64Url(const unsigned char *data, size_t len) {
+  static const char kAlphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+  std::string out;
+  uint32_t bits = 0;
+  int count = 0;
+  for (size_t i = 0; i < len; ++i) {
+    bits = (bits << 8) | data[i];
+    count += 8;
+    while (count >= 6) {
+      count -= 6;
+      out += kAlphabet[(bits >> count) & 0x3f];
+    }
+  }
+  if (count > 0)
+    out += kAlphabet[(bits << (6 - count)) & 0x3f];
+  return out;
+}
+
+std::string Base64Url(const std::string &data) {
+  return Base64Url(reinterpret_cast<const unsigned char *>(data.data()),
+                   data.size());
+}
+
+std::string Sha256Hex(const std::string &body) {
+  unsigned char digest[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(body.data()), body.size(),
+         digest);
+  static const char kHex[] = "0123456789abcdef";
+  std::string hex;
+  for (unsigned char b : digest) {
+    hex += kHex[b >> 4];
+    hex += kHex[b & 0xf];
+  }
+  return hex;
+}
+
+// The signing half of the key the server hands out.
+class Signer {
+public:
+  Signer() {
+    pkey_ = EVP_PKEY_Q_keygen(nullptr, nullptr, "EC", "P-256");
+    CHECK(pkey_);
+    unsigned char point[65];
+    size_t len = 0;
+    CHECK(EVP_PKEY_get_octet_string_param(pkey_, OSSL_PKEY_PARAM_PUB_KEY,
+                                          point, sizeof(point), &len) == 1);
+    CHECK(len == 65 && point[0] == 0x04);
+    x_ = Base64Url(point + 1, 32);
+    y_ = Base64Url(point + 33, 32);
+  }
+  ~Signer() { EVP_PKEY_free(pkey_); }
+
+  plaid::WebhookVerificationKey Jwk(const std::string &kid) const {
+    plaid::WebhookVerificationKey jwk;
+    jwk.set_alg("ES256");
+    jwk.set_crv("P-256");
+    jwk.set_kid(kid);
+    jwk.set_kty("EC");
+    jwk.set_use("sig");
+    jwk.set_x(x_);
+    jwk.set_y(y_);
+    jwk.set_created_at(static_cast<int64_t>(time(nullptr)));
+    return jwk;
+  }
+
+  // A Plaid-Verification token for body, issued age_seconds ago.
+  std::string Token(const std::string &kid, const std::string &body,
+                    int64_t age_seconds = 0) const {
+    const std::string header =
+        "{\"alg\":\"ES256\",\"kid\":\"" + kid + "\",\"typ\":\"JWT\"}";
+    const std::string payload =
+        "{\"iat\":" +
+        std::to_string(static_cast<int64_t>(time(nullptr)) - age_seconds) +
+        ",\"request_body_sha256\":\"" + Sha256Hex(body) + "\"}";
+    const std::string signed_part =
+        Base64Url(header) + "." + Base64Url(payload);
+    return signed_part + "." + Sign(signed_part);
+  }
+
+private:
+  // The JWS form of an ECDSA signature: r and s, 32 bytes each.
+  std::string Sign(const std::string &data) const {
+    EVP_MD_CTX *md = EVP_MD_CTX_new();
+    unsigned char der[80];
+    size_t der_len = sizeof(der);
+    CHECK(EVP_DigestSignInit(md, nullptr, EVP_sha256(), nullptr, pkey_) == 1);
+    CHECK(EVP_DigestSign(md, der, &der_len,
+                         reinterpret_cast<const unsigned char *>(data.data()),
+                         data.size()) == 1);
+    EVP_MD_CTX_free(md);
+    const unsigned char *p = der;
+    ECDSA_SIG *sig = d2i_ECDSA_SIG(nullptr, &p, static_cast<long>(der_len));
+    CHECK(sig);
+    const BIGNUM *r;
+    const BIGNUM *s;
+    ECDSA_SIG_get0(sig, &r, &s);
+    unsigned char raw[64];
+    CHECK(BN_bn2binpad(r, raw, 32) == 32);
+    CHECK(BN_bn2binpad(s, raw + 32, 32) == 32);
+    ECDSA_SIG_free(sig);
+    return Base64Url(raw, sizeof(raw));
+  }
+
+  EVP_PKEY *pkey_;
+  std::string x_;
+  std::string y_;
+};
+
+// Serves the signer's key for any key id starting with "k", slowly enough
+// for concurrent lookups to overlap, and counts fetches per key id.
+struct Server {
+  const Signer &signer;
+  std::mutex mu;
+  std::map<std::string, int> fetches;
+
+  explicit Server(const Signer &signer) : signer(signer) {}
+
+  plaid_test::LoopbackServer http{[this](const std::string &,
+                                         const std::string &path,
+                                         const std::string &body) {
+    plaid_test::Reply reply;
+    if (path != "/webhook_verification_key/get") {
+      reply.status = 404;
+      return reply;
+    }
+    google::protobuf::util::JsonParseOptions options;
+    options.ignore_unknown_fields = true;
+    plaid::GetWebhookVerificationKeyRequest req;
+    CHECK(google::protobuf::util::JsonStringToMessage(body, &req, options)
+              .ok());
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      ++fetches[req.key_id()];
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    if (req.key_id().compare(0, 1, "k") != 0) {
+      reply.status = 400;
+      reply.body = kBadKeyId;
+      return reply;
+    }
+    plaid::GetWebhookVerificationKeyResponse resp;
+    resp.set_request_id("r");
+    *resp.mutable_key() = signer.Jwk(req.key_id());
+    google::protobuf::util::MessageToJsonString(resp, &reply.body);
+    return reply;
+  }};
+
+  int Fetches(const std::string &kid) {
+    std::lock_guard<std::mutex> lock(mu);
+    return fetches[kid];
+  }
+};
+
+const char kBody[] = "{\"webhook_type\":\"TRANSACTIONS\","
+                     "\"webhook_code\":\"DEFAULT_UPDATE\"}";
+
+void TestConcurrentMissesShareFetch(Server &server, const Signer &signer,
+                                    plaid::WebhookVerifier &verifier) {
+  const std::string token = signer.Token("k1", kBody);
+  plaid::Status first = plaid::Status::OK();
+  plaid::Status second = plaid::Status::OK();
+  std::thread a([&]() { first = verifier.Verify(kBody, token); });
+  std::thread b([&]() { second = verifier.Verify(kBody, token); });
+  a.join();
+  b.join();
+  CHECK(first.IsOk());
+  CHECK(second.IsOk());
+  CHECK(server.Fetches("k1") == 1);
+}
+
+void TestTokens(Server &server, const Signer &signer,
+                plaid::WebhookVerifier &verifier) {
+  // The key is cached now, so none of these fetch it again.
+  CHECK(verifier.Verify(kBody, signer.Token("k1", kBody)).IsOk());
+
+  // Another token's signature over this token's header and payload.
+  const std::string token = signer.Token("k1", kBody);
+  const std::string other = signer.Token("k1", "{}");
+  const std::string forged = token.substr(0, token.rfind('.')) +
+                             other.substr(other.rfind('.'));
+  CHECK(verifier.Verify(kBody, forged).IsVerificationError());
+
+  // A valid token, but for a different body.
+  CHECK(verifier.Verify("{}", token).IsVerificationError());
+
+  // Signed properly, but ten minutes ago.
+  CHECK(verifier.Verify(kBody, signer.Token("k1", kBody, 600))
+            .IsVerificationError());
+  CHECK(verifier.Verify(kBody, signer.Token("k1", kBody, 60)).IsOk());
+  CHECK(server.Fetches("k1") == 1);
+}
+
+void TestUnknownKeyIdIsRemembered(Server &server, const Signer &signer,
+                                  plaid::WebhookVerifier &verifier) {
+  const std::string token = signer.Token("nope", kBody);
+  for (int i = 0; i < 5; ++i)
+    CHECK(!verifier.Verify(kBody, token).IsOk());
+  CHECK(server.Fetches("nope") == 1);
+  // Once miss_ttl has passed it is asked for again.
+  std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+  CHECK(!verifier.Verify(kBody, token).IsOk());
+  CHECK(server.Fetches("nope") == 2);
+}
+
+void TestKeysAreBounded(Server &server, const Signer &signer,
+                        plaid::Client &client) {
+  plaid::WebhookVerifierOptions options;
+  options.max_keys = 2;
+  plaid::WebhookVerifier verifier(client, options);
+  auto verify = [&](const std::string &kid) {
+    return verifier.Verify(kBody, signer.Token(kid, kBody));
+  };
+
+  // A key id that didn't resolve is forgotten before any key is.
+  CHECK(verify("ka").IsOk());
+  CHECK(!verify("bad").IsOk());
+  CHECK(verify("kb").IsOk());
+  CHECK(verify("ka").IsOk());
+  CHECK(server.Fetches("ka") == 1);
+
+  // With only keys left, the one fetched longest ago goes.
+  CHECK(verify("kc").IsOk());
+  CHECK(verify("kb").IsOk());
+  CHECK(server.Fetches("kb") == 1);
+  CHECK(verify("ka").IsOk());
+  CHECK(server.Fetches("ka") == 2);
+}
+
+} // namespace
+
+int main() {
+  Signer signer;
+  Server server(signer);
+  plaid::Credentials creds(plaid::Enviroment::Sandbox, "client-id",
+                           "public-key", "secret");
+  creds.url = server.http.Url();
+  auto client = plaid::Client::Create(creds);
+
+  plaid::WebhookVerifierOptions options;
+  options.miss_ttl = std::chrono::seconds(1);
+  plaid::WebhookVerifier verifier(*client, options);
+  TestConcurrentMissesShareFetch(server, signer, verifier);
+  TestTokens(server, signer, verifier);
+  TestUnknownKeyIdIsRemembered(server, signer, verifier);
+  TestKeysAreBounded(server, signer, *client);
+  return 0;
+}
\ No newline at end of file
@@ -0,0 +1,281 @@
+// Talks raw HTTP to a WebhookServer on a loopback port: pipelined
+// keep-alive posts reach the handlers in order, malformed and oversized
+// requests get their 4xx, a full queue answers 503, and Stop hands over
+// everything already accepted before it returns.
+
+#include "check.h"
+#include "plaid/webhooks.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <netinet/in.h>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+// One client connection, read response by response.
+class Connection {
+public:
+  explicit Connection(uint16_t port) {
+    fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    CHECK(connect(fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ==
+          0);
+    timeval timeout = {5, 0};
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+  }
+  ~Connection() { close(fd_); }
+
+  void Send(const std::string &data) {
+    CHECK(send(fd_, data.data(), data.size(), MSG_NOSIGNAL) ==
+          static_cast<ssize_t>(data.size()));
+  }
+
+  // The status code of the next response, or 0 if the server hung up.
+  int Status() {
+    size_t end;
+    while ((end = in_.find("\r\n\r\n")) == std::string::npos) {
+      char buf[4096];
+      ssize_t n = read(fd_, buf, sizeof(buf));
+      if (n <= 0)
+        return 0;
+      in_.append(buf, static_cast<size_t>(n));
+    }
+    // Every response the server sends has an empty body.
+    CHECK(in_.compare(0, 9, "HTTP/1.1 ") == 0);
+    const int status = std::stoi(in_.substr(9, 3));
+    in_.erase(0, end + 4);
+    return status;
+  }
+
+  // Whether the server has closed the connection. A close with some of the
+  // request still unread comes through as a reset.
+  bool Closed() {
+    char c;
+    const ssize_t n = read(fd_, &c, 1);
+    return n == 0 || (n < 0 && errno == ECONNRESET);
+  }
+
+private:
+  int fd_;
+  std::string in_;
+};
+
+std::string Post(const std::string &body,
+                 const std::string &path = "/hooks") {
+  return "POST " + path + " HTTP/1.1\r\nHost: localhost\r\nContent-Length: " +
+         std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+std::string Webhook(const std::string &type, int i) {
+  return "{\"webhook_type\":\"" + type +
+         "\",\"webhook_code\":\"DEFAULT_UPDATE\",\"item_id\":\"item_" +
+         std::to_string(i) + "\"}";
+}
+
+// Collects what the handlers see. While hold is set, the first handler call
+// waits until it is cleared.
+struct Received {
+  std::mutex mu;
+  std::condition_variable cv;
+  std::vector<std::string> items;
+  std::vector<std::string> any;
+  bool hold = false;
+
+  void Typed(const plaid::WebhookEvent &event) {
+    std::unique_lock<std::mutex> lock(mu);
+    items.push_back(event.webhook.item_id());
+    cv.notify_all();
+    cv.wait(lock, [this]() { return !hold; });
+  }
+
+  void Any(const plaid::WebhookEvent &event) {
+    std::lock_guard<std::mutex> lock(mu);
+    any.push_back(event.webhook.webhook_type() + "/" +
+                  event.webhook.item_id());
+    cv.notify_all();
+  }
+
+  void WaitFor(size_t n) {
+    std::unique_lock<std::mutex> lock(mu);
+    CHECK(cv.wait_for(lock, std::chrono::seconds(5),
+                      [&]() { return items.size() >= n; }));
+  }
+
+  void Release() {
+    std::lock_guard<std::mutex> lock(mu);
+    hold = false;
+    cv.notify_all();
+  }
+};
+
+std::vector<std::string> Items(int from, int to) {
+  std::vector<std::string> ids;
+  for (int i = from; i < to; ++i)
+    ids.push_back("item_" + std::to_string(i));
+  return ids;
+}
+
+plaid::WebhookServerOptions Options() {
+  plaid::WebhookServerOptions options;
+  options.address = "127.0.0.1";
+  options.path = "/hooks";
+  options.max_body_size = 1024;
+  return options;
+}
+
+void TestPipelinedInOrder() {
+  Received received;
+  plaid::WebhookServer server(Options());
+  server.On("TRANSACTIONS", [&](const plaid::WebhookEvent &event) {
+    received.Typed(event);
+  });
+  server.On("", [&](const plaid::WebhookEvent &event) {
+    received.Any(event);
+  });
+  CHECK(server.Start().IsOk());
+  CHECK(server.Port() != 0);
+
+  // Twenty requests in one write, then five more on the same connection.
+  Connection conn(server.Port());
+  std::string batch;
+  for (int i = 0; i < 20; ++i)
+    batch += Post(Webhook("TRANSACTIONS", i));
+  conn.Send(batch);
+  for (int i = 0; i < 20; ++i)
+    CHECK(conn.Status() == 200);
+  for (int i = 20; i < 25; ++i) {
+    conn.Send(Post(Webhook("TRANSACTIONS", i)));
+    CHECK(conn.Status() == 200);
+  }
+  conn.Send(Post(Webhook("ITEM", 99)));
+  CHECK(conn.Status() == 200);
+
+  // Stop hands over everything already accepted before returning.
+  server.Stop();
+  CHECK(received.items == Items(0, 25));
+  CHECK(received.any.size() == 26);
+  CHECK(received.any.back() == "ITEM/item_99");
+  CHECK(server.Metrics().received == 26);
+  CHECK(server.Metrics().rejected == 0);
+}
+
+void TestRejections() {
+  plaid::WebhookServer server(Options());
+  CHECK(server.Start().IsOk());
+  const uint16_t port = server.Port();
+
+  // A wrong method or path is answered, and the connection kept.
+  {
+    Connection conn(port);
+    conn.Send("GET /hooks HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    CHECK(conn.Status() == 405);
+    conn.Send(Post(Webhook("ITEM", 1), "/elsewhere"));
+    CHECK(conn.Status() == 404);
+    conn.Send(Post("{not json"));
+    CHECK(conn.Status() == 400);
+    conn.Send(Post(Webhook("ITEM", 1)));
+    CHECK(conn.Status() == 200);
+  }
+  // Bodies that can't be taken in end the connection.
+  {
+    Connection conn(port);
+    conn.Send("POST /hooks HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+              "5\r\nhello\r\n0\r\n\r\n");
+    CHECK(conn.Status() == 411);
+    CHECK(conn.Closed());
+  }
+  {
+    Connection conn(port);
+    conn.Send(Post(std::string(2048, ' ')));
+    CHECK(conn.Status() == 413);
+    CHECK(conn.Closed());
+  }
+  {
+    Connection conn(port);
+    conn.Send("POST /hooks HTTP/1.1\r\nX-Padding: " +
+              std::string(20 * 1024, 'a'));
+    CHECK(conn.Status() == 431);
+    CHECK(conn.Closed());
+  }
+  {
+    Connection conn(port);
+    conn.Send("POST /hooks HTTP/1.1\r\nContent-Length: ten\r\n\r\n");
+    CHECK(conn.Status() == 400);
+    CHECK(conn.Closed());
+  }
+  server.Stop();
+  const plaid::WebhookMetrics m = server.Metrics();
+  CHECK(m.received == 1);
+  CHECK(m.rejected == 7);
+  CHECK(m.overloaded == 0);
+}
+
+void TestFullQueue() {
+  Received received;
+  received.hold = true;
+  plaid::WebhookServerOptions options = Options();
+  options.max_queued = 2;
+  plaid::WebhookServer server(options);
+  server.On("TRANSACTIONS", [&](const plaid::WebhookEvent &event) {
+    received.Typed(event);
+  });
+  CHECK(server.Start().IsOk());
+
+  // The first webhook holds up the handler, so the next two fill the
+  // queue and the one after that is turned away.
+  Connection conn(server.Port());
+  conn.Send(Post(Webhook("TRANSACTIONS", 0)));
+  CHECK(conn.Status() == 200);
+  received.WaitFor(1);
+  for (int i = 1; i < 3; ++i) {
+    conn.Send(Post(Webhook("TRANSACTIONS", i)));
+    CHECK(conn.Status() == 200);
+  }
+  conn.Send(Post(Webhook("TRANSACTIONS", 3)));
+  CHECK(conn.Status() == 503);
+  CHECK(server.Metrics().overloaded == 1);
+
+  received.Release();
+  received.WaitFor(3);
+  // With room again, the retry goes through.
+  conn.Send(Post(Webhook("TRANSACTIONS", 3)));
+  CHECK(conn.Status() == 200);
+  server.Stop();
+  CHECK(received.items == Items(0, 4));
+}
+
+void TestStopClosesConnections() {
+  plaid::WebhookServer server(Options());
+  CHECK(server.Start().IsOk());
+  const uint16_t port = server.Port();
+  Connection idle(port);
+  idle.Send(Post(Webhook("ITEM", 1)));
+  CHECK(idle.Status() == 200);
+
+  const auto start = std::chrono::steady_clock::now();
+  server.Stop();
+  CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(2));
+  CHECK(idle.Closed());
+  // Stopping again, and the destructor after that, do nothing.
+  server.Stop();
+}
+
+} // namespace
+
+int main() {
+  TestPipelinedInOrder();
+  TestRejections();
+  TestFullQueue();
+  TestStopClosesConnections();
+  return 0;
+}
\ No newline at end of file